@@ -0,0 +1,72 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <string.h>
+
+#include "Bench.h"
+#include "../common/MappingUtil.h"
+
+static const int32 kFiles = 10000;
+
+// what gets resolved per book: its attribute names one way and the result fields the other way
+static const char* kLookups[] = {
+    "Book:ISBN", "Book:Authors", "Book:Languages", "Book:Publisher", "Book:Subjects", "Book:Year",
+    "Media:Title", "OPENLIB:cover_key", "Book:Rating", "BEOS:TYPE", "be:encoding", "_trk/pinfo_le",
+    "SEN:_id", "isbn", "title", "author_name", "author_key", "publisher", "language", "subject",
+    "publish_year", "cover_i", "key", "edition_count", "ia", "first_sentence"
+};
+
+static const int32 kLookupCount = sizeof(kLookups) / sizeof(kLookups[0]);
+
+static bool SameValue(const char* a, const char* b)
+{
+    return a == b || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+/**
+* resolves the attribute names and result fields of @kFiles books with the mapper as it was
+* before, a lookup in a BMessage, and with the mapper frozen into an AliasTable.
+*/
+status_t BenchAliases(const bench_options& options)
+{
+    // an uncompiled mapper still looks up in its BMessage, like every mapper did before
+    MappingUtil reference;
+    MappingUtil compiled;
+    reference.AddAliases(kBookMappingProfile, MAPPING_PROFILE_SIZE(kBookMappingProfile));
+    compiled.AddAliases(kBookMappingProfile, MAPPING_PROFILE_SIZE(kBookMappingProfile));
+
+    status_t result = compiled.Compile();
+    if (result != B_OK) {
+        return result;
+    }
+
+    for (int32 i = 0; i < kLookupCount; i++) {
+        result = BenchCheck(SameValue(reference.ResolveAlias(kLookups[i]), compiled.ResolveAlias(kLookups[i])),
+            kLookups[i]);
+        if (result != B_OK) {
+            return result;
+        }
+    }
+
+    int32 files = kFiles * options.scale;
+    int64 lookups = (int64)files * kLookupCount;
+
+    double before = BenchRun("BMessage", lookups, [&]() {
+        for (int32 file = 0; file < files; file++) {
+            for (int32 i = 0; i < kLookupCount; i++) {
+                BenchKeep(reference.ResolveAlias(kLookups[i]));
+            }
+        }
+    });
+    double after = BenchRun("AliasTable", lookups, [&]() {
+        for (int32 file = 0; file < files; file++) {
+            for (int32 i = 0; i < kLookupCount; i++) {
+                BenchKeep(compiled.ResolveAlias(kLookups[i]));
+            }
+        }
+    });
+    BenchCompare("speedup", before, after);
+
+    return B_OK;
+}
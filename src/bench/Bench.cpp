@@ -0,0 +1,78 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <File.h>
+#include <OS.h>
+#include <String.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "Bench.h"
+
+// the best of these runs is reported, the others mostly measure the scheduler
+static const int32 kRuns = 3;
+
+static const void* volatile sKept;
+
+double BenchRun(const char* label, int64 operations, const std::function<void()>& batch)
+{
+    batch();
+
+    bigtime_t best = B_INFINITE_TIMEOUT;
+    for (int32 i = 0; i < kRuns; i++) {
+        bigtime_t start = system_time();
+        batch();
+        best = std::min(best, system_time() - start);
+    }
+
+    double perOperation = operations > 0 ? best * 1000.0 / operations : 0;
+    printf("  %-40s %12.1f ns/op  (%" B_PRId64 " ops in %.1f ms)\n", label, perOperation,
+        operations, best / 1000.0);
+    return perOperation;
+}
+
+void BenchCompare(const char* what, double before, double after)
+{
+    if (after > 0) {
+        printf("  %-40s %12.2fx\n", what, before / after);
+    }
+}
+
+void BenchKeep(const void* value)
+{
+    sKept = value;
+}
+
+status_t BenchCheck(bool condition, const char* what)
+{
+    if (!condition) {
+        printf("  MISMATCH: %s\n", what);
+        return B_ERROR;
+    }
+    return B_OK;
+}
+
+status_t BenchReadFixture(const bench_options& options, const char* name, std::string* data)
+{
+    BString path(options.fixtures);
+    path << "/" << name;
+
+    BFile file(path.String(), B_READ_ONLY);
+    off_t size;
+    status_t result = file.InitCheck();
+    if (result == B_OK) {
+        result = file.GetSize(&size);
+    }
+    if (result == B_OK) {
+        data->resize(size);
+        ssize_t bytesRead = file.ReadAt(0, &(*data)[0], size);
+        result = bytesRead == size ? B_OK : (bytesRead < 0 ? bytesRead : B_IO_ERROR);
+    }
+    if (result != B_OK) {
+        fprintf(stderr, "  could not read fixture %s: %s\n", path.String(), strerror(result));
+    }
+    return result;
+}
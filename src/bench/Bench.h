@@ -0,0 +1,43 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+
+#include <functional>
+#include <string>
+
+/**
+* options shared by all benchmarks, see main.cpp.
+*/
+struct bench_options {
+    int32       scale;      // multiplies the default amount of work
+    const char* fixtures;   // directory with recorded service responses
+};
+
+typedef status_t (*bench_func)(const bench_options& options);
+
+/**
+* runs @batch once to warm up and then a few more times, and prints the best time per
+* operation, with @operations being the number of operations one call of @batch performs.
+* Returns the time per operation in nanoseconds, for BenchCompare().
+*/
+double      BenchRun(const char* label, int64 operations, const std::function<void()>& batch);
+// prints how much faster @after is than @before
+void        BenchCompare(const char* what, double before, double after);
+// keeps the compiler from dropping results nobody looks at
+void        BenchKeep(const void* value);
+// both implementations have to agree before they are compared, prints @what if not
+status_t    BenchCheck(bool condition, const char* what);
+// reads the recorded response @name from the fixtures directory
+status_t    BenchReadFixture(const bench_options& options, const char* name, std::string* data);
+
+// the benchmarks, each compares a current implementation with the one it replaced
+status_t    BenchAliases(const bench_options& options);
+status_t    BenchPrefixes(const bench_options& options);
+status_t    BenchSession(const bench_options& options);
+status_t    BenchJson(const bench_options& options);
+status_t    BenchUrls(const bench_options& options);
+status_t    BenchMapping(const bench_options& options);
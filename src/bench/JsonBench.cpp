@@ -0,0 +1,185 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <private/shared/Json.h>
+
+#include <set>
+#include <string>
+
+#include "Bench.h"
+#include "../common/MappingProfiles.h"
+#include "../enrichment/JsonDecoder.h"
+#include "../enrichment/books/App.h"
+#include "../enrichment/books/CandidateRanker.h"
+
+static const int32 kDecodes = 200;
+
+// the fields bert asks for in a search, see App::BuildProjections()
+static std::set<std::string> SearchFields()
+{
+    std::set<std::string> fields;
+    for (size_t i = 0; i < MAPPING_PROFILE_SIZE(kBookMappingProfile); i++) {
+        fields.insert(kBookMappingProfile[i].alias);
+    }
+    for (int32 i = 0; i < CandidateRanker::CountFields(); i++) {
+        fields.insert(CandidateRanker::FieldAt(i));
+    }
+    return fields;
+}
+
+static status_t CopyField(const BMessage& source, const char* name, BMessage* target)
+{
+    type_code type;
+    int32 count;
+    status_t result = source.GetInfo(name, &type, &count);
+
+    for (int32 i = 0; result == B_OK && i < count; i++) {
+        if (type == B_MESSAGE_TYPE) {
+            BMessage value;
+            result = source.FindMessage(name, i, &value);
+            if (result == B_OK) {
+                result = target->AddMessage(name, &value);
+            }
+        } else {
+            const void* data;
+            ssize_t size;
+            result = source.FindData(name, type, i, &data, &size);
+            if (result == B_OK) {
+                result = target->AddData(name, type, data, size, type != B_STRING_TYPE);
+            }
+        }
+    }
+    return result;
+}
+
+/**
+* what the projected decode has to produce, cut out of the complete message: num_found and
+* the selected @fields of the first @maxDocs docs.
+*/
+static status_t Prune(const BMessage& message, const std::set<std::string>& fields, int32 maxDocs,
+    BMessage* pruned)
+{
+    BMessage docs;
+    BMessage prunedDocs;
+    status_t result = CopyField(message, "num_found", pruned);
+    if (result == B_OK) {
+        result = message.FindMessage("docs", &docs);
+    }
+
+    char index[16];
+    for (int32 i = 0; result == B_OK && i < maxDocs; i++) {
+        snprintf(index, sizeof(index), "%" B_PRId32, i);
+        BMessage doc;
+        if (docs.FindMessage(index, &doc) != B_OK) {
+            break;
+        }
+
+        BMessage prunedDoc;
+        char* name;
+        type_code type;
+        for (int32 field = 0; result == B_OK
+                && doc.GetInfo(B_ANY_TYPE, field, &name, &type) == B_OK; field++) {
+            if (fields.find(name) != fields.end()) {
+                result = CopyField(doc, name, &prunedDoc);
+            }
+        }
+        if (result == B_OK) {
+            result = prunedDocs.AddMessage(index, &prunedDoc);
+        }
+    }
+    if (result == B_OK) {
+        result = pruned->AddMessage("docs", &prunedDocs);
+    }
+    return result;
+}
+
+/**
+* decodes a recorded search response with BJson::Parse(), as all enrichers did before, and with
+* the JsonDecoder, once completely and once with bert's projection. The fixture has no nulls,
+* which BJson keeps and the decoder drops.
+*/
+status_t BenchJson(const bench_options& options)
+{
+    std::string json;
+    status_t result = BenchReadFixture(options, "search.json", &json);
+    if (result != B_OK) {
+        return result;
+    }
+
+    std::set<std::string> fields = SearchFields();
+    JsonProjection projection;
+    projection.AddPath("num_found");
+    projection.SetMaxItems("docs", MAX_SEARCH_RESULTS);
+    for (std::set<std::string>::const_iterator it = fields.begin(); it != fields.end(); ++it) {
+        projection.AddPath(("docs/*/" + *it).c_str());
+    }
+
+    BMessage reference;
+    result = BJson::Parse(json.c_str(), json.size(), reference);
+    if (result != B_OK) {
+        fprintf(stderr, "  could not parse search.json: %s\n", strerror(result));
+        return result;
+    }
+
+    JsonDecoder fullDecoder;
+    BMessage full;
+    result = fullDecoder.Decode(json.data(), json.size(), &full);
+    if (result == B_OK) {
+        result = BenchCheck(full.HasSameData(reference, true, true), "complete decode differs from BJson");
+    }
+
+    JsonDecoder projectedDecoder(&projection);
+    BMessage projected;
+    BMessage expected;
+    if (result == B_OK) {
+        result = projectedDecoder.Decode(json.data(), json.size(), &projected);
+    }
+    if (result == B_OK) {
+        result = Prune(reference, fields, MAX_SEARCH_RESULTS, &expected);
+    }
+    if (result == B_OK) {
+        result = BenchCheck(projected.HasSameData(expected, true, true),
+            "projected decode differs from the pruned BJson message");
+    }
+    // the docs past MAX_SEARCH_RESULTS and the unselected fields have to be skipped, not decoded
+    if (result == B_OK) {
+        result = BenchCheck(projectedDecoder.SkippedBytes() > 0 && fullDecoder.SkippedBytes() == 0,
+            "skipped bytes");
+    }
+    if (result != B_OK) {
+        return result;
+    }
+
+    int32 decodes = kDecodes * options.scale;
+    printf("  %-40s %12zu bytes, %zu skipped by the projection\n", "search.json", json.size(),
+        projectedDecoder.SkippedBytes());
+
+    double before = BenchRun("BJson::Parse", decodes, [&]() {
+        for (int32 i = 0; i < decodes; i++) {
+            BMessage message;
+            BJson::Parse(json.c_str(), json.size(), message);
+            BenchKeep(&message);
+        }
+    });
+    double complete = BenchRun("JsonDecoder, complete", decodes, [&]() {
+        for (int32 i = 0; i < decodes; i++) {
+            BMessage message;
+            fullDecoder.Decode(json.data(), json.size(), &message);
+            BenchKeep(&message);
+        }
+    });
+    double after = BenchRun("JsonDecoder, projected", decodes, [&]() {
+        for (int32 i = 0; i < decodes; i++) {
+            BMessage message;
+            projectedDecoder.Decode(json.data(), json.size(), &message);
+            BenchKeep(&message);
+        }
+    });
+    BenchCompare("complete decode", before, complete);
+    BenchCompare("projected decode", before, after);
+    return B_OK;
+}
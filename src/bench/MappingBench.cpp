@@ -0,0 +1,275 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../common/FlatMessage.h"
+#include "../common/MappingProfiles.h"
+#include "../common/MappingUtil.h"
+#include "../common/TypeConverter.h"
+#include "../enrichment/JsonDecoder.h"
+#include "../enrichment/MappingPlan.h"
+#include "../enrichment/books/App.h"
+
+static const int32 kMappings = 20000;
+
+/**
+* the mapping of service results to attributes as it was before MappingPlan, kept as reference:
+* arrays are first flattened into multi-valued fields of a temporary message, which is then
+* mapped field by field with alias lookups. Logging and metrics are left out.
+*/
+class OldMappingChain {
+
+public:
+    OldMappingChain(const MappingUtil* mapper, const char* mimeType)
+        : fMapper(mapper), fMimeType(mimeType) {}
+
+    status_t MapResultToAttrs(const BMessage* result, BMessage* attrs)
+    {
+        BMessage converted;
+        status_t status = ConvertMessageMapsToArray(result, &converted);
+        if (status == B_OK) {
+            status = MapServiceParamsToAttrs(&converted, attrs);
+        }
+        return status;
+    }
+
+private:
+    status_t MapServiceParamsToAttrs(const BMessage *serviceParamMsg, BMessage *attrMsg);
+    static status_t ConvertMessageMapsToArray(const BMessage* srcMessage, BMessage* resultMsg);
+    static status_t ConvertSingleMessageMapToArray(const BMessage* msg, const char* originalKey,
+                        BMessage* resultMsg);
+    static status_t ConvertFlatMessageToArray(const FlatMessage& msg, const char* originalKey,
+                        BMessage* resultMsg);
+
+    const MappingUtil*  fMapper;
+    BString             fMimeType;
+};
+
+status_t OldMappingChain::MapServiceParamsToAttrs(const BMessage *serviceParamMsg, BMessage *attrMsg)
+{
+    std::shared_ptr<const MimeSchema> mimeAttrs;
+    status_t result = MappingUtil::GetMimeTypeSchema(fMimeType.String(), mimeAttrs);
+    if (result != B_OK) {
+        return result;
+    }
+
+    char*       paramName;
+    type_code   type, attrType;
+    int32       count;
+
+    for (int32 i = 0; i < serviceParamMsg->CountNames(B_ANY_TYPE); i++) {
+        result = serviceParamMsg->GetInfo(B_ANY_TYPE, i, &paramName, &type, &count);
+        if (result != B_OK || type == B_MESSAGE_TYPE) {
+            continue;
+        }
+
+        const char* key = fMapper->ResolveAlias(paramName);
+        if (key == NULL) {
+            continue;
+        }
+
+        attrType = mimeAttrs->TypeOf(key, B_STRING_TYPE);
+        TypeConverter::convert_func convert = TypeConverter::Find(type, attrType);
+        if (convert != NULL) {
+            result = convert(serviceParamMsg, paramName, count, attrMsg, key);
+        } else if (type == attrType) {
+            result = TypeConverter::Convert(serviceParamMsg, paramName, attrType, attrMsg, key);
+        }
+    }
+    return B_OK;
+}
+
+status_t OldMappingChain::ConvertMessageMapsToArray(const BMessage* srcMessage, BMessage* resultMsg)
+{
+    status_t    result;
+
+    char*       key;
+    uint32      type;
+    int32       count;
+    const void* data;
+    ssize_t     dataSize;
+
+    BMessage    valueMapMsg;
+
+    for (int i = 0; i < srcMessage->CountNames(B_ANY_TYPE); i++) {
+        result = srcMessage->GetInfo(B_ANY_TYPE, i, &key, &type, &count);
+        if (result != B_OK) {
+            return result;
+        }
+
+        for (int32 index = 0; index < count; index++) {
+            result = srcMessage->FindData(key, type, index, &data, &dataSize);
+            if (result != B_OK) {
+                return result;
+            }
+
+            if (type == B_MESSAGE_TYPE) {
+                FlatMessage valueMap(data, dataSize);
+                if (valueMap.InitCheck() == B_OK) {
+                    if (valueMap.IsArray()) {
+                        result = ConvertFlatMessageToArray(valueMap, key, resultMsg);
+                        if (result != B_OK) {
+                            return result;
+                        }
+                        continue;
+                    }
+                } else if (valueMapMsg.Unflatten(reinterpret_cast<const char*>(data)) == B_OK
+                    && FlatMessage::IsArray(&valueMapMsg)) {
+                    result = ConvertSingleMessageMapToArray(&valueMapMsg, key, resultMsg);
+                    if (result != B_OK) {
+                        return result;
+                    }
+                    continue;
+                }
+            }
+
+            resultMsg->AddData(key, type, data, dataSize, false);
+        }
+    }
+    return B_OK;
+}
+
+status_t OldMappingChain::ConvertSingleMessageMapToArray(const BMessage* msg, const char* originalKey,
+    BMessage* resultMsg)
+{
+    char*       mapKey;
+    uint32      type;
+    const void* data;
+    ssize_t     dataSize;
+    int32       count;
+    status_t    result;
+
+    for (int i = 0; i < msg->CountNames(B_ANY_TYPE); i++) {
+        result = msg->GetInfo(B_ANY_TYPE, i, &mapKey, &type, &count);
+        if (result != B_OK) {
+            return result;
+        }
+        if (!FlatMessage::IsArrayIndex(mapKey, i)) {
+            return B_BAD_VALUE;
+        }
+
+        result = msg->FindData(mapKey, type, &data, &dataSize);
+        if (result == B_OK) {
+            result = resultMsg->AddData(originalKey, type, data, dataSize, false);
+        }
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
+
+status_t OldMappingChain::ConvertFlatMessageToArray(const FlatMessage& msg, const char* originalKey,
+    BMessage* resultMsg)
+{
+    const char* mapKey;
+    type_code   type;
+    int32       count;
+    const void* data;
+    ssize_t     dataSize;
+    status_t    result;
+
+    for (int32 i = 0; i < msg.CountFields(); i++) {
+        result = msg.GetFieldAt(i, &mapKey, &type, &count);
+        if (result == B_OK) {
+            result = msg.FindDataAt(i, 0, &data, &dataSize);
+        }
+        if (result == B_OK) {
+            result = resultMsg->AddData(originalKey, type, data, dataSize, false);
+        }
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
+
+/**
+* maps the docs of the recorded search response to book attributes, @kMappings times in all,
+* with the chain of array conversion and per-field mapping used before, and with the MappingPlan.
+*/
+status_t BenchMapping(const bench_options& options)
+{
+    std::string json;
+    status_t result = BenchReadFixture(options, "search.json", &json);
+    if (result != B_OK) {
+        return result;
+    }
+
+    JsonDecoder decoder;
+    BMessage response;
+    BMessage docs;
+    result = decoder.Decode(json.data(), json.size(), &response);
+    if (result == B_OK) {
+        result = response.FindMessage("docs", &docs);
+    }
+
+    std::vector<BMessage> results;
+    char index[16];
+    for (int32 i = 0; result == B_OK; i++) {
+        snprintf(index, sizeof(index), "%" B_PRId32, i);
+        BMessage doc;
+        if (docs.FindMessage(index, &doc) != B_OK) {
+            break;
+        }
+        results.push_back(doc);
+    }
+    if (result != B_OK || results.empty()) {
+        fprintf(stderr, "  no docs in search.json\n");
+        return result != B_OK ? result : B_BAD_DATA;
+    }
+
+    MappingUtil mapper;
+    mapper.AddAliases(kBookMappingProfile, MAPPING_PROFILE_SIZE(kBookMappingProfile));
+    result = mapper.Compile();
+
+    std::shared_ptr<const MappingPlan> plan;
+    if (result == B_OK) {
+        result = MappingPlan::Get(&mapper, BOOK_MIME_TYPE, plan);
+    }
+    if (result != B_OK) {
+        return result;
+    }
+    OldMappingChain reference(&mapper, BOOK_MIME_TYPE);
+
+    for (size_t i = 0; i < results.size() && result == B_OK; i++) {
+        BMessage before;
+        BMessage after;
+        result = reference.MapResultToAttrs(&results[i], &before);
+        if (result == B_OK) {
+            result = plan->MapResultToAttrs(&results[i], &after);
+        }
+        if (result == B_OK) {
+            result = BenchCheck(!after.IsEmpty() && after.HasSameData(before, true, true),
+                results[i].GetString("key", "doc"));
+        }
+    }
+    if (result != B_OK) {
+        return result;
+    }
+
+    int32 mappings = kMappings * options.scale;
+    double before = BenchRun("array conversion + mapping", mappings, [&]() {
+        for (int32 i = 0; i < mappings; i++) {
+            BMessage attrs;
+            reference.MapResultToAttrs(&results[i % results.size()], &attrs);
+            BenchKeep(&attrs);
+        }
+    });
+    double after = BenchRun("MappingPlan", mappings, [&]() {
+        for (int32 i = 0; i < mappings; i++) {
+            BMessage attrs;
+            plan->MapResultToAttrs(&results[i % results.size()], &attrs);
+            BenchKeep(&attrs);
+        }
+    });
+    BenchCompare("speedup", before, after);
+    return B_OK;
+}
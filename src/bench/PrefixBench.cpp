@@ -0,0 +1,76 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <String.h>
+
+#include "Bench.h"
+#include "../common/MappingUtil.h"
+
+static const int32 kNodes = 10000;
+
+// the attributes of a typical book, PDF and source file together
+static const char* kAttrNames[] = {
+    "BEOS:TYPE", "BEOS:PREF_APP", "be:encoding", "be:line", "_trk/pinfo_le", "_trk/qrylastchange",
+    "META:name", "META:email", "Media:Thumbnail", "Media:Thumbnail:CreationTime", "Media:Title",
+    "Book:ISBN", "Book:Authors", "Book:Publisher", "Book:Year", "Book:Subjects", "OPENLIB:cover_key",
+    "bepdf:page", "PDF:Title", "pe-info", "StyledEdit-info", "SEN:_id", "SEN:TAGS",
+    "SEN:REL:docref:page", "Audio:Artist", "Audio:Album", "IMAP:status", "MAIL:subject"
+};
+
+static const int32 kAttrCount = sizeof(kAttrNames) / sizeof(kAttrNames[0]);
+
+// MappingUtil::IsInternalAttr() as it was before the PrefixTable
+static bool IsInternalAttrReference(const char* attrName)
+{
+    BString name(attrName);
+
+    return name.StartsWith("be:") ||
+           name.StartsWith("BEOS:") ||
+           name.StartsWith("META:") ||
+           name.StartsWith("_trk/") ||
+           name.StartsWith("Media:Thumbnail") ||
+           // application specific metadata
+           name.StartsWith("bepdf:") ||
+           name.StartsWith("pe-info") ||
+           name.StartsWith("PDF:") ||
+           name.StartsWith("StyledEdit");
+}
+
+/**
+* classifies the attributes of @kNodes nodes with the StartsWith() chain it replaced and with
+* the compile time PrefixTable behind MappingUtil::IsInternalAttr().
+*/
+status_t BenchPrefixes(const bench_options& options)
+{
+    for (int32 i = 0; i < kAttrCount; i++) {
+        status_t result = BenchCheck(IsInternalAttrReference(kAttrNames[i])
+            == MappingUtil::IsInternalAttr(kAttrNames[i]), kAttrNames[i]);
+        if (result != B_OK) {
+            return result;
+        }
+    }
+
+    int32 nodes = kNodes * options.scale;
+    int64 names = (int64)nodes * kAttrCount;
+    int32 internal = 0;
+
+    double before = BenchRun("BString::StartsWith()", names, [&]() {
+        for (int32 node = 0; node < nodes; node++) {
+            for (int32 i = 0; i < kAttrCount; i++) {
+                internal += IsInternalAttrReference(kAttrNames[i]);
+            }
+        }
+    });
+    double after = BenchRun("PrefixTable", names, [&]() {
+        for (int32 node = 0; node < nodes; node++) {
+            for (int32 i = 0; i < kAttrCount; i++) {
+                internal += MappingUtil::IsInternalAttr(kAttrNames[i]);
+            }
+        }
+    });
+    BenchCompare("speedup", before, after);
+    BenchKeep(&internal);
+
+    return B_OK;
+}
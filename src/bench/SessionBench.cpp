@@ -0,0 +1,121 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <private/netservices2/HttpRequest.h>
+#include <private/netservices2/HttpResult.h>
+#include <private/netservices2/NetServicesDefs.h>
+
+#include "Bench.h"
+#include "StandInServer.h"
+#include "../enrichment/HttpBody.h"
+#include "../enrichment/HttpSessionPool.h"
+
+static const int32 kRequests = 200;
+static const int32 kDocs = 20;
+
+// a search response of the size OpenLibrary sends for a title search, compresses like one too
+static std::string BuildSearchResponse()
+{
+    std::string body = "{\"numFound\": 20, \"start\": 0, \"docs\": [";
+    char doc[512];
+    for (int32 i = 0; i < kDocs; i++) {
+        snprintf(doc, sizeof(doc), "%s{\"key\": \"/works/OL%dW\", \"title\": \"The Dispossessed, part %d\", "
+            "\"author_name\": [\"Ursula K. Le Guin\"], \"author_key\": [\"OL%dA\"], "
+            "\"publisher\": [\"Harper & Row\", \"Avon Books\", \"Gollancz\"], \"language\": [\"eng\", \"ger\"], "
+            "\"subject\": [\"Science fiction\", \"Utopias\", \"Anarchism\", \"Physicists\", \"Fiction\"], "
+            "\"publish_year\": [1974, 1975, 1999], \"cover_i\": %d, \"edition_count\": %d}",
+            i > 0 ? ", " : "", 1000 + i, i, 2000 + i, 3000 + i, 10 + i);
+        body += doc;
+    }
+    body += "]}";
+    return body;
+}
+
+static status_t Fetch(BHttpSession& session, const BUrl& url, const BHttpFields& fields, HttpBody* body)
+{
+    auto request = BHttpRequest(url);
+    request.SetFields(fields);
+
+    BHttpResult result = session.Execute(std::move(request), BBorrow<BDataIO>(body->Receiver()));
+    try {
+        if (result.Status().code != 200) {
+            return B_ERROR;
+        }
+        result.Body();  // synchronize with BBorrow buffer (see HttpSession::Execute docs)
+    } catch (const BNetworkRequestError& error) {
+        return error.ErrorCode();
+    }
+    return body->FinishReceive();
+}
+
+/**
+* fetches a search response from a server on the loopback interface @kRequests times, once with
+* a new BHttpSession per request as the enrichers did before, and once with the shared session
+* of the HttpSessionPool, and reports how many connections each needed.
+*/
+status_t BenchSession(const bench_options& options)
+{
+    std::string expected = BuildSearchResponse();
+    StandInServer server(expected);
+
+    status_t result = server.Start();
+    if (result != B_OK) {
+        fprintf(stderr, "  could not start the stand-in server: %s\n", strerror(result));
+        return result;
+    }
+
+    char address[64];
+    snprintf(address, sizeof(address), "http://127.0.0.1:%u/search.json?q=dispossessed", server.Port());
+    BUrl url(address, true);
+    BHttpFields fields = HttpSessionPool::Default()->FieldsFor(HTTP_CACHE_QUERY);
+
+    // the session asks for gzip and has to hand back what the server compressed, unchanged
+    HttpBody body;
+    result = Fetch(HttpSessionPool::Default()->Session(), url, fields, &body);
+    if (result == B_OK) {
+        result = BenchCheck(server.CountCompressed() == 1, "response was not compressed");
+    }
+    if (result == B_OK) {
+        result = BenchCheck(body.Size() == expected.size()
+            && memcmp(body.Data(), expected.data(), expected.size()) == 0, "decompressed body");
+    }
+    if (result != B_OK) {
+        return result;
+    }
+
+    int32 requests = kRequests * options.scale;
+    status_t fetchResult = B_OK;
+
+    int32 connections = server.CountConnections();
+    int32 served = server.CountRequests();
+    double before = BenchRun("session per request", requests, [&]() {
+        for (int32 i = 0; i < requests && fetchResult == B_OK; i++) {
+            BHttpSession session;
+            fetchResult = Fetch(session, url, fields, &body);
+        }
+    });
+    printf("  %-40s %12.2f connections/request\n", "",
+        (double)(server.CountConnections() - connections) / (server.CountRequests() - served));
+
+    connections = server.CountConnections();
+    served = server.CountRequests();
+    double after = BenchRun("shared session", requests, [&]() {
+        for (int32 i = 0; i < requests && fetchResult == B_OK; i++) {
+            fetchResult = Fetch(HttpSessionPool::Default()->Session(), url, fields, &body);
+        }
+    });
+    printf("  %-40s %12.2f connections/request\n", "",
+        (double)(server.CountConnections() - connections) / (server.CountRequests() - served));
+
+    if (fetchResult != B_OK) {
+        fprintf(stderr, "  request failed: %s\n", strerror(fetchResult));
+        return fetchResult;
+    }
+    printf("  %-40s %12.0f vs. %.0f requests/s\n", "", 1e9 / before, 1e9 / after);
+    BenchCompare("shared session", before, after);
+    return B_OK;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "StandInServer.h"
+
+static const size_t kReadSize = 4096;
+
+// gzip as sent by web servers, zlib's deflate with a gzip header
+static status_t Compress(const std::string& data, std::string* compressed)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return B_ERROR;
+    }
+
+    compressed->resize(deflateBound(&stream, data.size()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&(*compressed)[0]);
+    stream.avail_out = compressed->size();
+
+    int result = deflate(&stream, Z_FINISH);
+    compressed->resize(stream.total_out);
+    deflateEnd(&stream);
+
+    return result == Z_STREAM_END ? B_OK : B_ERROR;
+}
+
+static bool HasHeaderValue(const std::string& header, const char* name, const char* value)
+{
+    size_t pos = 0;
+    size_t nameLength = strlen(name);
+
+    while ((pos = header.find("\r\n", pos)) != std::string::npos) {
+        pos += 2;
+        if (strncasecmp(header.c_str() + pos, name, nameLength) != 0 || header[pos + nameLength] != ':') {
+            continue;
+        }
+        size_t end = header.find("\r\n", pos);
+        std::string line = header.substr(pos + nameLength + 1, end - pos - nameLength - 1);
+        return strcasestr(line.c_str(), value) != NULL;
+    }
+    return false;
+}
+
+StandInServer::StandInServer(const std::string& body)
+    :
+    fBody(body),
+    fSocket(-1),
+    fPort(0),
+    fAcceptThread(-1),
+    fConnections(0),
+    fRequests(0),
+    fCompressed(0),
+    fLock("stand-in server")
+{
+}
+
+StandInServer::~StandInServer()
+{
+    Stop();
+}
+
+status_t StandInServer::Start()
+{
+    status_t result = Compress(fBody, &fCompressedBody);
+    if (result != B_OK) {
+        return result;
+    }
+
+    fSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (fSocket < 0) {
+        return errno;
+    }
+
+    // any free port on the loopback interface
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    socklen_t length = sizeof(address);
+    if (bind(fSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(fSocket, 16) != 0
+        || getsockname(fSocket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        result = errno;
+        Stop();
+        return result;
+    }
+    fPort = ntohs(address.sin_port);
+
+    fAcceptThread = spawn_thread(AcceptThread, "stand-in server", B_NORMAL_PRIORITY, this);
+    if (fAcceptThread < 0) {
+        result = fAcceptThread;
+        Stop();
+        return result;
+    }
+    return resume_thread(fAcceptThread);
+}
+
+void StandInServer::Stop()
+{
+    if (fSocket >= 0) {
+        shutdown(fSocket, SHUT_RDWR);
+        close(fSocket);
+        fSocket = -1;
+    }
+    if (fAcceptThread >= 0) {
+        status_t exitValue;
+        wait_for_thread(fAcceptThread, &exitValue);
+        fAcceptThread = -1;
+    }
+
+    std::vector<thread_id> threads;
+    {
+        BAutolock locker(fLock);
+        for (size_t i = 0; i < fSockets.size(); i++) {
+            shutdown(fSockets[i], SHUT_RDWR);
+        }
+        threads.swap(fThreads);
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        status_t exitValue;
+        wait_for_thread(threads[i], &exitValue);
+    }
+}
+
+status_t StandInServer::AcceptThread(void* data)
+{
+    StandInServer* server = static_cast<StandInServer*>(data);
+
+    for (;;) {
+        int socket = accept(server->fSocket, NULL, NULL);
+        if (socket < 0) {
+            return B_OK;    // closed by Stop()
+        }
+        atomic_add(&server->fConnections, 1);
+
+        Connection* connection = new Connection;
+        connection->server = server;
+        connection->socket = socket;
+
+        thread_id thread = spawn_thread(ConnectionThread, "stand-in connection", B_NORMAL_PRIORITY,
+            connection);
+        if (thread < 0) {
+            close(socket);
+            delete connection;
+            continue;
+        }
+
+        BAutolock locker(server->fLock);
+        server->fSockets.push_back(socket);
+        server->fThreads.push_back(thread);
+        resume_thread(thread);
+    }
+}
+
+status_t StandInServer::ConnectionThread(void* data)
+{
+    Connection* connection = static_cast<Connection*>(data);
+    StandInServer* server = connection->server;
+    int socket = connection->socket;
+    delete connection;
+
+    server->Serve(socket);
+
+    BAutolock locker(server->fLock);
+    for (size_t i = 0; i < server->fSockets.size(); i++) {
+        if (server->fSockets[i] == socket) {
+            server->fSockets.erase(server->fSockets.begin() + i);
+            break;
+        }
+    }
+    close(socket);
+    return B_OK;
+}
+
+void StandInServer::Serve(int socket)
+{
+    std::string received;
+    char buffer[kReadSize];
+
+    for (;;) {
+        size_t end = received.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            ssize_t bytesRead = recv(socket, buffer, sizeof(buffer), 0);
+            if (bytesRead <= 0) {
+                return;
+            }
+            received.append(buffer, bytesRead);
+            continue;
+        }
+
+        // requests have no body, the header is all there is
+        std::string header = received.substr(0, end + 2);
+        received.erase(0, end + 4);
+        atomic_add(&fRequests, 1);
+
+        if (SendResponse(socket, HasHeaderValue(header, "Accept-Encoding", "gzip")) != B_OK
+            || HasHeaderValue(header, "Connection", "close")) {
+            return;
+        }
+    }
+}
+
+status_t StandInServer::SendResponse(int socket, bool compressed)
+{
+    const std::string& body = compressed ? fCompressedBody : fBody;
+    if (compressed) {
+        atomic_add(&fCompressed, 1);
+    }
+
+    char header[256];
+    int length = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: %zu\r\n"
+        "%s"
+        "\r\n", body.size(), compressed ? "Content-Encoding: gzip\r\n" : "");
+
+    std::string response(header, length);
+    response += body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t bytesSent = send(socket, response.data() + sent, response.size() - sent, 0);
+        if (bytesSent <= 0) {
+            return B_IO_ERROR;
+        }
+        sent += bytesSent;
+    }
+    return B_OK;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <string>
+#include <vector>
+
+/**
+* minimal HTTP/1.1 server on the loopback interface standing in for the web services.
+* Every request gets the same body, gzip compressed if the client accepts it, and connections
+* are kept alive until the client closes them, so connection reuse can be counted.
+*/
+class StandInServer {
+
+public:
+    StandInServer(const std::string& body);
+    ~StandInServer();
+
+    status_t    Start();
+    void        Stop();
+
+    uint16      Port() const { return fPort; }
+    int32       CountConnections() const { return atomic_get(const_cast<int32*>(&fConnections)); }
+    int32       CountRequests() const { return atomic_get(const_cast<int32*>(&fRequests)); }
+    // requests answered with the gzip compressed body
+    int32       CountCompressed() const { return atomic_get(const_cast<int32*>(&fCompressed)); }
+
+private:
+    struct Connection {
+        StandInServer*  server;
+        int             socket;
+    };
+
+    static status_t AcceptThread(void* data);
+    static status_t ConnectionThread(void* data);
+
+    void        Serve(int socket);
+    status_t    SendResponse(int socket, bool compressed);
+
+    std::string             fBody;
+    std::string             fCompressedBody;
+
+    int                     fSocket;
+    uint16                  fPort;
+    thread_id               fAcceptThread;
+    int32                   fConnections;
+    int32                   fRequests;
+    int32                   fCompressed;
+
+    // open connections, closed on Stop() so their threads return
+    BLocker                 fLock;
+    std::vector<int>        fSockets;
+    std::vector<thread_id>  fThreads;
+};
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../enrichment/UrlTemplate.h"
+#include "../enrichment/books/App.h"
+
+static const int32 kUrls = 1000000;
+// distinct covers and photos, the parameters are built up front like bert does per book
+static const int32 kIds = 1000;
+
+/**
+* CreateHttpApiUrl() as it was before UrlTemplate, kept as reference: every placeholder is
+* replaced in the whole pattern with BString::ReplaceAll() on each call.
+*/
+static status_t ReplacePlaceholders(const char* apiUrlPattern, const BMessage* apiParamMapping, BString* resultStr)
+{
+    *resultStr = apiUrlPattern;
+
+    char        *variable;
+    const char  *value;
+    type_code   type;
+    status_t    result;
+
+    for (int32 i = 0; i < apiParamMapping->CountNames(B_STRING_TYPE); i++) {
+        result = apiParamMapping->GetInfo(B_STRING_TYPE, i, &variable, &type);
+        if (result != B_OK) {
+            return result;
+        }
+        value = apiParamMapping->GetString(variable);
+        if (value == NULL) {
+            return B_BAD_DATA;
+        }
+        BString placeholder(variable);
+        placeholder.Prepend("$");
+        resultStr->ReplaceAll(placeholder.String(), value);
+    }
+    return B_OK;
+}
+
+static status_t BenchUrl(const char* label, const char* pattern, const char* idName, int32 urls)
+{
+    std::vector<BMessage> params(kIds);
+    char id[16];
+    for (int32 i = 0; i < kIds; i++) {
+        snprintf(id, sizeof(id), "%" B_PRId32, 8200000 + 17 * i);
+        params[i].AddString(idName, id);
+        params[i].AddString("size", "M");
+    }
+
+    UrlTemplate urlTemplate(pattern);
+    BString reference;
+    std::string url;
+    status_t result = B_OK;
+
+    for (int32 i = 0; i < kIds && result == B_OK; i++) {
+        url.clear();
+        result = ReplacePlaceholders(pattern, &params[i], &reference);
+        if (result == B_OK) {
+            result = urlTemplate.Render(&params[i], &url);
+        }
+        if (result == B_OK) {
+            result = BenchCheck(url == reference.String(), reference.String());
+        }
+    }
+    if (result != B_OK) {
+        return result;
+    }
+
+    printf("  %s\n", label);
+    double before = BenchRun("BString::ReplaceAll", urls, [&]() {
+        for (int32 i = 0; i < urls; i++) {
+            ReplacePlaceholders(pattern, &params[i % kIds], &reference);
+            BenchKeep(reference.String());
+        }
+    });
+    double after = BenchRun("UrlTemplate::Render", urls, [&]() {
+        for (int32 i = 0; i < urls; i++) {
+            url.clear();
+            urlTemplate.Render(&params[i % kIds], &url);
+            BenchKeep(url.data());
+        }
+    });
+    BenchCompare(label, before, after);
+    return B_OK;
+}
+
+/**
+* renders @kUrls cover and author photo URLs, by replacing the placeholders in the pattern as
+* CreateHttpApiUrl() did before, and with the parsed UrlTemplate into a reused buffer.
+*/
+status_t BenchUrls(const bench_options& options)
+{
+    int32 urls = kUrls * options.scale;
+
+    status_t result = BenchUrl("cover URLs", API_COVER_URL, "coverId", urls);
+    if (result == B_OK) {
+        result = BenchUrl("author photo URLs", API_AUTHOR_IMG_URL, "photoId", urls);
+    }
+    return result;
+}
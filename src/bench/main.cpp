@@ -0,0 +1,93 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ * senbench - micro benchmarks for the hot paths of the SEN plugins. Each benchmark first checks
+ * that the current implementation gives the same results as the one it replaced, which is kept
+ * in the benchmark as a reference, and then times both.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+#include "Bench.h"
+#include "../common/Log.h"
+
+static const struct {
+    const char* name;
+    bench_func  func;
+    const char* description;
+} kBenchmarks[] = {
+    { "aliases",    BenchAliases,   "resolving aliases of 10k files, BMessage vs. compiled AliasTable" },
+    { "prefixes",   BenchPrefixes,  "classifying internal attributes, StartsWith() chain vs. PrefixTable" },
+    { "session",    BenchSession,   "fetching 200 search responses from a local server, session per request vs. shared" },
+    { "json",       BenchJson,      "decoding the recorded search.json, BJson::Parse vs. projected JsonDecoder" },
+    { "urls",       BenchUrls,      "rendering 1M cover and photo URLs each, BString::ReplaceAll vs. UrlTemplate" },
+    { "mapping",    BenchMapping,   "mapping 20k search docs to attributes, array conversion chain vs. MappingPlan" }
+};
+
+static const int32 kBenchmarkCount = sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+static void PrintUsage()
+{
+    std::cerr << "Usage: senbench [-s <scale>] [-f <fixtures directory>] [<benchmark>...]" << std::endl;
+    std::cerr << "runs all or the given benchmarks, <scale> multiplies the amount of work (default 1)." << std::endl;
+    std::cerr << "Recorded service responses are read from <fixtures directory> (default fixtures)." << std::endl;
+    for (int32 i = 0; i < kBenchmarkCount; i++) {
+        std::cerr << "  " << kBenchmarks[i].name << ": " << kBenchmarks[i].description << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench_options options = { 1, "fixtures" };
+    bool selected[kBenchmarkCount] = { false };
+    bool any = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "-s") == 0 && hasValue) {
+            options.scale = atoi(argv[++i]);
+            if (options.scale < 1) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (strcmp(arg, "-f") == 0 && hasValue) {
+            options.fixtures = argv[++i];
+        } else {
+            int32 index = 0;
+            while (index < kBenchmarkCount && strcmp(arg, kBenchmarks[index].name) != 0) {
+                index++;
+            }
+            if (index == kBenchmarkCount) {
+                PrintUsage();
+                return 1;
+            }
+            selected[index] = true;
+            any = true;
+        }
+    }
+
+    // log output would end up in the measurements
+    Logger::SetLevel(SLOG_LEVEL_WARN);
+
+    int32 failed = 0;
+    for (int32 i = 0; i < kBenchmarkCount; i++) {
+        if (any && !selected[i]) {
+            continue;
+        }
+        printf("%s: %s\n", kBenchmarks[i].name, kBenchmarks[i].description);
+        status_t result = kBenchmarks[i].func(options);
+        if (result != B_OK) {
+            printf("%s failed: %s\n", kBenchmarks[i].name, strerror(result));
+            failed++;
+        }
+    }
+
+    Logger::Shutdown();
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "AliasTable.h"
+#include "HashUtil.h"
+#include "Log.h"
+
+// upper bound for the seed search per bucket, way beyond what our small tables need
+static const uint32 kMaxSeedTries = 1 << 20;
+
+AliasTable::AliasTable()
+{
+}
+
+AliasTable::~AliasTable()
+{
+}
+
+status_t AliasTable::Build(const BMessage* mappings)
+{
+    fSeeds.clear();
+    fSlots.clear();
+    fEntries.clear();
+    fStringPool.clear();
+
+    char*       key;
+    type_code   type;
+
+    for (int32 i = 0; i < mappings->CountNames(B_STRING_TYPE); i++) {
+        status_t result = mappings->GetInfo(B_STRING_TYPE, i, &key, &type);
+        if (result != B_OK) {
+            SLOG_ERROR("cannot read alias mapping #%d: %s\n", i, strerror(result));
+            return result;
+        }
+        const char* value = mappings->GetString(key, NULL);
+        if (value == NULL) {
+            continue;
+        }
+        Entry entry;
+        entry.keyLength = strlen(key);
+        entry.keyOffset = AddString(key, entry.keyLength);
+        entry.valueOffset = AddString(value, strlen(value));
+
+        fEntries.push_back(entry);
+    }
+
+    size_t count = fEntries.size();
+    if (count == 0) {
+        return B_OK;
+    }
+
+    // load factor of ~0.8 for the slots and ~2 keys per bucket keeps the seed search short
+    size_t slotCount = count + count / 4 + 1;
+    size_t bucketCount = count / 2 + 1;
+
+    std::vector<std::vector<int32> > buckets(bucketCount);
+    for (size_t i = 0; i < count; i++) {
+        const char* entryKey = &fStringPool[fEntries[i].keyOffset];
+        buckets[HashString(entryKey) % bucketCount].push_back(i);
+    }
+
+    // place the biggest buckets first while there is still room
+    std::vector<int32> order(bucketCount);
+    for (size_t i = 0; i < bucketCount; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&buckets](int32 a, int32 b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    fSeeds.assign(bucketCount, 0);
+    fSlots.assign(slotCount, -1);
+
+    std::vector<size_t> candidates;
+    for (size_t b = 0; b < bucketCount; b++) {
+        const std::vector<int32>& bucket = buckets[order[b]];
+        if (bucket.empty()) {
+            break;
+        }
+
+        bool placed = false;
+        for (uint32 seed = 1; seed < kMaxSeedTries && !placed; seed++) {
+            candidates.clear();
+            placed = true;
+
+            for (size_t k = 0; k < bucket.size(); k++) {
+                const char* entryKey = &fStringPool[fEntries[bucket[k]].keyOffset];
+                size_t slot = HashString(entryKey, seed) % slotCount;
+
+                if (fSlots[slot] != -1
+                    || std::find(candidates.begin(), candidates.end(), slot) != candidates.end()) {
+                    placed = false;
+                    break;
+                }
+                candidates.push_back(slot);
+            }
+            if (placed) {
+                for (size_t k = 0; k < bucket.size(); k++) {
+                    fSlots[candidates[k]] = bucket[k];
+                }
+                fSeeds[order[b]] = seed;
+            }
+        }
+        if (!placed) {
+            SLOG_ERROR("failed to build perfect hash for alias table with %zu entries.\n", count);
+            return B_ERROR;
+        }
+    }
+
+    return B_OK;
+}
+
+const char* AliasTable::Lookup(const char* key) const
+{
+    if (fEntries.empty() || key == NULL) {
+        return NULL;
+    }
+
+    size_t keyLength;
+    uint32 seed = fSeeds[HashString(key, 0, &keyLength) % fSeeds.size()];
+    if (seed == 0) {
+        return NULL;
+    }
+
+    int32 index = fSlots[HashString(key, seed) % fSlots.size()];
+    if (index < 0) {
+        return NULL;
+    }
+
+    const Entry& entry = fEntries[index];
+    if (entry.keyLength != keyLength
+        || memcmp(&fStringPool[entry.keyOffset], key, keyLength) != 0) {
+        return NULL;
+    }
+
+    return &fStringPool[entry.valueOffset];
+}
+
+const char* AliasTable::KeyAt(int32 index) const
+{
+    if (index < 0 || index >= CountEntries()) {
+        return NULL;
+    }
+    return &fStringPool[fEntries[index].keyOffset];
+}
+
+const char* AliasTable::ValueAt(int32 index) const
+{
+    if (index < 0 || index >= CountEntries()) {
+        return NULL;
+    }
+    return &fStringPool[fEntries[index].valueOffset];
+}
+
+uint32 AliasTable::AddString(const char* str, size_t length)
+{
+    uint32 offset = fStringPool.size();
+    fStringPool.insert(fStringPool.end(), str, str + length);
+    fStringPool.push_back('\0');
+
+    return offset;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+* immutable alias lookup table using a minimal-ish perfect hash (hash and displace),
+* so every lookup costs exactly one bucket and one slot probe plus a string compare.
+* Once built, the table is never modified and may be shared read-only between threads.
+*/
+class AliasTable {
+
+public:
+    AliasTable();
+    ~AliasTable();
+
+    /**
+    * builds the table from all string fields of @mappings, using the first value of
+    * each field as the alias target, just like BMessage::GetString() would.
+    */
+    status_t Build(const BMessage* mappings);
+
+    const char* Lookup(const char* key) const;
+    int32       CountEntries() const { return fEntries.size(); }
+    // for iterating over all entries, e.g. to derive query fields
+    const char* KeyAt(int32 index) const;
+    const char* ValueAt(int32 index) const;
+
+private:
+    struct Entry {
+        uint32 keyOffset;
+        uint32 keyLength;
+        uint32 valueOffset;
+    };
+
+    uint32                  AddString(const char* str, size_t length);
+
+    std::vector<uint32>     fSeeds;       // displacement seed per bucket, 0 = empty bucket
+    std::vector<int32>      fSlots;       // index into fEntries per slot, -1 = free
+    std::vector<Entry>      fEntries;
+    std::vector<char>       fStringPool;
+};
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <ctype.h>
+#include <string.h>
+
+#include <unordered_set>
+
+#include "AttrMerger.h"
+#include "HashUtil.h"
+#include "Log.h"
+
+// separates the values of multi-valued string attributes
+static const char kValueSeparator = ';';
+
+// first value of @name that is not empty or blank, NULL if there is none
+static const void* FindFirstValue(const BMessage* message, const char* name, type_code type,
+    ssize_t* size)
+{
+    const void* data;
+    for (int32 i = 0; message != NULL && message->FindData(name, type, i, &data, size) == B_OK; i++) {
+        if (type != B_STRING_TYPE) {
+            return data;
+        }
+        for (const char* c = reinterpret_cast<const char*>(data); *c != '\0'; c++) {
+            if (!isspace((unsigned char)*c)) {
+                return data;
+            }
+        }
+    }
+    return NULL;
+}
+
+AttrMerger::AttrMerger(merge_precedence precedence)
+    :
+    fPrecedence(precedence)
+{
+}
+
+void AttrMerger::SetPrecedence(merge_precedence precedence)
+{
+    fPrecedence = precedence;
+}
+
+void AttrMerger::SetPrecedence(const char* attrName, merge_precedence precedence)
+{
+    fPrecedences[attrName] = precedence;
+}
+
+void AttrMerger::SetMultiValued(const char* attrName)
+{
+    fMultiValued.insert(attrName);
+}
+
+status_t AttrMerger::Merge(const BMessage* local, const BMessage* remote, BMessage* result,
+    attr_merge_stats* stats) const
+{
+    attr_merge_stats mergeStats = { 0, 0 };
+    const BMessage* sides[2] = { local, remote };
+
+    for (int32 side = 0; side < 2; side++) {
+        const BMessage* message = sides[side];
+        if (message == NULL) {
+            continue;
+        }
+
+        char* name;
+        type_code type;
+        for (int32 i = 0; message->GetInfo(B_ANY_TYPE, i, &name, &type) == B_OK; i++) {
+            if (type == B_MESSAGE_TYPE) {
+                continue;
+            }
+
+            const BMessage* other = sides[1 - side];
+            type_code otherType;
+            int32 otherCount;
+            bool onBothSides = other != NULL && other->GetInfo(name, &otherType, &otherCount) == B_OK
+                && otherType != B_MESSAGE_TYPE;
+            if (onBothSides && side == 1) {
+                continue;   // already merged with the local side
+            }
+
+            const BMessage* preferred = message;
+            const BMessage* secondary = NULL;
+            if (onBothSides) {
+                mergeStats.merged++;
+                bool preferLocal = PrecedenceFor(name) == MERGE_PREFER_LOCAL;
+                preferred = preferLocal ? local : remote;
+                secondary = preferLocal ? remote : local;
+            }
+
+            type_code preferredType = preferred == message ? type : otherType;
+            bool strings = preferredType == B_STRING_TYPE
+                && (secondary == NULL || (secondary == message ? type : otherType) == B_STRING_TYPE);
+
+            status_t status;
+            if (strings && fMultiValued.find(name) != fMultiValued.end()) {
+                status = MergeSet(name, preferred, secondary, result, &mergeStats);
+            } else {
+                ssize_t size;
+                const void* data = FindFirstValue(preferred, name, preferredType, &size);
+                type_code dataType = preferredType;
+                if (data == NULL && secondary != NULL) {
+                    dataType = secondary == message ? type : otherType;
+                    data = FindFirstValue(secondary, name, dataType, &size);
+                }
+                status = data == NULL ? B_OK : result->AddData(name, dataType, data, size, false);
+            }
+
+            if (status != B_OK) {
+                SLOG_ERROR("failed to merge attribute %s: %s\n", name, strerror(status));
+                return status;
+            }
+        }
+    }
+
+    if (stats != NULL) {
+        *stats = mergeStats;
+    }
+    return B_OK;
+}
+
+uint64 AttrMerger::NormalizedHash(const char* value, size_t length)
+{
+    uint64 hash = 14695981039346656037ULL;
+    bool space = false;
+    bool empty = true;
+
+    // like HashBytes() over the trimmed, lower case value with single spaces between words
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = value[i];
+        if (isspace(c)) {
+            space = !empty;
+            continue;
+        }
+        if (space) {
+            hash ^= ' ';
+            hash *= 1099511628211ULL;
+            space = false;
+        }
+        hash ^= (c < 0x80) ? tolower(c) : c;
+        hash *= 1099511628211ULL;
+        empty = false;
+    }
+    return HashMix(hash);
+}
+
+merge_precedence AttrMerger::PrecedenceFor(const char* attrName) const
+{
+    auto it = fPrecedences.find(attrName);
+    return it == fPrecedences.end() ? fPrecedence : it->second;
+}
+
+status_t AttrMerger::MergeSet(const char* name, const BMessage* first, const BMessage* second,
+    BMessage* result, attr_merge_stats* stats) const
+{
+    std::unordered_set<uint64> seen;
+    BString joined;
+
+    const BMessage* sides[2] = { first, second };
+    for (int32 side = 0; side < 2; side++) {
+        const char* value;
+        for (int32 i = 0; sides[side] != NULL && sides[side]->FindString(name, i, &value) == B_OK; i++) {
+            const char* start = value;
+            for (;;) {
+                const char* end = strchr(start, kValueSeparator);
+                size_t length = end != NULL ? end - start : strlen(start);
+
+                // trimmed, but otherwise kept as the preferred side spelled it
+                const char* trimmed = start;
+                while (length > 0 && isspace((unsigned char)*trimmed)) {
+                    trimmed++;
+                    length--;
+                }
+                while (length > 0 && isspace((unsigned char)trimmed[length - 1])) {
+                    length--;
+                }
+
+                if (length > 0) {
+                    if (seen.insert(NormalizedHash(trimmed, length)).second) {
+                        if (!joined.IsEmpty()) {
+                            joined.Append(kValueSeparator, 1);
+                        }
+                        joined.Append(trimmed, length);
+                    } else {
+                        stats->duplicates++;
+                    }
+                }
+
+                if (end == NULL) {
+                    break;
+                }
+                start = end + 1;
+            }
+        }
+    }
+
+    if (joined.IsEmpty()) {
+        return B_OK;
+    }
+    return result->AddString(name, joined);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+enum merge_precedence {
+    MERGE_PREFER_LOCAL = 0,     // keep what the user has, only add new values to sets
+    MERGE_PREFER_REMOTE         // take what the service found, keep local values it does not have
+};
+
+struct attr_merge_stats {
+    int32   merged;         // attributes present on both sides
+    int32   duplicates;     // values dropped because the set already had them
+};
+
+/**
+* merges existing (local) attribute values with fetched (remote) ones, one field per attribute.
+* Multi-valued attributes are strings joined by ';' and merged as sets of values that are
+* compared ignoring case and whitespace, so merging the same values again changes nothing.
+* Values of the preferred side come first and keep their spelling. Single values are taken
+* from the preferred side unless it is empty.
+* Only string attributes declared with SetMultiValued() are merged as sets, a ';' in the value
+* of any other attribute is just part of it.
+*/
+class AttrMerger {
+
+public:
+    AttrMerger(merge_precedence precedence = MERGE_PREFER_LOCAL);
+
+    void        SetPrecedence(merge_precedence precedence);
+    // overrides the default precedence for @attrName
+    void        SetPrecedence(const char* attrName, merge_precedence precedence);
+    void        SetMultiValued(const char* attrName);
+
+    /**
+    * adds the merged attributes of @local and @remote to @result, either side may be NULL.
+    * Message fields are skipped.
+    */
+    status_t    Merge(const BMessage* local, const BMessage* remote, BMessage* result,
+                      attr_merge_stats* stats = NULL) const;
+
+    // hash of @value with case and whitespace normalized, as used for set membership
+    static uint64 NormalizedHash(const char* value, size_t length);
+
+private:
+    merge_precedence    PrecedenceFor(const char* attrName) const;
+    status_t            MergeSet(const char* name, const BMessage* first, const BMessage* second,
+                                 BMessage* result, attr_merge_stats* stats) const;
+
+    merge_precedence                            fPrecedence;
+    std::map<std::string, merge_precedence>     fPrecedences;
+    std::set<std::string>                       fMultiValued;
+};
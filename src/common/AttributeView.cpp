@@ -0,0 +1,186 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <fs_attr.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <new>
+
+#include "AttributeView.h"
+#include "Log.h"
+
+// most attributes are tiny, so a single block usually holds all values of a node
+static const size_t kArenaBlockSize = 4096;
+
+AttributeView::AttributeView(const entry_ref* ref)
+    :
+    fNode(ref),
+    fRef(*ref),
+    fBlockSize(0),
+    fBlockUsed(0)
+{
+    fInitStatus = fNode.InitCheck();
+    if (fInitStatus != B_OK) {
+        return;
+    }
+
+    char attrName[B_ATTR_NAME_LENGTH];
+    attr_info attrInfo;
+
+    while (fNode.GetNextAttrName(attrName) == B_OK) {
+        status_t result = fNode.GetAttrInfo(attrName, &attrInfo);
+        if (result != B_OK) {
+            SLOG_ERROR("failed to get attribute info for attribute '%s': %s\n", attrName, strerror(result));
+            fInitStatus = result;
+            return;
+        }
+
+        AttrEntry entry;
+        entry.nameOffset = fNames.size();
+        entry.type = attrInfo.type;
+        entry.size = attrInfo.size;
+        entry.data = NULL;
+
+        fNames.insert(fNames.end(), attrName, attrName + strlen(attrName) + 1);
+        fAttrs.push_back(entry);
+    }
+}
+
+AttributeView::~AttributeView()
+{
+    for (size_t i = 0; i < fBlocks.size(); i++) {
+        delete[] fBlocks[i];
+    }
+}
+
+int32 AttributeView::IndexOf(const char* name) const
+{
+    for (size_t i = 0; i < fAttrs.size(); i++) {
+        if (strcmp(&fNames[fAttrs[i].nameOffset], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char* AttributeView::NameAt(int32 index) const
+{
+    if (index < 0 || index >= CountAttrs()) {
+        return NULL;
+    }
+    return &fNames[fAttrs[index].nameOffset];
+}
+
+type_code AttributeView::TypeAt(int32 index) const
+{
+    if (index < 0 || index >= CountAttrs()) {
+        return 0;
+    }
+    return fAttrs[index].type;
+}
+
+off_t AttributeView::SizeAt(int32 index) const
+{
+    if (index < 0 || index >= CountAttrs()) {
+        return -1;
+    }
+    return fAttrs[index].size;
+}
+
+bool AttributeView::HasAttr(const char* name, type_code type) const
+{
+    int32 index = IndexOf(name);
+    return index >= 0 && (type == B_ANY_TYPE || fAttrs[index].type == type);
+}
+
+status_t AttributeView::FindDataAt(int32 index, const void** data, ssize_t* size)
+{
+    if (index < 0 || index >= CountAttrs()) {
+        return B_BAD_INDEX;
+    }
+
+    AttrEntry& entry = fAttrs[index];
+    if (entry.data == NULL) {
+        // reserve an extra byte so string values are always terminated
+        char* buffer = static_cast<char*>(Allocate(entry.size + 1));
+        if (buffer == NULL) {
+            return B_NO_MEMORY;
+        }
+
+        ssize_t bytesRead = fNode.ReadAttr(NameAt(index), entry.type, 0, buffer, entry.size);
+        if (bytesRead < 0) {
+            SLOG_ERROR("failed to read value of attribute '%s' from file %s.\n", NameAt(index), fRef.name);
+            return bytesRead;
+        }
+        buffer[bytesRead] = '\0';
+
+        entry.size = bytesRead;
+        entry.data = buffer;
+    }
+
+    *data = entry.data;
+    *size = entry.size;
+
+    return B_OK;
+}
+
+status_t AttributeView::FindData(const char* name, type_code type, const void** data, ssize_t* size)
+{
+    int32 index = IndexOf(name);
+    if (index < 0) {
+        return B_NAME_NOT_FOUND;
+    }
+    if (type != B_ANY_TYPE && fAttrs[index].type != type) {
+        return B_BAD_TYPE;
+    }
+    return FindDataAt(index, data, size);
+}
+
+const char* AttributeView::GetString(const char* name, const char* defaultValue)
+{
+    const void* data;
+    ssize_t size;
+
+    if (FindData(name, B_STRING_TYPE, &data, &size) != B_OK) {
+        return defaultValue;
+    }
+    return static_cast<const char*>(data);
+}
+
+void AttributeView::PrintToStream() const
+{
+    printf("AttributeView(%s) {\n", fRef.name);
+    for (int32 i = 0; i < CountAttrs(); i++) {
+        uint32 type = fAttrs[i].type;
+        printf("    %s, type = '%c%c%c%c', size = %lld%s\n", NameAt(i),
+            (char)(type >> 24), (char)(type >> 16), (char)(type >> 8), (char)type,
+            (long long)fAttrs[i].size, fAttrs[i].data != NULL ? " (loaded)" : "");
+    }
+    printf("}\n");
+}
+
+void* AttributeView::Allocate(size_t size)
+{
+    if (fBlocks.empty() || fBlockUsed + size > fBlockSize) {
+        // oversized values like thumbnails get a block of their own
+        size_t blockSize = size > kArenaBlockSize ? size : kArenaBlockSize;
+        char* block = new(std::nothrow) char[blockSize];
+        if (block == NULL) {
+            return NULL;
+        }
+        fBlocks.push_back(block);
+        fBlockSize = blockSize;
+        fBlockUsed = 0;
+    }
+
+    void* result = fBlocks.back() + fBlockUsed;
+    // keep following values aligned for numeric types
+    fBlockUsed += (size + 7) & ~(size_t)7;
+    if (fBlockUsed > fBlockSize) {
+        fBlockUsed = fBlockSize;
+    }
+
+    return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Entry.h>
+#include <Message.h>
+#include <Node.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+* lazy, read-only view on the attributes of a node.
+* Names, types and sizes are listed up front, values are only read on demand into an
+* arena owned by the view, so returned data stays valid for the lifetime of the view.
+*/
+class AttributeView {
+
+public:
+    AttributeView(const entry_ref* ref);
+    ~AttributeView();
+
+    status_t            InitCheck() const { return fInitStatus; }
+    const entry_ref*    Ref() const { return &fRef; }
+
+    int32               CountAttrs() const { return fAttrs.size(); }
+    int32               IndexOf(const char* name) const;
+    const char*         NameAt(int32 index) const;
+    type_code           TypeAt(int32 index) const;
+    off_t               SizeAt(int32 index) const;
+    bool                HasAttr(const char* name, type_code type = B_ANY_TYPE) const;
+
+    /**
+    * reads the value of the attribute at @index on first access, string values are
+    * always NUL terminated.
+    */
+    status_t            FindDataAt(int32 index, const void** data, ssize_t* size);
+    status_t            FindData(const char* name, type_code type, const void** data, ssize_t* size);
+    const char*         GetString(const char* name, const char* defaultValue = NULL);
+
+    void                PrintToStream() const;
+
+private:
+    struct AttrEntry {
+        uint32      nameOffset;
+        type_code   type;
+        off_t       size;
+        const void* data;       // NULL until loaded
+    };
+
+    void*               Allocate(size_t size);
+
+    BNode               fNode;
+    entry_ref           fRef;
+    status_t            fInitStatus;
+
+    std::vector<AttrEntry>  fAttrs;
+    std::vector<char>       fNames;
+    // arena for attribute values, blocks are never moved so pointers stay valid
+    std::vector<char*>      fBlocks;
+    size_t                  fBlockSize;
+    size_t                  fBlockUsed;
+};
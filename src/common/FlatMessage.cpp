@@ -0,0 +1,309 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <OS.h>
+#include <string.h>
+
+#include <charconv>
+#include <vector>
+
+#include "FlatMessage.h"
+
+/*
+* mirrors the flattened layout of headers/private/app/MessagePrivate.h: the message header,
+* followed by one field header per field and the field data, where each field starts with its
+* NUL terminated name, followed by its values. Fixed size values are packed, variable size
+* values are each prefixed with their uint32 size.
+*/
+static const uint32 kMessageFormat = '1FMH';     // MESSAGE_FORMAT_HAIKU
+static const uint16 kFieldFlagValid = 0x0001;
+static const uint16 kFieldFlagFixedSize = 0x0002;
+static const int32  kHashTableSize = 5;
+
+struct flat_message_header {
+    uint32      format;
+    uint32      what;
+    uint32      flags;
+
+    int32       target;
+    int32       current_specifier;
+    area_id     message_area;
+
+    port_id     reply_port;
+    int32       reply_target;
+    team_id     reply_team;
+
+    uint32      data_size;
+    uint32      field_count;
+    uint32      hash_table_size;
+    int32       hash_table[kHashTableSize];
+};
+
+struct flat_field_header {
+    uint16      flags;
+    uint16      name_length;
+    type_code   type;
+    uint32      count;
+    uint32      data_size;
+    uint32      offset;
+    int32       next_field;
+};
+
+// the buffer is not necessarily aligned, so headers are always copied out
+template<typename T>
+static T ReadAt(const uint8* buffer)
+{
+    T value;
+    memcpy(&value, buffer, sizeof(T));
+    return value;
+}
+
+FlatMessage::FlatMessage(const void* data, ssize_t size)
+    :
+    fBuffer(reinterpret_cast<const uint8*>(data)),
+    fSize(size),
+    fInitStatus(B_NO_INIT)
+{
+    fInitStatus = Validate();
+    if (fInitStatus == B_OK && !IsNativeFormatReadable()) {
+        fInitStatus = B_NOT_SUPPORTED;
+    }
+}
+
+FlatMessage::FlatMessage(const void* data, ssize_t size, bool /*unchecked*/)
+    :
+    fBuffer(reinterpret_cast<const uint8*>(data)),
+    fSize(size),
+    fInitStatus(B_NO_INIT)
+{
+    fInitStatus = Validate();
+}
+
+bool FlatMessage::IsNativeFormatReadable()
+{
+    // checked once per process against what BMessage::Flatten() really writes
+    static const bool sReadable = CheckNativeFormat();
+    return sReadable;
+}
+
+bool FlatMessage::CheckNativeFormat()
+{
+    BMessage probe('prob');
+    probe.AddString("0", "first");
+    probe.AddString("0", "second value");
+    probe.AddDouble("publish_year", 1937);
+    probe.AddDouble("publish_year", 1951);
+    probe.AddInt32("2", -42);
+
+    ssize_t size = probe.FlattenedSize();
+    if (size <= 0) {
+        return false;
+    }
+    std::vector<char> buffer(size);
+    if (probe.Flatten(buffer.data(), size) != B_OK) {
+        return false;
+    }
+
+    FlatMessage view(buffer.data(), size, true);
+    if (view.InitCheck() != B_OK || view.What() != probe.what
+        || view.CountFields() != probe.CountNames(B_ANY_TYPE)) {
+        return false;
+    }
+
+    for (int32 i = 0; i < view.CountFields(); i++) {
+        const char* name;
+        type_code type;
+        int32 count;
+        if (view.GetFieldAt(i, &name, &type, &count) != B_OK) {
+            return false;
+        }
+
+        type_code probeType;
+        int32 probeCount;
+        if (probe.GetInfo(name, &probeType, &probeCount) != B_OK || type != probeType
+            || count != probeCount) {
+            return false;
+        }
+
+        for (int32 index = 0; index < count; index++) {
+            const void* data;
+            const void* probeData;
+            ssize_t dataSize;
+            ssize_t probeSize;
+            if (view.FindDataAt(i, index, &data, &dataSize) != B_OK
+                || probe.FindData(name, type, index, &probeData, &probeSize) != B_OK
+                || dataSize != probeSize || memcmp(data, probeData, dataSize) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+uint32 FlatMessage::What() const
+{
+    if (fInitStatus != B_OK) {
+        return 0;
+    }
+    return ReadAt<flat_message_header>(fBuffer).what;
+}
+
+int32 FlatMessage::CountFields() const
+{
+    if (fInitStatus != B_OK) {
+        return 0;
+    }
+    return ReadAt<flat_message_header>(fBuffer).field_count;
+}
+
+status_t FlatMessage::GetFieldAt(int32 index, const char** name, type_code* type, int32* count) const
+{
+    if (index < 0 || index >= CountFields()) {
+        return B_BAD_INDEX;
+    }
+
+    const uint8* fields = fBuffer + sizeof(flat_message_header);
+    flat_field_header field = ReadAt<flat_field_header>(fields + index * sizeof(flat_field_header));
+    const uint8* data = fields + CountFields() * sizeof(flat_field_header);
+
+    if (name != NULL) {
+        *name = reinterpret_cast<const char*>(data + field.offset);
+    }
+    if (type != NULL) {
+        *type = field.type;
+    }
+    if (count != NULL) {
+        *count = field.count;
+    }
+    return B_OK;
+}
+
+status_t FlatMessage::FindDataAt(int32 fieldIndex, int32 index, const void** data, ssize_t* size) const
+{
+    if (fieldIndex < 0 || fieldIndex >= CountFields()) {
+        return B_BAD_INDEX;
+    }
+
+    const uint8* fields = fBuffer + sizeof(flat_message_header);
+    flat_field_header field = ReadAt<flat_field_header>(fields + fieldIndex * sizeof(flat_field_header));
+    if (index < 0 || (uint32)index >= field.count) {
+        return B_BAD_INDEX;
+    }
+
+    const uint8* value = fields + CountFields() * sizeof(flat_field_header) + field.offset
+        + field.name_length;
+
+    if ((field.flags & kFieldFlagFixedSize) != 0) {
+        uint32 itemSize = field.data_size / field.count;
+        *data = value + index * itemSize;
+        *size = itemSize;
+        return B_OK;
+    }
+
+    for (int32 i = 0; i < index; i++) {
+        value += sizeof(uint32) + ReadAt<uint32>(value);
+    }
+    *data = value + sizeof(uint32);
+    *size = ReadAt<uint32>(value);
+    return B_OK;
+}
+
+bool FlatMessage::IsArray() const
+{
+    int32 count = CountFields();
+    if (count == 0) {
+        return false;
+    }
+
+    const char* name;
+    for (int32 i = 0; i < count; i++) {
+        if (GetFieldAt(i, &name, NULL, NULL) != B_OK || !IsArrayIndex(name, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlatMessage::IsArray(const BMessage* message)
+{
+    int32 count = message->CountNames(B_ANY_TYPE);
+    if (count == 0) {
+        return false;
+    }
+
+    char* name;
+    type_code type;
+    for (int32 i = 0; i < count; i++) {
+        if (message->GetInfo(B_ANY_TYPE, i, &name, &type) != B_OK || !IsArrayIndex(name, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FlatMessage::IsArrayIndex(const char* name, int32 index)
+{
+    size_t length = strlen(name);
+    if (length == 0 || (length > 1 && name[0] == '0')) {
+        return false;
+    }
+
+    uint32 value;
+    auto result = std::from_chars(name, name + length, value);
+    return result.ec == std::errc() && result.ptr == name + length && value == (uint32)index;
+}
+
+status_t FlatMessage::Validate() const
+{
+    if (fBuffer == NULL || fSize < (ssize_t)sizeof(flat_message_header)) {
+        return B_BAD_VALUE;
+    }
+
+    flat_message_header header = ReadAt<flat_message_header>(fBuffer);
+    if (header.format != kMessageFormat) {
+        return B_NOT_SUPPORTED;
+    }
+
+    // everything is checked once here, so the accessors can read without bounds checks
+    size_t fieldsSize = (size_t)header.field_count * sizeof(flat_field_header);
+    if (fieldsSize + header.data_size != (size_t)fSize - sizeof(flat_message_header)) {
+        return B_BAD_DATA;
+    }
+
+    const uint8* fields = fBuffer + sizeof(flat_message_header);
+    const uint8* data = fields + fieldsSize;
+
+    for (uint32 i = 0; i < header.field_count; i++) {
+        flat_field_header field = ReadAt<flat_field_header>(fields + i * sizeof(flat_field_header));
+        if ((field.flags & kFieldFlagValid) == 0 || field.name_length == 0 || field.count == 0
+            || (uint64)field.offset + field.name_length + field.data_size > header.data_size
+            || data[field.offset + field.name_length - 1] != '\0') {
+            return B_BAD_DATA;
+        }
+
+        if ((field.flags & kFieldFlagFixedSize) != 0) {
+            if (field.data_size % field.count != 0) {
+                return B_BAD_DATA;
+            }
+            continue;
+        }
+
+        // each item needs its size prefix to stay within the field
+        const uint8* value = data + field.offset + field.name_length;
+        uint64 remaining = field.data_size;
+        for (uint32 item = 0; item < field.count; item++) {
+            if (remaining < sizeof(uint32)) {
+                return B_BAD_DATA;
+            }
+            uint64 itemSize = sizeof(uint32) + (uint64)ReadAt<uint32>(value);
+            if (itemSize > remaining) {
+                return B_BAD_DATA;
+            }
+            value += itemSize;
+            remaining -= itemSize;
+        }
+    }
+
+    return B_OK;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+/**
+* read-only view on a flattened BMessage, like the data of a nested message field.
+* Fields and values are read in place from the buffer, which has to outlive the view, so walking
+* a nested message needs no Unflatten() copy. Only the native Haiku message format is supported,
+* InitCheck() fails for anything else and callers need to fall back to BMessage::Unflatten().
+* The layout is checked once per process against the output of BMessage::Flatten(), if it does
+* not match, InitCheck() always fails and all callers take the Unflatten() path.
+*/
+class FlatMessage {
+
+public:
+    FlatMessage(const void* data, ssize_t size);
+
+    status_t    InitCheck() const { return fInitStatus; }
+
+    uint32      What() const;
+    int32       CountFields() const;
+    status_t    GetFieldAt(int32 index, const char** name, type_code* type, int32* count) const;
+    status_t    FindDataAt(int32 fieldIndex, int32 index, const void** data, ssize_t* size) const;
+
+    /**
+    * true if the field names are "0", "1", ... in order, which is how BJson stores arrays.
+    * Empty messages are no arrays, since they could just as well be empty objects.
+    */
+    bool        IsArray() const;
+
+    // for messages that are already unflattened
+    static bool IsArray(const BMessage* message);
+    // true if @name is the decimal number @index without sign or leading zeros
+    static bool IsArrayIndex(const char* name, int32 index);
+
+    // true if flattened messages of this system can be read in place
+    static bool IsNativeFormatReadable();
+
+private:
+    // without the format check, for the check itself
+    FlatMessage(const void* data, ssize_t size, bool unchecked);
+
+    static bool CheckNativeFormat();
+    status_t    Validate() const;
+
+    const uint8*    fBuffer;
+    ssize_t         fSize;
+    status_t        fInitStatus;
+};
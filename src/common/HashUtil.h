@@ -0,0 +1,51 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+
+/**
+* small, seedable 64 bit hash helpers (FNV-1a with a final avalanche step) shared by
+* the lookup tables and caches, not meant for cryptographic use.
+*/
+static inline uint64 HashMix(uint64 hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static inline uint64 HashBytes(const void* data, size_t size, uint64 seed = 0)
+{
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    uint64 hash = 14695981039346656037ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return HashMix(hash);
+}
+
+/**
+* hashes a NUL terminated string, optionally returning its length to save another strlen().
+*/
+static inline uint64 HashString(const char* str, uint64 seed = 0, size_t* length = NULL)
+{
+    uint64 hash = 14695981039346656037ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+    const char* pos = str;
+
+    for (; *pos != '\0'; pos++) {
+        hash ^= static_cast<uint8>(*pos);
+        hash *= 1099511628211ULL;
+    }
+    if (length != NULL) {
+        *length = pos - str;
+    }
+    return HashMix(hash);
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <Locker.h>
+#include <OS.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "Log.h"
+
+static const size_t     kSlotCount = 1024;          // must be a power of 2
+static const size_t     kMaxLineLength = 512;
+static const bigtime_t  kFlushInterval = 20000;     // 20ms
+
+/**
+* bounded multi-producer ring buffer (after D. Vyukov), producers only ever do a single CAS
+* to claim a slot and format into it in place, the flusher is the only consumer.
+*/
+class LogBuffer {
+
+public:
+    LogBuffer();
+
+    bool        Enqueue(log_level level, const char* format, va_list args);
+    // writes out all published lines, returns the number of lines written
+    int32       Drain();
+
+    void        Start();
+    void        Stop();
+
+    void        Drop() { fDropped.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64> sequence;
+        log_level           level;
+        char                line[kMaxLineLength];
+    };
+
+    static status_t     FlushThread(void* data);
+
+    Slot                fSlots[kSlotCount];
+    std::atomic<uint64> fEnqueuePos;
+    uint64              fDequeuePos;        // protected by fDrainLock
+    std::atomic<int64>  fDropped;
+    BLocker             fDrainLock;
+
+    thread_id           fFlushThread;
+    std::atomic<bool>   fQuitting;
+};
+
+std::atomic<log_level> Logger::sLevel(SLOG_LEVEL_INFO);
+
+static LogBuffer* sLogBuffer = NULL;
+static pthread_once_t sLogBufferOnce = PTHREAD_ONCE_INIT;
+
+static void InitLogBuffer()
+{
+    const char* level = getenv("SENSEI_LOG_LEVEL");
+    if (level != NULL) {
+        const char* names[] = { "trace", "debug", "info", "warn", "error", "off" };
+        for (int32 i = SLOG_LEVEL_TRACE; i <= SLOG_LEVEL_OFF; i++) {
+            if (strcasecmp(level, names[i]) == 0) {
+                Logger::SetLevel(static_cast<log_level>(i));
+            }
+        }
+    }
+
+    // never deleted, log lines may still come in from other threads during exit
+    sLogBuffer = new LogBuffer();
+    sLogBuffer->Start();
+    atexit(Logger::Shutdown);
+}
+
+static LogBuffer* GetLogBuffer()
+{
+    pthread_once(&sLogBufferOnce, InitLogBuffer);
+    return sLogBuffer;
+}
+
+// LogBuffer
+
+LogBuffer::LogBuffer()
+    :
+    fEnqueuePos(0),
+    fDequeuePos(0),
+    fDropped(0),
+    fDrainLock("log drain"),
+    fFlushThread(-1),
+    fQuitting(false)
+{
+    for (size_t i = 0; i < kSlotCount; i++) {
+        fSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool LogBuffer::Enqueue(log_level level, const char* format, va_list args)
+{
+    uint64 pos = fEnqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &fSlots[pos & (kSlotCount - 1)];
+        uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        int64 diff = (int64)sequence - (int64)pos;
+
+        if (diff == 0) {
+            if (fEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // full, the flusher can't keep up
+            return false;
+        } else {
+            pos = fEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    vsnprintf(slot->line, kMaxLineLength, format, args);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+int32 LogBuffer::Drain()
+{
+    BAutolock locker(fDrainLock);
+    int32 count = 0;
+
+    for (;;) {
+        Slot* slot = &fSlots[fDequeuePos & (kSlotCount - 1)];
+        uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+
+        if (sequence != fDequeuePos + 1) {
+            break;  // nothing (more) published yet
+        }
+
+        FILE* stream = slot->level >= SLOG_LEVEL_WARN ? stderr : stdout;
+        fputs(slot->line, stream);
+
+        slot->sequence.store(fDequeuePos + kSlotCount, std::memory_order_release);
+        fDequeuePos++;
+        count++;
+    }
+
+    int64 dropped = fDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        fprintf(stderr, "[log buffer overflow, %" B_PRId64 " lines dropped]\n", dropped);
+    }
+    if (count > 0) {
+        fflush(stdout);
+    }
+
+    return count;
+}
+
+void LogBuffer::Start()
+{
+    fFlushThread = spawn_thread(FlushThread, "log flusher", B_LOW_PRIORITY, this);
+    if (fFlushThread >= 0) {
+        resume_thread(fFlushThread);
+    }
+}
+
+void LogBuffer::Stop()
+{
+    if (fFlushThread >= 0 && !fQuitting.exchange(true)) {
+        status_t exitValue;
+        wait_for_thread(fFlushThread, &exitValue);
+    }
+    Drain();
+}
+
+status_t LogBuffer::FlushThread(void* data)
+{
+    LogBuffer* buffer = static_cast<LogBuffer*>(data);
+
+    while (!buffer->fQuitting.load()) {
+        if (buffer->Drain() == 0) {
+            snooze(kFlushInterval);
+        }
+    }
+    return B_OK;
+}
+
+// Logger
+
+void Logger::SetLevel(log_level level)
+{
+    sLevel.store(level, std::memory_order_relaxed);
+}
+
+void Logger::Log(log_level level, const char* format, ...)
+{
+    LogBuffer* buffer = GetLogBuffer();
+
+    va_list args;
+    va_start(args, format);
+    bool queued = buffer->Enqueue(level, format, args);
+    va_end(args);
+
+    if (!queued) {
+        if (level < SLOG_LEVEL_WARN) {
+            buffer->Drop();
+            return;
+        }
+        // never lose warnings and errors, make room synchronously and try again
+        buffer->Drain();
+
+        va_start(args, format);
+        queued = buffer->Enqueue(level, format, args);
+        va_end(args);
+
+        if (!queued) {
+            va_start(args, format);
+            vfprintf(stderr, format, args);
+            va_end(args);
+        }
+    }
+}
+
+void Logger::Flush()
+{
+    GetLogBuffer()->Drain();
+}
+
+void Logger::Shutdown()
+{
+    GetLogBuffer()->Stop();
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+
+#include <atomic>
+
+enum log_level {
+    SLOG_LEVEL_TRACE = 0,
+    SLOG_LEVEL_DEBUG,
+    SLOG_LEVEL_INFO,
+    SLOG_LEVEL_WARN,
+    SLOG_LEVEL_ERROR,
+    SLOG_LEVEL_OFF
+};
+
+// log statements below this level are compiled out entirely, e.g. -DSLOG_MIN_LEVEL=SLOG_LEVEL_INFO
+#ifndef SLOG_MIN_LEVEL
+#define SLOG_MIN_LEVEL SLOG_LEVEL_TRACE
+#endif
+
+/**
+* low overhead logging shared by all SENSEI plugins.
+* Messages are only formatted if their level is enabled, formatted directly into a slot of a
+* lock-free ring buffer and written out by a background thread, so callers never wait for console I/O.
+* The default level is INFO and can be overridden with the environment variable SENSEI_LOG_LEVEL.
+*/
+class Logger {
+
+public:
+    static bool         IsEnabled(log_level level)
+                        { return level >= sLevel.load(std::memory_order_relaxed); }
+    static void         SetLevel(log_level level);
+    static log_level    Level() { return sLevel.load(std::memory_order_relaxed); }
+
+    static void         Log(log_level level, const char* format, ...)
+                            __attribute__((format(printf, 2, 3)));
+    // writes out all pending log lines synchronously, e.g. before dumping a message
+    static void         Flush();
+    static void         Shutdown();
+
+private:
+    static std::atomic<log_level> sLevel;
+};
+
+#define SLOG(level, ...) \
+    do { \
+        if ((level) >= SLOG_MIN_LEVEL && Logger::IsEnabled(level)) \
+            Logger::Log(level, __VA_ARGS__); \
+    } while (0)
+
+#define SLOG_TRACE(...)     SLOG(SLOG_LEVEL_TRACE, __VA_ARGS__)
+#define SLOG_DEBUG(...)     SLOG(SLOG_LEVEL_DEBUG, __VA_ARGS__)
+#define SLOG_INFO(...)      SLOG(SLOG_LEVEL_INFO, __VA_ARGS__)
+#define SLOG_WARN(...)      SLOG(SLOG_LEVEL_WARN, __VA_ARGS__)
+#define SLOG_ERROR(...)     SLOG(SLOG_LEVEL_ERROR, __VA_ARGS__)
+
+// dumps a BMessage if the level is enabled, keeping the order with already buffered lines
+#define SLOG_MESSAGE(level, msg) \
+    do { \
+        if ((level) >= SLOG_MIN_LEVEL && Logger::IsEnabled(level)) { \
+            Logger::Flush(); \
+            (msg)->PrintToStream(); \
+        } \
+    } while (0)
+
+// route the SEN debug macro through the logger as well
+#ifdef LOG
+#undef LOG
+#endif
+#define LOG(...)            SLOG_DEBUG(__VA_ARGS__)
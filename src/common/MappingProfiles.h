@@ -0,0 +1,56 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+
+/**
+* a single alias definition, in the same direction as the plugins' "SENSEI:attr_mapping" resources:
+* short alias (service parameter or message key) -> full attribute name.
+*/
+struct alias_def {
+    const char* alias;
+    const char* attribute;
+};
+
+/**
+* built-in mapping profiles per entity type, used when a plugin binary carries no
+* "SENSEI:attr_mapping" attribute (e.g. when built with plain make instead of build.sh).
+* Keep in sync with the respective Resources.rdef.
+*/
+static constexpr alias_def kBookMappingProfile[] = {
+    { "isbn",                   "Book:ISBN" },
+    { "author_name",            "Book:Authors" },
+    { "language",               "Book:Languages" },
+    { "publisher",              "Book:Publisher" },
+    { "format",                 "Book:Format" },
+    { "subject",                "Book:Subjects" },
+    { "lcc",                    "Book:Class" },
+    { "number_of_pages_median", "Book:Pages" },
+    { "title",                  "Media:Title" },
+    { "publish_year",           "Book:Year" },
+    // keep these for later to save another lookup query for relations
+    { "author_key",             "OPENLIB:author_keys" },
+    { "cover_i",                "OPENLIB:cover_key" }
+};
+
+static constexpr alias_def kAuthorMappingProfile[] = {
+    { "name",                   "META:name" },
+    { "birth_date",             "META:birthdate" },
+    { "photos",                 "OPENLIB:cover_key" }
+};
+
+static constexpr alias_def kDocRefMappingProfile[] = {
+    { "page",                   "SEN:REL:docref:page" }
+};
+
+static constexpr alias_def kIncludeMappingProfile[] = {
+    { "line",                   "be:line" },
+    { "path",                   "SEN:REL:SourceInclude:path" },
+    { "spath",                  "SEN:REL:SourceInclude:search_path" },
+    { "global",                 "SEN:REL:SourceInclude:global" }
+};
+
+#define MAPPING_PROFILE_SIZE(profile) (sizeof(profile) / sizeof(profile[0]))
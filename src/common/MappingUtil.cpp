@@ -6,107 +6,237 @@
 #include <NodeInfo.h>
 #include <fs_attr.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
 
 #include "MappingUtil.h"
+#include "PrefixTable.h"
 #include "Sen.h"
 #include "Sensei.h"
+#include "Log.h"
+#include "Metrics.h"
+
+// attributes of the system or other applications that are never mapped
+static constexpr const char* kInternalAttrPrefixes[] = {
+    "be:",
+    "BEOS:",
+    "META:",
+    "_trk/",
+    "Media:Thumbnail",
+    // application specific metadata
+    "bepdf:",
+    "pe-info",
+    "PDF:",
+    "StyledEdit"
+};
+
+static constexpr PrefixTable<sizeof(kInternalAttrPrefixes) / sizeof(kInternalAttrPrefixes[0])>
+    kInternalAttrs(kInternalAttrPrefixes);
+
+// additional prefixes registered by plugins at startup, usually empty
+static std::vector<BString> sPluginAttrPrefixes;
 
 MappingUtil::MappingUtil()
 {
     fMappingTable = new BMessage('SEmt');
+    fAliasTable = NULL;
 }
 
 MappingUtil::~MappingUtil()
 {
+    delete fAliasTable;
     delete fMappingTable;
 }
 
 status_t MappingUtil::AddAlias(const char* source, const char* target, bool bidir)
 {
+    if (IsCompiled()) {
+        SLOG_ERROR("cannot add mapping for %s -> %s: mapping table is already compiled.\n", source, target);
+        return B_NOT_ALLOWED;
+    }
+
     status_t result = fMappingTable->AddString(source, target);
     if (result == B_OK) {
         if (bidir) {
             // map in other direction, sanity check if different
             if (strlen(source) == strlen(target) || strncmp(source, target, strlen(target)) == 0) {
-                printf("invalid arguments: bidirectional mapping for identical values requested! Skipping.");
+                SLOG_WARN("invalid arguments: bidirectional mapping for identical values requested! Skipping.");
             } else {
                 result = fMappingTable->AddString(target, source);
             }
         }
     }
     if (result != B_OK) {
-        printf("error adding mapping for %s -> %s: %s\n", source, target, strerror(result));
+        SLOG_ERROR("error adding mapping for %s -> %s: %s\n", source, target, strerror(result));
+        return result;
+    }
+
+    if (std::find(fAttrNames.begin(), fAttrNames.end(), source) == fAttrNames.end()) {
+        fAttrNames.push_back(BString(source));
+    }
+
+    // the target is the alias, several attributes may share it as fallbacks
+    for (size_t i = 0; i < fAliasNames.size(); i++) {
+        if (fAliasNames[i] == target) {
+            return B_OK;
+        }
+    }
+    fAliasNames.push_back(BString(target));
+
+    return B_OK;
+}
+
+status_t MappingUtil::AddAliases(const alias_def* profile, size_t count, bool bidir)
+{
+    for (size_t i = 0; i < count; i++) {
+        status_t result = AddAlias(profile[i].attribute, profile[i].alias, bidir);
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
+
+status_t MappingUtil::AddAliases(const BMessage* mappingMsg, bool bidir)
+{
+    char*       alias;
+    type_code   type;
+    int32       count;
+
+    for (int32 i = 0; i < mappingMsg->CountNames(B_STRING_TYPE); i++) {
+        status_t result = mappingMsg->GetInfo(B_STRING_TYPE, i, &alias, &type, &count);
+        if (result != B_OK) {
+            return result;
+        }
+        // an alias may map to several attributes, e.g. for fallbacks
+        for (int32 index = 0; index < count; index++) {
+            const char* attribute = mappingMsg->GetString(alias, index, NULL);
+            if (attribute == NULL) {
+                continue;
+            }
+            result = AddAlias(attribute, alias, bidir);
+            if (result != B_OK) {
+                return result;
+            }
+        }
+    }
+    return B_OK;
+}
+
+status_t MappingUtil::LoadAliases(const entry_ref* pluginRef, const char* attrName)
+{
+    BMessage mappingMsg;
+    status_t result = ReadMessageAttr(pluginRef, attrName, &mappingMsg);
+    if (result != B_OK) {
+        return result;
+    }
+
+    return AddAliases(&mappingMsg);
+}
+
+status_t MappingUtil::Compile()
+{
+    if (IsCompiled()) {
+        return B_OK;
+    }
+
+    AliasTable* table = new AliasTable();
+    status_t result = table->Build(fMappingTable);
+    if (result != B_OK) {
+        delete table;
         return result;
     }
+
+    fAliasTable = table;
     return B_OK;
 }
 
-const char* MappingUtil::ResolveAlias(const char* alias, char* defaultValue)
+const char* MappingUtil::ResolveAlias(const char* alias, const char* defaultValue) const
 {
+    if (fAliasTable != NULL) {
+        const char* value = fAliasTable->Lookup(alias);
+        return value != NULL ? value : defaultValue;
+    }
     return fMappingTable->GetString(alias, defaultValue);
 }
 
+const char* MappingUtil::AliasAt(int32 index) const
+{
+    if (index < 0 || index >= CountAliases()) {
+        return NULL;
+    }
+    return fAliasNames[index].String();
+}
+
+const char* MappingUtil::AttributeAt(int32 index) const
+{
+    if (index < 0 || index >= CountAttributes()) {
+        return NULL;
+    }
+    return fAttrNames[index].String();
+}
+
 /**
 * low level mapping between file system attributes and the SEN plugins
 */
 status_t MappingUtil::MapAttrsToMsg(const entry_ref* ref, BMessage *attrMsg)
 {
-    status_t result;
-    BNode node(ref);
+    AttributeView attrView(ref);
+
+    return MapAttrsToMsg(&attrView, attrMsg);
+}
+
+status_t MappingUtil::MapAttrsToMsg(AttributeView* attrView, BMessage *attrMsg, bool mappedOnly)
+{
+    METRICS_STAGE("mapping.read_attrs");
+
+    status_t result = attrView->InitCheck();
+    const entry_ref* ref = attrView->Ref();
 
-    result = node.InitCheck();
 	if (result != B_OK) {
-        printf("failed to read input file from ref %s: %s\n", ref->name, strerror(result));
+        SLOG_ERROR("failed to read input file from ref %s: %s\n", ref->name, strerror(result));
 		return result;
     }
 
-	char *attrName = new char[B_ATTR_NAME_LENGTH];
-    attr_info attrInfo;
-    type_code attrType;
+	for (int32 i = 0; i < attrView->CountAttrs(); i++) {
+        const char* attrName = attrView->NameAt(i);
 
-	while (node.GetNextAttrName(attrName) == B_OK) {
+        // check by name first so we never read values we don't need, e.g. large thumbnails
         if (IsInternalAttr(attrName)) {
-            printf("skippinng internal attribute %s.\n", attrName);
+            SLOG_DEBUG("skippinng internal attribute %s.\n", attrName);
             continue;
         }
 
-        if (! fMappingTable->HasString(attrName)) {
+        if (ResolveAlias(attrName) == NULL) {
+            if (mappedOnly) {
+                continue;
+            }
             // usually happens when directly processing file attributes, which should already be in canonical form.
-            printf("processing attribute '%s' as is, no mapping defined.\n", attrName);
+            SLOG_DEBUG("processing attribute '%s' as is, no mapping defined.\n", attrName);
         }
 
-        result = node.GetAttrInfo(attrName, &attrInfo);
+        const void* attrValue;
+        ssize_t     attrSize;
+
+        result = attrView->FindDataAt(i, &attrValue, &attrSize);
         if (result != B_OK) {
-            printf("failed to get attribute info for attribute '%s': %s\n", attrName, strerror(result));
+            SLOG_ERROR("failed to read value of attribute '%s' from file %s.\n", attrName, ref->name);
             return result;
-        }
-
-        char attrValue[attrInfo.size + 1];
-        attrType = attrInfo.type;
-
-        ssize_t bytesRead = node.ReadAttr(
-            attrName,
-            attrType,
-            0,
-            attrValue,
-            attrInfo.size);
-
-        if (bytesRead == 0) {
-            printf("attribute %s has unexpeted type %u in file %s.\n", attrName, attrType, ref->name);
-            return B_ERROR;
-        } else if (bytesRead < 0) {
-            printf("failed to read value of attribute '%s' from file %s.\n", attrName, ref->name);
+        } else if (attrSize == 0) {
+            SLOG_ERROR("attribute %s has unexpeted type %u in file %s.\n", attrName, attrView->TypeAt(i), ref->name);
             return B_ERROR;
         }
 
-        result = attrMsg->AddData(attrName, attrType, attrValue, bytesRead, false);
+        result = attrMsg->AddData(attrName, attrView->TypeAt(i), attrValue, attrSize, false);
         if (result != B_OK) {
             break;
         }
 	}
 
     if (result != B_OK) {
-        printf("error mapping attributes: %s\n", strerror(result));
+        SLOG_ERROR("error mapping attributes: %s\n", strerror(result));
         return result;
     }
 
@@ -119,20 +249,35 @@ status_t MappingUtil::MapAttrsToMsg(const entry_ref* ref, BMessage *attrMsg)
 /**
 * low level mapping from Enricher back to file system attributes.
 */
-status_t MappingUtil::MapMsgToAttrs(const BMessage *attrMsg, entry_ref* targetRef, bool overwrite)
+status_t MappingUtil::MapMsgToAttrs(const BMessage *attrMsg, entry_ref* targetRef, bool overwrite,
+    attr_write_stats* stats)
 {
+    METRICS_STAGE("mapping.write_attrs");
+
     status_t result;
     BNode node(targetRef);
 
+    attr_write_stats writeStats = { 0, 0, 0 };
+    status_t firstError = B_OK;
+
     result = node.InitCheck();
 	if (result != B_OK) {
-        printf("failed to open output file '%s' for writing: %s\n", targetRef->name, strerror(result));
+        SLOG_ERROR("failed to open output file '%s' for writing: %s\n", targetRef->name, strerror(result));
 		return result;
     } else {
-        printf("writing metadata to fs attributes of output file '%s'...\n", targetRef->name);
+        SLOG_DEBUG("writing metadata to fs attributes of output file '%s'...\n", targetRef->name);
     }
 
-    // go through all message data and write to attributes with respective name and type from message key/type
+    struct pending_write {
+        const char* key;
+        type_code   type;
+        const void* data;
+        ssize_t     size;
+    };
+    std::vector<pending_write> pendingWrites;
+    std::vector<char> storedValue;
+
+    // first pass: compare all message data with stored attributes and only keep changed values
     for (int32 i = 0; i < attrMsg->CountNames(B_ANY_TYPE); i++) {
         char *key;
         uint32 type;
@@ -148,14 +293,14 @@ status_t MappingUtil::MapMsgToAttrs(const BMessage *attrMsg, entry_ref* targetRe
                 if (strncmp(key, SENSEI_NAME, strlen(SENSEI_NAME)) == 0) {
                 	BString fileName;
                 	fileName << (const char*) data;
-                	if (! fileName.Trim().IsEmpty()) {
+                	if (! fileName.Trim().IsEmpty() && fileName != targetRef->name) {
                 		BEntry targetEntry(targetRef);
                 		// overewriting existing name is not checked again here, has to be
                 		// one by specific enricher based on its settings and other logic.
                 		if (targetEntry.InitCheck() == B_OK) {
                 			result = targetEntry.Rename(fileName.String());
                 			if (result != B_OK) {
-                				printf("error renaming outupt file '%s' to '%s', ignoring: %s\n",
+                				SLOG_WARN("error renaming outupt file '%s' to '%s', ignoring: %s\n",
                 						targetRef->name, fileName.String(), strerror(result));
                 			}
                 		}
@@ -170,91 +315,198 @@ status_t MappingUtil::MapMsgToAttrs(const BMessage *attrMsg, entry_ref* targetRe
                 result = node.GetAttrInfo(key, &attrInfo);
                 if (result != B_OK) {
                     if (result != B_ENTRY_NOT_FOUND) {
-                        printf("error inspecting attribute '%s' of file %s: %s\n", key, targetRef->name, strerror(result));
-                        return result;
+                        SLOG_ERROR("error inspecting attribute '%s' of file %s: %s\n", key, targetRef->name, strerror(result));
+                        writeStats.failed++;
+                        if (firstError == B_OK) {
+                            firstError = result;
+                        }
+                        continue;
                     }
                 } else {
                     if (! overwrite) {
-                        printf("skipping existing attribute '%s' of file %s: use flag 'overwrite' to force replace.\n",
+                        SLOG_DEBUG("skipping existing attribute '%s' of file %s: use flag 'overwrite' to force replace.\n",
                             key, targetRef->name);
+                        writeStats.skipped++;
                         continue;
                     }
+                    // only rewrite if the value changed, compare by size first and only then by content
+                    if (attrInfo.type == type && attrInfo.size == dataSize) {
+                        storedValue.resize(dataSize);
+                        ssize_t bytesRead = node.ReadAttr(key, type, 0, storedValue.data(), dataSize);
+
+                        if (bytesRead == dataSize
+                            && memcmp(storedValue.data(), data, dataSize) == 0) {
+                            writeStats.skipped++;
+                            continue;
+                        }
+                    }
                 }
-                ssize_t attrSize = node.WriteAttr(key, type, 0, data, dataSize);
-                if (attrSize < 0) {
-                    printf("failed to write attribute '%s' to file %s: %s\n", key, targetRef->name, strerror(attrSize));
-                    return attrSize;    // maps to system error if negative
-                }
+
+                pending_write write = { key, type, data, dataSize };
+                pendingWrites.push_back(write);
             }
         }
     }
-    return B_OK;
+
+    // second pass: write all changed attributes at once
+    for (size_t i = 0; i < pendingWrites.size(); i++) {
+        const pending_write& write = pendingWrites[i];
+
+        ssize_t attrSize = node.WriteAttr(write.key, write.type, 0, write.data, write.size);
+        if (attrSize < 0) {
+            SLOG_ERROR("failed to write attribute '%s' to file %s: %s\n", write.key, targetRef->name, strerror(attrSize));
+            writeStats.failed++;
+            if (firstError == B_OK) {
+                firstError = attrSize;    // maps to system error if negative
+            }
+        } else {
+            writeStats.written++;
+        }
+    }
+
+    if (writeStats.written > 0) {
+        node.Sync();
+    }
+
+    SLOG_INFO("attributes of file %s: %d written, %d skipped, %d failed.\n", targetRef->name,
+        writeStats.written, writeStats.skipped, writeStats.failed);
+
+    if (stats != NULL) {
+        *stats = writeStats;
+    }
+    return firstError;
 }
 
-status_t MappingUtil::GetMimeTypeAttrs(const entry_ref* ref, BMessage *mimeAttrMsg)
+status_t MappingUtil::GetMimeType(const entry_ref* ref, BString* mimeType)
 {
     BNode node(ref);
-    BMimeType mimeType;
     char type[B_MIME_TYPE_LENGTH];
 
     BNodeInfo nodeInfo(&node);
     status_t result = nodeInfo.GetType(type);
 
     if (result == B_OK) {
-        mimeType.SetType(type);
+        *mimeType = type;
     } else {
-        result = BMimeType::GuessMimeType(ref, &mimeType);
+        BMimeType guessedType;
+        result = BMimeType::GuessMimeType(ref, &guessedType);
         if (result != B_OK) {
-            printf("failed to get MIME info for input file %s: %s\n", ref->name, strerror(result));
+            SLOG_ERROR("failed to get MIME info for input file %s: %s\n", ref->name, strerror(result));
             return result;
         }
+        *mimeType = guessedType.Type();
     }
 
-    printf("got MIME Type %s for ref '%s'.\n", mimeType.Type(), ref->name);
+    SLOG_DEBUG("got MIME Type %s for ref '%s'.\n", mimeType->String(), ref->name);
 
-    BMessage attrInfoMsg;
-    result = mimeType.GetAttrInfo(&attrInfoMsg);
+    return B_OK;
+}
 
+status_t MappingUtil::GetMimeTypeSchema(const char* mimeType, std::shared_ptr<const MimeSchema>& schema)
+{
+    METRICS_STAGE("mime.schema");
+
+    status_t result = MimeSchemaCache::Default()->GetSchema(mimeType, schema);
+    if (result != B_OK) {
+        SLOG_ERROR("failed to get attribute schema for MIME type %s: %s\n", mimeType, strerror(result));
+    }
+    return result;
+}
+
+status_t MappingUtil::GetMimeTypeAttrs(const entry_ref* ref, BMessage *mimeAttrMsg)
+{
+    BString mimeType;
+    status_t result = GetMimeType(ref, &mimeType);
     if (result != B_OK) {
-        printf("failed to get attrInfo for MIME type %s: %s\n", mimeType.Type(), strerror(result));
         return result;
     }
 
-    int32 count;
-    result = attrInfoMsg.GetInfo("attr:name", NULL, &count);
+    std::shared_ptr<const MimeSchema> schema;
+    result = GetMimeTypeSchema(mimeType.String(), schema);
+    if (result != B_OK) {
+        return result;
+    }
 
     // fill in name and type and return as msg
-    for (int32 info = 0; info < count; info++) {
+    return schema->AddToMessage(mimeAttrMsg);
+}
 
-        const char* attrName = attrInfoMsg.GetString("attr:name", info, NULL);
-        if (attrName == NULL) {
-            printf("failed to get MIME attribute info for attribute: could not get 'attr:name'!\n");
-            return B_ERROR;
-        }
-        int32 typeCode = attrInfoMsg.GetInt32("attr:type", info, -1);
-        if (typeCode < 0) {
-            printf("failed to get attribute type 'attr:type' for attribute %s\n", attrName);
-            return B_ERROR;
+bool MappingUtil::IsInternalAttr(const char* attrName)
+{
+    if (kInternalAttrs.Matches(attrName)) {
+        return true;
+    }
+
+    for (size_t i = 0; i < sPluginAttrPrefixes.size(); i++) {
+        const BString& prefix = sPluginAttrPrefixes[i];
+        if (strncmp(attrName, prefix.String(), prefix.Length()) == 0) {
+            return true;
         }
-        // add name/type mapping for MIME type
-        mimeAttrMsg->AddInt32(attrName, typeCode);
+    }
+    return false;
+}
+
+status_t MappingUtil::AddInternalPrefix(const char* prefix)
+{
+    if (prefix == NULL || prefix[0] == '\0') {
+        return B_BAD_VALUE;
+    }
+    if (IsInternalAttr(prefix)) {
+        return B_OK;    // already covered
     }
 
+    sPluginAttrPrefixes.push_back(BString(prefix));
     return B_OK;
 }
 
-bool MappingUtil::IsInternalAttr(const char* attrName)
+status_t MappingUtil::LoadInternalPrefixes(const entry_ref* pluginRef, const char* attrName)
+{
+    BMessage prefixMsg;
+    status_t result = ReadMessageAttr(pluginRef, attrName, &prefixMsg);
+    if (result != B_OK) {
+        return result;
+    }
+
+    const char* prefix;
+    for (int32 i = 0; prefixMsg.FindString("prefix", i, &prefix) == B_OK; i++) {
+        result = AddInternalPrefix(prefix);
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
+
+status_t MappingUtil::ReadMessageAttr(const entry_ref* ref, const char* attrName, BMessage* msg)
 {
-    BString name(attrName);
-
-    return name.StartsWith("be:") ||
-           name.StartsWith("BEOS:") ||
-           name.StartsWith("META:") ||
-           name.StartsWith("_trk/") ||
-           name.StartsWith("Media:Thumbnail") ||
-           // application specific metadata
-           name.StartsWith("bepdf:") ||
-           name.StartsWith("pe-info") ||
-           name.StartsWith("PDF:") ||
-           name.StartsWith("StyledEdit");
+    BNode node(ref);
+    status_t result = node.InitCheck();
+    if (result != B_OK) {
+        return result;
+    }
+
+    attr_info attrInfo;
+    result = node.GetAttrInfo(attrName, &attrInfo);
+    if (result != B_OK) {
+        return result;
+    }
+    if (attrInfo.type != B_MESSAGE_TYPE || attrInfo.size <= 0) {
+        SLOG_DEBUG("attribute %s of %s is not a valid message.\n", attrName, ref->name);
+        return B_BAD_TYPE;
+    }
+
+    char* buffer = new char[attrInfo.size];
+    ssize_t bytesRead = node.ReadAttr(attrName, B_MESSAGE_TYPE, 0, buffer, attrInfo.size);
+
+    if (bytesRead < 0) {
+        result = bytesRead;
+    } else {
+        result = msg->Unflatten(buffer);
+    }
+    delete[] buffer;
+
+    if (result != B_OK) {
+        SLOG_ERROR("failed to read message attribute %s from %s: %s\n", attrName, ref->name, strerror(result));
+    }
+    return result;
 }
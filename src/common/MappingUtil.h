@@ -7,8 +7,29 @@
 #include <Bitmap.h>
 #include <Entry.h>
 #include <Message.h>
+#include <String.h>
 #include <SupportDefs.h>
 
+#include <vector>
+
+#include "AliasTable.h"
+#include "AttributeView.h"
+#include "MappingProfiles.h"
+#include "MimeSchemaCache.h"
+
+#ifndef SENSEI_ATTR_MAPPING
+#define SENSEI_ATTR_MAPPING "SENSEI:attr_mapping"
+#endif
+#ifndef SENSEI_INTERNAL_ATTRS
+#define SENSEI_INTERNAL_ATTRS "SENSEI:internal_attrs"
+#endif
+
+struct attr_write_stats {
+    int32   written;
+    int32   skipped;    // existing attributes without overwrite or with unchanged value
+    int32   failed;
+};
+
 class MappingUtil {
 
 public:
@@ -16,23 +37,80 @@ public:
     virtual ~MappingUtil();
 
     status_t AddAlias(const char* source, const char* target, bool bidir = true);
+    /**
+    * adds all aliases of a built-in mapping profile, see MappingProfiles.h
+    */
+    status_t AddAliases(const alias_def* profile, size_t count, bool bidir = true);
+    /**
+    * adds all aliases from a mapping message in "SENSEI:attr_mapping" format (alias -> attribute).
+    */
+    status_t AddAliases(const BMessage* mappingMsg, bool bidir = true);
+    /**
+    * loads a mapping profile from the attribute @attrName of the plugin binary @pluginRef,
+    * as written by resattr from the plugin's "SENSEI:attr_mapping" resource.
+    */
+    status_t LoadAliases(const entry_ref* pluginRef, const char* attrName = SENSEI_ATTR_MAPPING);
+    /**
+    * freezes the mapping into an immutable perfect hash table, no aliases can be added afterwards.
+    * A compiled mapper is safe to share read-only between threads.
+    */
+    status_t Compile();
+    bool     IsCompiled() const { return fAliasTable != NULL; }
 
-    const char* ResolveAlias(const char* alias, char* defaultValue = NULL);
+    const char* ResolveAlias(const char* alias, const char* defaultValue = NULL) const;
+    /**
+    * the aliases (service side names) added so far, e.g. to request only mapped fields from a service.
+    */
+    int32       CountAliases() const { return fAliasNames.size(); }
+    const char* AliasAt(int32 index) const;
+    /**
+    * the attribute side names added so far, in the order they were added.
+    */
+    int32       CountAttributes() const { return fAttrNames.size(); }
+    const char* AttributeAt(int32 index) const;
     /**
     * reads fs attributes with an associated mapping from the file @ref into @attrMsg,
     * using attribute names as keys.
     */
     status_t MapAttrsToMsg(const entry_ref* ref, BMessage *attrMsg);
     /**
+    * same as above but reading from an existing attribute view, only loading the values
+    * actually copied into @attrMsg. With @mappedOnly, attributes without alias are skipped.
+    */
+    status_t MapAttrsToMsg(AttributeView* attrView, BMessage *attrMsg, bool mappedOnly = false);
+    /**
     * writes message data from @attrMsg into attributes of file referenced by @ref
     * with respective types, using message keys as attribute names.
-    * Optionally overwrites existing attributes.
+    * Optionally overwrites existing attributes, but only if their value changed.
+    * All writes are done in one pass with a single sync, failures don't stop the remaining writes.
+    * If given, @stats receives the number of written, skipped and failed attributes.
     */
-    status_t MapMsgToAttrs(const BMessage* attrMsg, entry_ref* targetRef, bool overwrite = false);
+    status_t MapMsgToAttrs(const BMessage* attrMsg, entry_ref* targetRef, bool overwrite = false,
+                           attr_write_stats* stats = NULL);
 
+    static status_t GetMimeType(const entry_ref* ref, BString* mimeType);
+    /**
+    * returns the cached attribute schema of @mimeType, only queried once per type and process.
+    */
+    static status_t GetMimeTypeSchema(const char* mimeType, std::shared_ptr<const MimeSchema>& schema);
     static status_t GetMimeTypeAttrs(const entry_ref* ref, BMessage *mimeAttrMsg);
     static bool IsInternalAttr(const char* attrName);
+    /**
+    * registers additional prefixes of internal attributes, e.g. of a plugin's target application.
+    * Only call during startup, IsInternalAttr() does not lock.
+    */
+    static status_t AddInternalPrefix(const char* prefix);
+    /**
+    * loads internal prefixes from the "prefix" fields of the message attribute @attrName of @pluginRef,
+    * as written by resattr from the plugin's "SENSEI:internal_attrs" resource.
+    */
+    static status_t LoadInternalPrefixes(const entry_ref* pluginRef, const char* attrName = SENSEI_INTERNAL_ATTRS);
 
 private:
+    static status_t ReadMessageAttr(const entry_ref* ref, const char* attrName, BMessage* msg);
+
     BMessage*    fMappingTable;
+    AliasTable*  fAliasTable;
+    std::vector<BString> fAliasNames;
+    std::vector<BString> fAttrNames;
 };
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "Metrics.h"
+
+static const double kPercentiles[] = { 50, 95, 99 };
+static const char*  kPercentileNames[] = { "p50", "p95", "p99" };
+
+// Histogram
+
+Histogram::Histogram()
+    :
+    fCount(0),
+    fTotal(0),
+    fMax(0)
+{
+    for (int32 i = 0; i < kBucketCount; i++) {
+        fBuckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::Record(bigtime_t value)
+{
+    if (value < 0) {
+        value = 0;
+    }
+
+    fBuckets[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    fCount.fetch_add(1, std::memory_order_relaxed);
+    fTotal.fetch_add(value, std::memory_order_relaxed);
+
+    bigtime_t max = fMax.load(std::memory_order_relaxed);
+    while (value > max && !fMax.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+bigtime_t Histogram::Percentile(double percent) const
+{
+    int64 count = Count();
+    if (count == 0) {
+        return 0;
+    }
+
+    // nearest rank
+    int64 rank = (int64)(count * percent / 100.0 + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    int64 seen = 0;
+    for (int32 i = 0; i < kBucketCount; i++) {
+        seen += fBuckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(UpperBound(i), Max());
+        }
+    }
+    return Max();
+}
+
+/**
+* values below kSubBuckets get a bucket each, above that the position of the highest bit
+* selects the power of 2 range and the next kSubBucketBits bits the bucket within it.
+*/
+int32 Histogram::BucketFor(uint64 value)
+{
+    if (value < kSubBuckets) {
+        return value;
+    }
+    int32 magnitude = 63 - __builtin_clzll(value) - kSubBucketBits;
+    int32 subBucket = (value >> magnitude) & (kSubBuckets - 1);
+    return (magnitude + 1) * kSubBuckets + subBucket;
+}
+
+bigtime_t Histogram::UpperBound(int32 bucket)
+{
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int32 magnitude = bucket / kSubBuckets - 1;
+    uint64 lower = (uint64)(kSubBuckets + bucket % kSubBuckets) << magnitude;
+    return lower + ((uint64)1 << magnitude) - 1;
+}
+
+// Metrics
+
+Metrics::Metrics()
+    :
+    fLock("metrics")
+{
+}
+
+Metrics* Metrics::Default()
+{
+    static Metrics* sDefaultMetrics = new Metrics();
+    return sDefaultMetrics;
+}
+
+Histogram* Metrics::HistogramFor(const char* stage)
+{
+    BAutolock locker(fLock);
+
+    Histogram*& histogram = fHistograms[stage];
+    if (histogram == NULL) {
+        histogram = new Histogram();
+    }
+    return histogram;
+}
+
+std::atomic<int64>* Metrics::CounterFor(const char* name)
+{
+    BAutolock locker(fLock);
+
+    std::atomic<int64>*& counter = fCounters[name];
+    if (counter == NULL) {
+        counter = new std::atomic<int64>(0);
+    }
+    return counter;
+}
+
+status_t Metrics::AddToMessage(BMessage* msg)
+{
+    BAutolock locker(fLock);
+    BMessage metrics;
+
+    for (auto it = fHistograms.begin(); it != fHistograms.end(); it++) {
+        const Histogram* histogram = it->second;
+        if (histogram->Count() == 0) {
+            continue;
+        }
+        BMessage stage;
+        stage.AddInt64("count", histogram->Count());
+        stage.AddInt64("total", histogram->Total());
+        for (size_t i = 0; i < sizeof(kPercentiles) / sizeof(kPercentiles[0]); i++) {
+            stage.AddInt64(kPercentileNames[i], histogram->Percentile(kPercentiles[i]));
+        }
+        stage.AddInt64("max", histogram->Max());
+        metrics.AddMessage(it->first.c_str(), &stage);
+    }
+    for (auto it = fCounters.begin(); it != fCounters.end(); it++) {
+        metrics.AddInt64(it->first.c_str(), it->second->load(std::memory_order_relaxed));
+    }
+
+    return msg->AddMessage("metrics", &metrics);
+}
+
+status_t Metrics::WriteJson(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return B_ERROR;
+    }
+
+    BAutolock locker(fLock);
+
+    // names are plain identifiers, nothing to escape; times are in microseconds
+    fprintf(file, "{\n  \"stages\": {");
+    const char* separator = "\n";
+    for (auto it = fHistograms.begin(); it != fHistograms.end(); it++) {
+        const Histogram* histogram = it->second;
+        if (histogram->Count() == 0) {
+            continue;
+        }
+        fprintf(file, "%s    \"%s\": { \"count\": %" B_PRId64 ", \"total\": %" B_PRId64,
+            separator, it->first.c_str(), histogram->Count(), histogram->Total());
+        for (size_t i = 0; i < sizeof(kPercentiles) / sizeof(kPercentiles[0]); i++) {
+            fprintf(file, ", \"%s\": %" B_PRId64, kPercentileNames[i],
+                histogram->Percentile(kPercentiles[i]));
+        }
+        fprintf(file, ", \"max\": %" B_PRId64 " }", histogram->Max());
+        separator = ",\n";
+    }
+    fprintf(file, "\n  },\n  \"counters\": {");
+    separator = "\n";
+    for (auto it = fCounters.begin(); it != fCounters.end(); it++) {
+        fprintf(file, "%s    \"%s\": %" B_PRId64, separator, it->first.c_str(),
+            it->second->load(std::memory_order_relaxed));
+        separator = ",\n";
+    }
+    fprintf(file, "\n  }\n}\n");
+
+    status_t result = ferror(file) ? B_IO_ERROR : B_OK;
+    if (fclose(file) != 0) {
+        result = B_IO_ERROR;
+    }
+    return result;
+}
+
+status_t Metrics::Export()
+{
+    const char* path = getenv("SENSEI_METRICS_FILE");
+    if (path == NULL || path[0] == '\0') {
+        return B_OK;
+    }
+    return WriteJson(path);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <Message.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+
+/**
+* latency histogram with bounded relative error, after HdrHistogram.
+* Each power of 2 range is split into kSubBuckets linear buckets, so every recorded value is
+* off by at most 1/kSubBuckets (about 6%) from its bucket, from microseconds to days.
+* Recording is lock-free and may happen from any thread.
+*/
+class Histogram {
+
+public:
+    Histogram();
+
+    void        Record(bigtime_t value);
+
+    int64       Count() const { return fCount.load(std::memory_order_relaxed); }
+    bigtime_t   Total() const { return fTotal.load(std::memory_order_relaxed); }
+    bigtime_t   Max() const { return fMax.load(std::memory_order_relaxed); }
+    // upper bound of the bucket holding the @percent percentile, 0 if nothing was recorded
+    bigtime_t   Percentile(double percent) const;
+
+private:
+    enum {
+        kSubBucketBits = 4,
+        kSubBuckets = 1 << kSubBucketBits,
+        kMagnitudes = 64 - kSubBucketBits,
+        kBucketCount = (kMagnitudes + 1) * kSubBuckets
+    };
+
+    static int32        BucketFor(uint64 value);
+    static bigtime_t    UpperBound(int32 bucket);
+
+    std::atomic<int64>      fBuckets[kBucketCount];
+    std::atomic<int64>      fCount;
+    std::atomic<bigtime_t>  fTotal;
+    std::atomic<bigtime_t>  fMax;
+};
+
+/**
+* process-wide registry of named stage histograms and counters shared by all SENSEI plugins.
+* Names are grouped by a dotted prefix like "http.fetch", histograms and counters are created
+* on first use and live as long as the process, so pointers to them may be kept.
+* A summary is added to the plugin reply, and written as JSON to the file named by the
+* environment variable SENSEI_METRICS_FILE if set.
+*/
+class Metrics {
+
+public:
+    static Metrics*     Default();
+
+    Histogram*          HistogramFor(const char* stage);
+    std::atomic<int64>* CounterFor(const char* name);
+
+    // adds a "metrics" message with a message per stage and a field per counter
+    status_t            AddToMessage(BMessage* msg);
+    status_t            WriteJson(const char* path);
+    // writes to SENSEI_METRICS_FILE if set, returns B_OK otherwise
+    status_t            Export();
+
+private:
+    Metrics();
+
+    BLocker                                         fLock;
+    std::map<std::string, Histogram*>               fHistograms;
+    std::map<std::string, std::atomic<int64>*>      fCounters;
+};
+
+/**
+* records the time from its construction to its destruction in a stage histogram.
+*/
+class StageTimer {
+
+public:
+    StageTimer(Histogram* histogram)
+        :
+        fHistogram(histogram),
+        fStart(system_time())
+    {
+    }
+
+    ~StageTimer()
+    {
+        fHistogram->Record(system_time() - fStart);
+    }
+
+private:
+    Histogram*  fHistogram;
+    bigtime_t   fStart;
+};
+
+// metrics can be compiled out entirely with -DSENSEI_NO_METRICS
+#ifndef SENSEI_NO_METRICS
+
+// times the rest of the enclosing scope, only one per scope
+#define METRICS_STAGE(stage) \
+    static Histogram* const sStageHistogram = Metrics::Default()->HistogramFor(stage); \
+    StageTimer stageTimer(sStageHistogram)
+
+#define METRICS_COUNT(name, delta) \
+    do { \
+        static std::atomic<int64>* const sCounter = Metrics::Default()->CounterFor(name); \
+        sCounter->fetch_add(delta, std::memory_order_relaxed); \
+    } while (0)
+
+#else
+
+#define METRICS_STAGE(stage)        do { } while (0)
+#define METRICS_COUNT(name, delta)  do { } while (0)
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <Messenger.h>
+#include <MimeType.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "Log.h"
+#include "MimeSchemaCache.h"
+
+/**
+* receives MIME database change notifications and invalidates the affected schema.
+*/
+class MimeSchemaWatcher : public BLooper {
+
+public:
+    MimeSchemaWatcher(MimeSchemaCache* cache)
+        :
+        BLooper("mime schema watcher"),
+        fCache(cache)
+    {
+    }
+
+    virtual void MessageReceived(BMessage* message)
+    {
+        if (message->what != B_META_MIME_CHANGED) {
+            BLooper::MessageReceived(message);
+            return;
+        }
+        // we don't care what exactly changed, the next lookup will just fetch the schema again
+        const char* type = message->GetString("be:type", NULL);
+        fCache->Invalidate(type);
+    }
+
+private:
+    MimeSchemaCache* fCache;
+};
+
+// MimeSchema
+
+MimeSchema::MimeSchema()
+{
+}
+
+type_code MimeSchema::TypeOf(const char* attrName, type_code defaultType) const
+{
+    int32 index = IndexOf(attrName);
+    return index < 0 ? defaultType : fEntries[index].type;
+}
+
+bool MimeSchema::HasAttr(const char* attrName) const
+{
+    return IndexOf(attrName) >= 0;
+}
+
+const char* MimeSchema::NameAt(int32 index) const
+{
+    if (index < 0 || index >= CountAttrs()) {
+        return NULL;
+    }
+    return &fNames[fEntries[index].nameOffset];
+}
+
+type_code MimeSchema::TypeAt(int32 index) const
+{
+    if (index < 0 || index >= CountAttrs()) {
+        return 0;
+    }
+    return fEntries[index].type;
+}
+
+status_t MimeSchema::AddToMessage(BMessage* msg) const
+{
+    for (int32 i = 0; i < CountAttrs(); i++) {
+        status_t result = msg->AddInt32(NameAt(i), TypeAt(i));
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
+
+int32 MimeSchema::IndexOf(const char* attrName) const
+{
+    const char* names = fNames.data();
+    auto it = std::lower_bound(fEntries.begin(), fEntries.end(), attrName,
+        [names](const Entry& entry, const char* name) {
+            return strcmp(names + entry.nameOffset, name) < 0;
+        });
+
+    if (it == fEntries.end() || strcmp(names + it->nameOffset, attrName) != 0) {
+        return -1;
+    }
+    return it - fEntries.begin();
+}
+
+// MimeSchemaCache
+
+MimeSchemaCache::MimeSchemaCache()
+    :
+    fLock("mime schema cache"),
+    fWatcher(NULL)
+{
+}
+
+MimeSchemaCache::~MimeSchemaCache()
+{
+    if (fWatcher != NULL) {
+        BMimeType::StopWatching(BMessenger(fWatcher));
+        if (fWatcher->Lock()) {
+            fWatcher->Quit();
+        }
+    }
+}
+
+MimeSchemaCache* MimeSchemaCache::Default()
+{
+    // lives as long as the process, just like the registrar connection it depends on
+    static MimeSchemaCache* sDefaultCache = new MimeSchemaCache();
+    return sDefaultCache;
+}
+
+status_t MimeSchemaCache::GetSchema(const char* mimeType, std::shared_ptr<const MimeSchema>& schema)
+{
+    BAutolock locker(fLock);
+
+    if (fWatcher == NULL) {
+        // without notifications we still cache, but cannot pick up changes while running
+        if (StartWatching() != B_OK) {
+            SLOG_ERROR("could not watch MIME database for changes, schema updates need a restart.\n");
+        }
+    }
+
+    auto it = fSchemas.find(mimeType);
+    if (it != fSchemas.end()) {
+        schema = it->second;
+        return B_OK;
+    }
+
+    std::shared_ptr<MimeSchema> newSchema = std::make_shared<MimeSchema>();
+    status_t result = LoadSchema(mimeType, newSchema.get());
+    if (result != B_OK) {
+        return result;
+    }
+
+    fSchemas[mimeType] = newSchema;
+    schema = newSchema;
+
+    return B_OK;
+}
+
+void MimeSchemaCache::Invalidate(const char* mimeType)
+{
+    BAutolock locker(fLock);
+
+    if (mimeType == NULL) {
+        fSchemas.clear();
+    } else {
+        fSchemas.erase(mimeType);
+    }
+}
+
+status_t MimeSchemaCache::StartWatching()
+{
+    MimeSchemaWatcher* watcher = new MimeSchemaWatcher(this);
+    watcher->Run();
+
+    status_t result = BMimeType::StartWatching(BMessenger(watcher));
+    if (result != B_OK) {
+        if (watcher->Lock()) {
+            watcher->Quit();
+        }
+        return result;
+    }
+
+    fWatcher = watcher;
+    return B_OK;
+}
+
+status_t MimeSchemaCache::LoadSchema(const char* mimeType, MimeSchema* schema)
+{
+    BMimeType type(mimeType);
+    BMessage attrInfoMsg;
+
+    status_t result = type.GetAttrInfo(&attrInfoMsg);
+    if (result != B_OK) {
+        SLOG_ERROR("failed to get attrInfo for MIME type %s: %s\n", mimeType, strerror(result));
+        return result;
+    }
+
+    type_code typeCode;
+    int32 count = 0;
+    attrInfoMsg.GetInfo("attr:name", &typeCode, &count);
+
+    std::vector<std::pair<std::string, type_code> > attrs;
+    attrs.reserve(count);
+
+    for (int32 info = 0; info < count; info++) {
+        const char* attrName = attrInfoMsg.GetString("attr:name", info, NULL);
+        if (attrName == NULL) {
+            SLOG_ERROR("failed to get MIME attribute info for attribute: could not get 'attr:name'!\n");
+            return B_ERROR;
+        }
+        int32 attrType = attrInfoMsg.GetInt32("attr:type", info, -1);
+        if (attrType < 0) {
+            SLOG_ERROR("failed to get attribute type 'attr:type' for attribute %s\n", attrName);
+            return B_ERROR;
+        }
+        attrs.push_back(std::make_pair(std::string(attrName), (type_code)attrType));
+    }
+
+    // keep the first definition of duplicate names, like BMessage::GetInt32() did before
+    std::stable_sort(attrs.begin(), attrs.end(),
+        [](const std::pair<std::string, type_code>& a, const std::pair<std::string, type_code>& b) {
+            return a.first < b.first;
+        });
+
+    for (size_t i = 0; i < attrs.size(); i++) {
+        if (i > 0 && attrs[i].first == attrs[i - 1].first) {
+            continue;
+        }
+        MimeSchema::Entry entry;
+        entry.nameOffset = schema->fNames.size();
+        entry.type = attrs[i].second;
+
+        schema->fNames.insert(schema->fNames.end(), attrs[i].first.begin(), attrs[i].first.end());
+        schema->fNames.push_back('\0');
+        schema->fEntries.push_back(entry);
+    }
+
+    return B_OK;
+}
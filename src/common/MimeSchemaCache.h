@@ -0,0 +1,72 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <Looper.h>
+#include <Message.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+* compact attribute schema of a MIME type: attribute names sorted for binary search with their type codes.
+*/
+class MimeSchema {
+
+public:
+    MimeSchema();
+
+    type_code   TypeOf(const char* attrName, type_code defaultType = B_STRING_TYPE) const;
+    bool        HasAttr(const char* attrName) const;
+
+    int32       CountAttrs() const { return fEntries.size(); }
+    const char* NameAt(int32 index) const;
+    type_code   TypeAt(int32 index) const;
+
+    // adds name/type pairs to @msg in the format of MappingUtil::GetMimeTypeAttrs()
+    status_t    AddToMessage(BMessage* msg) const;
+
+private:
+    friend class MimeSchemaCache;
+
+    struct Entry {
+        uint32      nameOffset;
+        type_code   type;
+    };
+
+    int32       IndexOf(const char* attrName) const;
+
+    std::vector<Entry>  fEntries;
+    std::vector<char>   fNames;
+};
+
+/**
+* process-wide cache of MIME type attribute schemas, so the MIME database is only queried once
+* per type and process. Entries are dropped when the registrar reports a change of the type.
+*/
+class MimeSchemaCache {
+
+public:
+    static MimeSchemaCache* Default();
+
+    status_t    GetSchema(const char* mimeType, std::shared_ptr<const MimeSchema>& schema);
+    // drops the schema of @mimeType, or all schemas if NULL
+    void        Invalidate(const char* mimeType = NULL);
+
+private:
+    MimeSchemaCache();
+    ~MimeSchemaCache();
+
+    status_t    StartWatching();
+    status_t    LoadSchema(const char* mimeType, MimeSchema* schema);
+
+    BLocker     fLock;
+    BLooper*    fWatcher;
+    std::map<std::string, std::shared_ptr<const MimeSchema> > fSchemas;
+};
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+#include <string.h>
+
+/**
+* prefix matcher with a first-byte dispatch table generated at compile time.
+* Each byte maps to a bit mask of the prefixes starting with it, so a lookup only compares
+* the few candidates sharing the first byte and never allocates.
+*/
+template<size_t N>
+class PrefixTable {
+
+public:
+    static_assert(N > 0 && N <= 64, "prefix table supports 1 to 64 prefixes");
+
+    constexpr PrefixTable(const char* const (&prefixes)[N])
+        :
+        fPrefixes(),
+        fLengths(),
+        fMasks()
+    {
+        for (size_t i = 0; i < N; i++) {
+            fPrefixes[i] = prefixes[i];
+            fLengths[i] = ConstLength(prefixes[i]);
+            fMasks[static_cast<uint8>(prefixes[i][0])] |= 1ULL << i;
+        }
+    }
+
+    bool Matches(const char* name) const
+    {
+        uint64 mask = fMasks[static_cast<uint8>(name[0])];
+
+        while (mask != 0) {
+            int index = __builtin_ctzll(mask);
+            mask &= mask - 1;
+
+            if (strncmp(name, fPrefixes[index], fLengths[index]) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static constexpr size_t ConstLength(const char* str)
+    {
+        size_t length = 0;
+        while (str[length] != '\0') {
+            length++;
+        }
+        return length;
+    }
+
+    const char* fPrefixes[N];
+    size_t      fLengths[N];
+    uint64      fMasks[256];
+};
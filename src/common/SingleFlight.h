@@ -0,0 +1,199 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Autolock.h>
+#include <Locker.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+/**
+* coalesces concurrent calls for the same key into one.
+* The first caller for a key runs the call, callers arriving while it is in flight wait for it
+* and get a copy of its result and status instead of running it again. Results are not kept
+* after the call finished, caching is up to the caller.
+* B_CANCELED and B_TIMED_OUT only concern the caller that ran the call, its waiters do not get
+* them but retry, one of them running the call again.
+* @Result needs to be default constructible and copyable, use a shared_ptr for large results.
+*/
+template<typename Result>
+class SingleFlight {
+
+public:
+    typedef std::function<status_t(Result* result)> call_func;
+
+    SingleFlight(const char* name)
+        :
+        fName(name),
+        fLock(name),
+        fCalls(0),
+        fCoalesced(0)
+    {
+    }
+
+    /**
+    * runs @func for @key unless a call for it is already in flight.
+    * @coalesced is set to true if the result was taken from another caller.
+    * While waiting for another caller, gives up with B_TIMED_OUT at the absolute @deadline and
+    * with B_CANCELED as soon as *@canceled is set.
+    */
+    status_t Do(const std::string& key, Result* result, call_func func, bool* coalesced = NULL,
+        bigtime_t deadline = B_INFINITE_TIMEOUT, const int32* canceled = NULL)
+    {
+        std::shared_ptr<Call> call;
+        bool leader = false;
+        {
+            BAutolock locker(fLock);
+            fCalls++;
+        }
+
+        while (!leader) {
+            {
+                BAutolock locker(fLock);
+                auto it = fInFlight.find(key);
+                if (it != fInFlight.end()) {
+                    call = it->second;
+                    call->waiters++;
+                } else {
+                    call = std::make_shared<Call>(fName);
+                    fInFlight[key] = call;
+                    leader = true;
+                }
+            }
+            if (leader) {
+                break;
+            }
+
+            status_t status = Wait(call, deadline, canceled);
+            if (status != B_OK) {
+                BAutolock locker(fLock);
+                call->waiters--;
+                return status;
+            }
+            if (call->status == B_CANCELED || call->status == B_TIMED_OUT) {
+                // the other caller gave up, which says nothing about the call itself
+                continue;
+            }
+
+            // only a result actually taken over saved a call, not giving up or retrying
+            {
+                BAutolock locker(fLock);
+                fCoalesced++;
+            }
+            if (coalesced != NULL) {
+                *coalesced = true;
+            }
+            *result = call->result;
+            return call->status;
+        }
+
+        // waiters must never be left behind, even if the call throws
+        status_t status;
+        try {
+            status = func(result);
+        } catch (const std::bad_alloc&) {
+            Finish(key, call, B_NO_MEMORY, NULL);
+            throw;
+        } catch (...) {
+            Finish(key, call, B_ERROR, NULL);
+            throw;
+        }
+        Finish(key, call, status, result);
+
+        if (coalesced != NULL) {
+            *coalesced = false;
+        }
+        return status;
+    }
+
+    void GetStats(int64* calls, int64* coalesced)
+    {
+        BAutolock locker(fLock);
+        *calls = fCalls;
+        *coalesced = fCoalesced;
+    }
+
+private:
+    static const bigtime_t kCancelPollInterval = 10000;
+
+    struct Call {
+        Call(const char* name)
+            :
+            done(create_sem(0, name)),
+            waiters(0),
+            status(B_OK)
+        {
+        }
+
+        ~Call()
+        {
+            delete_sem(done);
+        }
+
+        sem_id      done;
+        int32       waiters;
+        status_t    status;
+        Result      result;
+    };
+
+    // the semaphore is released once the result is published
+    status_t Wait(const std::shared_ptr<Call>& call, bigtime_t deadline, const int32* canceled)
+    {
+        for (;;) {
+            if (canceled != NULL && atomic_get(const_cast<int32*>(canceled)) != 0) {
+                return B_CANCELED;
+            }
+
+            // the cancel flag has no way to wake us, so it is polled
+            bigtime_t timeout = deadline;
+            if (canceled != NULL) {
+                timeout = std::min(deadline, system_time() + kCancelPollInterval);
+            }
+
+            status_t status = acquire_sem_etc(call->done, 1, B_ABSOLUTE_TIMEOUT, timeout);
+            if (status == B_OK) {
+                return B_OK;
+            }
+            if (status == B_TIMED_OUT && timeout >= deadline) {
+                return B_TIMED_OUT;
+            }
+            if (status != B_TIMED_OUT && status != B_INTERRUPTED) {
+                return status;
+            }
+        }
+    }
+
+    // takes @key out of flight and hands @status and @result, if any, to all waiters
+    void Finish(const std::string& key, const std::shared_ptr<Call>& call, status_t status,
+        const Result* result)
+    {
+        int32 waiters;
+        {
+            BAutolock locker(fLock);
+            fInFlight.erase(key);
+            waiters = call->waiters;
+        }
+        if (waiters > 0) {
+            call->status = status;
+            if (result != NULL) {
+                call->result = *result;
+            }
+            release_sem_etc(call->done, waiters, 0);
+        }
+    }
+
+    const char*     fName;
+    BLocker         fLock;
+    std::unordered_map<std::string, std::shared_ptr<Call> > fInFlight;
+    int64           fCalls;
+    int64           fCoalesced;
+};
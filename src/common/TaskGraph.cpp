@@ -0,0 +1,166 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <string.h>
+
+#include "Log.h"
+#include "TaskGraph.h"
+
+struct task_start_info {
+    TaskGraph*  graph;
+    int32       task;
+};
+
+TaskGraph::TaskGraph(const char* name)
+    :
+    fName(name),
+    fLock(name),
+    fDoneSem(create_sem(0, name)),
+    fWaitCount(0),
+    fRunning(false)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+    // tasks reference data owned by our caller, never leave them running
+    Wait();
+    delete_sem(fDoneSem);
+}
+
+int32 TaskGraph::AddTask(const char* name, task_func func, const std::vector<int32>& dependencies)
+{
+    BAutolock locker(fLock);
+    if (fRunning) {
+        return B_NOT_ALLOWED;
+    }
+
+    int32 id = fTasks.size();
+    fTasks.push_back(Task{ name, func, std::vector<int32>(), 0, B_OK, false });
+
+    for (size_t i = 0; i < dependencies.size(); i++) {
+        int32 dependency = dependencies[i];
+        if (dependency < 0 || dependency >= id) {
+            continue;   // failed to add or not added before, nothing to wait for
+        }
+        fTasks[dependency].dependents.push_back(id);
+        fTasks[id].pending++;
+    }
+
+    return id;
+}
+
+status_t TaskGraph::Run()
+{
+    if (fDoneSem < 0) {
+        return fDoneSem;
+    }
+
+    BAutolock locker(fLock);
+    if (fRunning) {
+        return B_NOT_ALLOWED;
+    }
+    fRunning = true;
+    fWaitCount = fTasks.size();
+
+    for (size_t i = 0; i < fTasks.size(); i++) {
+        if (fTasks[i].pending == 0) {
+            Start(i);
+        }
+    }
+    return B_OK;
+}
+
+status_t TaskGraph::Wait()
+{
+    int32 count;
+    {
+        BAutolock locker(fLock);
+        count = fWaitCount;
+        fWaitCount = 0;
+    }
+    if (count > 0) {
+        while (acquire_sem_etc(fDoneSem, count, 0, 0) == B_INTERRUPTED)
+            ;
+    }
+
+    BAutolock locker(fLock);
+    for (size_t i = 0; i < fTasks.size(); i++) {
+        if (fTasks[i].status != B_OK) {
+            return fTasks[i].status;
+        }
+    }
+    return B_OK;
+}
+
+status_t TaskGraph::StatusOf(int32 task)
+{
+    BAutolock locker(fLock);
+    if (task < 0 || task >= (int32)fTasks.size()) {
+        return B_BAD_INDEX;
+    }
+    return fTasks[task].status;
+}
+
+void TaskGraph::Start(int32 task)
+{
+    task_start_info* info = new task_start_info{ this, task };
+
+    thread_id thread = spawn_thread(TaskThread, fTasks[task].name, B_NORMAL_PRIORITY, info);
+    if (thread < 0) {
+        SLOG_ERROR("could not spawn thread for task %s: %s\n", fTasks[task].name, strerror(thread));
+        delete info;
+        // fLock is recursive, so this is fine while we are called with it held
+        Finish(task, thread);
+        return;
+    }
+    resume_thread(thread);
+}
+
+status_t TaskGraph::TaskThread(void* data)
+{
+    task_start_info* info = static_cast<task_start_info*>(data);
+    TaskGraph* graph = info->graph;
+    int32 task = info->task;
+    delete info;
+
+    status_t status = graph->fTasks[task].func();
+    graph->Finish(task, status);
+
+    return status;
+}
+
+void TaskGraph::Finish(int32 task, status_t status)
+{
+    BAutolock locker(fLock);
+    std::vector<int32> finished(1, task);
+    fTasks[task].status = status;
+    fTasks[task].done = true;
+
+    SLOG_DEBUG("%s: task %s finished: %s\n", fName, fTasks[task].name, strerror(status));
+
+    // release dependents, cancelling everything downstream of a failed task
+    for (size_t i = 0; i < finished.size(); i++) {
+        Task& current = fTasks[finished[i]];
+
+        for (size_t d = 0; d < current.dependents.size(); d++) {
+            int32 dependent = current.dependents[d];
+            Task& next = fTasks[dependent];
+
+            if (next.done) {
+                continue;
+            }
+            if (current.status != B_OK) {
+                next.status = B_CANCELED;
+                next.done = true;
+                finished.push_back(dependent);
+            } else if (--next.pending == 0 && next.status == B_OK) {
+                Start(dependent);
+            }
+        }
+    }
+
+    release_sem_etc(fDoneSem, finished.size(), 0);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <functional>
+#include <vector>
+
+/**
+* runs a small graph of dependent tasks, each task is started in its own thread as soon as
+* all of its dependencies have finished successfully.
+* If a dependency fails, its dependents are not run and report B_CANCELED.
+* All tasks need to be added before Run(), data passed between tasks is safe to access from
+* a dependent task because completion of a task is published under the graph lock.
+*/
+class TaskGraph {
+
+public:
+    typedef std::function<status_t()> task_func;
+
+    TaskGraph(const char* name);
+    ~TaskGraph();
+
+    // returns the task ID to be used in dependency lists
+    int32       AddTask(const char* name, task_func func,
+                        const std::vector<int32>& dependencies = std::vector<int32>());
+
+    status_t    Run();
+    // waits for all tasks to finish, returns the first error of any task
+    status_t    Wait();
+
+    status_t    StatusOf(int32 task);
+
+private:
+    struct Task {
+        const char*         name;
+        task_func           func;
+        std::vector<int32>  dependents;
+        int32               pending;        // unfinished dependencies
+        status_t            status;
+        bool                done;
+    };
+
+    static status_t TaskThread(void* data);
+
+    void        Start(int32 task);          // needs fLock
+    void        Finish(int32 task, status_t status);
+
+    const char*         fName;
+    BLocker             fLock;
+    std::vector<Task>   fTasks;
+    sem_id              fDoneSem;
+    int32               fWaitCount;
+    bool                fRunning;
+};
@@ -0,0 +1,438 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <String.h>
+#include <ctype.h>
+#include <math.h>
+#include <parsedate.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "TypeConverter.h"
+
+// indices into the converter matrix
+enum value_kind {
+    KIND_INT32 = 0,
+    KIND_INT64,
+    KIND_DOUBLE,
+    KIND_FLOAT,
+    KIND_BOOL,
+    KIND_STRING,
+    KIND_TIME,
+    KIND_COUNT
+};
+
+// separates the values of multi-valued string attributes
+static const char   kValueSeparator = ';';
+static const size_t kFormatBufferSize = 64;
+
+// seconds since the epoch, a type of its own so it is formatted and parsed as a date
+struct time_value {
+    int64 seconds;
+};
+
+template<int32 Kind> struct ValueOf;
+template<> struct ValueOf<KIND_INT32>  { typedef int32 type; static constexpr type_code code = B_INT32_TYPE; };
+template<> struct ValueOf<KIND_INT64>  { typedef int64 type; static constexpr type_code code = B_INT64_TYPE; };
+template<> struct ValueOf<KIND_DOUBLE> { typedef double type; static constexpr type_code code = B_DOUBLE_TYPE; };
+template<> struct ValueOf<KIND_FLOAT>  { typedef float type; static constexpr type_code code = B_FLOAT_TYPE; };
+template<> struct ValueOf<KIND_BOOL>   { typedef bool type; static constexpr type_code code = B_BOOL_TYPE; };
+template<> struct ValueOf<KIND_STRING> { typedef std::string_view type; static constexpr type_code code = B_STRING_TYPE; };
+template<> struct ValueOf<KIND_TIME>   { typedef time_value type; static constexpr type_code code = B_TIME_TYPE; };
+
+static constexpr int32 KindOf(type_code type)
+{
+    switch (type) {
+        case B_INT32_TYPE:  return KIND_INT32;
+        case B_INT64_TYPE:  return KIND_INT64;
+        case B_DOUBLE_TYPE: return KIND_DOUBLE;
+        case B_FLOAT_TYPE:  return KIND_FLOAT;
+        case B_BOOL_TYPE:   return KIND_BOOL;
+        case B_STRING_TYPE: return KIND_STRING;
+        case B_TIME_TYPE:   return KIND_TIME;
+        default:            return -1;
+    }
+}
+
+static std::string_view Trim(std::string_view value)
+{
+    while (!value.empty() && isspace((unsigned char)value.front())) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && isspace((unsigned char)value.back())) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+// reading raw message data
+
+template<typename T>
+static bool Read(const void* data, ssize_t size, T* value)
+{
+    if (size != sizeof(T)) {
+        return false;
+    }
+    memcpy(value, data, sizeof(T));
+    return true;
+}
+
+static bool Read(const void* data, ssize_t size, std::string_view* value)
+{
+    // the size includes the terminating NUL
+    const char* string = reinterpret_cast<const char*>(data);
+    *value = std::string_view(string, size > 0 ? strnlen(string, size) : 0);
+    return true;
+}
+
+static bool Read(const void* data, ssize_t size, time_value* value)
+{
+    // time_t is 32 bit on x86
+    if (size == sizeof(int32)) {
+        int32 seconds;
+        memcpy(&seconds, data, sizeof(seconds));
+        value->seconds = seconds;
+        return true;
+    }
+    return Read(data, size, &value->seconds);
+}
+
+// converting single values, returns false if @from cannot be represented as To
+
+template<typename To, typename From>
+static bool Cast(From from, To* to)
+{
+    static_assert(std::is_arithmetic<From>::value && std::is_arithmetic<To>::value);
+
+    if constexpr (std::is_same<To, bool>::value) {
+        *to = from != 0;
+    } else if constexpr (std::is_integral<To>::value && std::is_floating_point<From>::value) {
+        // like the service results we get, years and counts come as doubles
+        double value = floor(from);
+        if (!(value >= (double)std::numeric_limits<To>::min()
+                && value <= (double)std::numeric_limits<To>::max())) {
+            return false;
+        }
+        *to = static_cast<To>(value);
+    } else if constexpr (std::is_integral<To>::value) {
+        // all our integer types are signed
+        if constexpr (sizeof(From) > sizeof(To)) {
+            if (from < (From)std::numeric_limits<To>::min() || from > (From)std::numeric_limits<To>::max()) {
+                return false;
+            }
+        }
+        *to = static_cast<To>(from);
+    } else {
+        *to = static_cast<To>(from);
+    }
+    return true;
+}
+
+template<typename To>
+static bool Cast(time_value from, To* to)
+{
+    return Cast(from.seconds, to);
+}
+
+template<typename From>
+static bool Cast(From from, time_value* to)
+{
+    return Cast(from, &to->seconds);
+}
+
+static bool Cast(time_value from, time_value* to)
+{
+    *to = from;
+    return true;
+}
+
+template<typename To>
+static bool Cast(std::string_view from, To* to)
+{
+    from = Trim(from);
+    if (from.empty()) {
+        return false;
+    }
+
+    if constexpr (std::is_same<To, bool>::value) {
+        static const char* kTrue[] = { "true", "yes", "1" };
+        static const char* kFalse[] = { "false", "no", "0" };
+        for (size_t i = 0; i < sizeof(kTrue) / sizeof(kTrue[0]); i++) {
+            if (from.size() == strlen(kTrue[i]) && strncasecmp(from.data(), kTrue[i], from.size()) == 0) {
+                *to = true;
+                return true;
+            }
+            if (from.size() == strlen(kFalse[i]) && strncasecmp(from.data(), kFalse[i], from.size()) == 0) {
+                *to = false;
+                return true;
+            }
+        }
+        return false;
+    } else if constexpr (std::is_integral<To>::value) {
+        auto result = std::from_chars(from.data(), from.data() + from.size(), *to);
+        return result.ec == std::errc() && result.ptr == from.data() + from.size();
+    } else {
+        // strtod() needs a terminated string
+        char buffer[kFormatBufferSize];
+        if (from.size() >= sizeof(buffer)) {
+            return false;
+        }
+        memcpy(buffer, from.data(), from.size());
+        buffer[from.size()] = '\0';
+
+        char* end;
+        double value = strtod(buffer, &end);
+        if (end != buffer + from.size()) {
+            return false;
+        }
+        *to = static_cast<To>(value);
+        return true;
+    }
+}
+
+static bool Cast(std::string_view from, time_value* to)
+{
+    from = Trim(from);
+
+    // book metadata often only has the year, which is taken as January 1st
+    int32 year;
+    auto result = std::from_chars(from.data(), from.data() + from.size(), year);
+    if (result.ec == std::errc() && result.ptr == from.data() + from.size()) {
+        if (from.size() != 4) {
+            return false;
+        }
+        struct tm date;
+        memset(&date, 0, sizeof(date));
+        date.tm_year = year - 1900;
+        date.tm_mday = 1;
+        to->seconds = timegm(&date);
+        return true;
+    }
+
+    char buffer[kFormatBufferSize];
+    if (from.empty() || from.size() >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, from.data(), from.size());
+    buffer[from.size()] = '\0';
+
+    time_t date = parsedate(buffer, -1);
+    if (date == -1) {
+        return false;
+    }
+    to->seconds = date;
+    return true;
+}
+
+// formatting for string targets, returns the formatted length or 0 if there is nothing to add
+
+template<typename From>
+static size_t Format(From from, char* buffer, const char** string)
+{
+    *string = buffer;
+
+    if constexpr (std::is_same<From, bool>::value) {
+        *string = from ? "true" : "false";
+        return strlen(*string);
+    } else if constexpr (std::is_integral<From>::value) {
+        return std::to_chars(buffer, buffer + kFormatBufferSize, from).ptr - buffer;
+    } else {
+        // whole numbers like years or page counts are written without fraction
+        if (from == floor(from) && fabs(from) < 1e15) {
+            return std::to_chars(buffer, buffer + kFormatBufferSize, (int64)from).ptr - buffer;
+        }
+        int length = snprintf(buffer, kFormatBufferSize, "%.*g",
+            std::numeric_limits<From>::digits10, (double)from);
+        return length > 0 ? std::min((size_t)length, kFormatBufferSize - 1) : 0;
+    }
+}
+
+static size_t Format(std::string_view from, char* /*buffer*/, const char** string)
+{
+    from = Trim(from);
+    *string = from.data();
+    return from.size();
+}
+
+static size_t Format(time_value from, char* buffer, const char** string)
+{
+    *string = buffer;
+
+    time_t seconds = from.seconds;
+    struct tm date;
+    if (gmtime_r(&seconds, &date) == NULL) {
+        return 0;
+    }
+    return strftime(buffer, kFormatBufferSize, "%Y-%m-%d", &date);
+}
+
+// adding converted values
+
+static status_t Add(BMessage* target, const char* name, int32 value) { return target->AddInt32(name, value); }
+static status_t Add(BMessage* target, const char* name, int64 value) { return target->AddInt64(name, value); }
+static status_t Add(BMessage* target, const char* name, double value) { return target->AddDouble(name, value); }
+static status_t Add(BMessage* target, const char* name, float value) { return target->AddFloat(name, value); }
+static status_t Add(BMessage* target, const char* name, bool value) { return target->AddBool(name, value); }
+
+static status_t Add(BMessage* target, const char* name, time_value value)
+{
+    // stored as time_t, like the file system does
+    time_t seconds = value.seconds;
+    return target->AddData(name, B_TIME_TYPE, &seconds, sizeof(seconds));
+}
+
+/**
+* converter from kind From to kind To, instantiated for every pair of kinds.
+* @read fetches the value at an index, so fields of a message and plain value lists share it.
+*/
+template<int32 From, int32 To, typename Reader>
+static status_t ConvertValues(Reader read, int32 count, BMessage* target, const char* targetName)
+{
+    typedef typename ValueOf<From>::type source_type;
+    typedef typename ValueOf<To>::type target_type;
+
+    const void* data;
+    ssize_t size;
+    source_type value;
+
+    if constexpr (To == KIND_STRING) {
+        BString joined;
+        char buffer[kFormatBufferSize];
+
+        for (int32 i = 0; i < count; i++) {
+            if (!read(i, &data, &size) || !Read(data, size, &value)) {
+                return B_BAD_VALUE;
+            }
+            const char* string;
+            size_t length = Format(value, buffer, &string);
+            if (length == 0) {
+                continue;
+            }
+            if (!joined.IsEmpty()) {
+                joined.Append(kValueSeparator, 1);
+            }
+            joined.Append(string, length);
+        }
+        return target->AddString(targetName, joined);
+    } else {
+        target_type result;
+        if (count < 1 || !read(0, &data, &size) || !Read(data, size, &value) || !Cast(value, &result)) {
+            return B_BAD_VALUE;
+        }
+        return Add(target, targetName, result);
+    }
+}
+
+template<int32 From, int32 To>
+static status_t ConvertField(const BMessage* source, const char* name, int32 count,
+    BMessage* target, const char* targetName)
+{
+    return ConvertValues<From, To>(
+        [source, name](int32 index, const void** data, ssize_t* size) {
+            return source->FindData(name, ValueOf<From>::code, index, data, size) == B_OK;
+        }, count, target, targetName);
+}
+
+template<int32 From, int32 To>
+static status_t ConvertValueList(const type_value* values, int32 count, BMessage* target,
+    const char* targetName)
+{
+    return ConvertValues<From, To>(
+        [values](int32 index, const void** data, ssize_t* size) {
+            *data = values[index].data;
+            *size = values[index].size;
+            return true;
+        }, count, target, targetName);
+}
+
+struct converter_entry {
+    TypeConverter::convert_func         field;
+    TypeConverter::convert_values_func  values;
+};
+
+template<int32 From, int32... To>
+static constexpr std::array<converter_entry, KIND_COUNT> ConverterRow(
+    std::integer_sequence<int32, To...>)
+{
+    return {{ { &ConvertField<From, To>, &ConvertValueList<From, To> }... }};
+}
+
+template<int32... From>
+static constexpr std::array<std::array<converter_entry, KIND_COUNT>, KIND_COUNT>
+ConverterMatrix(std::integer_sequence<int32, From...>)
+{
+    return {{ ConverterRow<From>(std::make_integer_sequence<int32, KIND_COUNT>())... }};
+}
+
+// [source kind][target kind]
+static constexpr auto kConverters = ConverterMatrix(std::make_integer_sequence<int32, KIND_COUNT>());
+
+TypeConverter::convert_func TypeConverter::Find(type_code sourceType, type_code targetType)
+{
+    int32 from = KindOf(sourceType);
+    int32 to = KindOf(targetType);
+    if (from < 0 || to < 0) {
+        return NULL;
+    }
+    return kConverters[from][to].field;
+}
+
+TypeConverter::convert_values_func TypeConverter::FindValues(type_code sourceType, type_code targetType)
+{
+    int32 from = KindOf(sourceType);
+    int32 to = KindOf(targetType);
+    if (from < 0 || to < 0) {
+        return NULL;
+    }
+    return kConverters[from][to].values;
+}
+
+bool TypeConverter::IsSupported(type_code type)
+{
+    return KindOf(type) >= 0;
+}
+
+status_t TypeConverter::Convert(const BMessage* source, const char* name, type_code targetType,
+    BMessage* target, const char* targetName)
+{
+    type_code type;
+    int32 count;
+    status_t result = source->GetInfo(name, &type, &count);
+    if (result != B_OK) {
+        return result;
+    }
+
+    convert_func convert = Find(type, targetType);
+    if (convert != NULL) {
+        return convert(source, name, count, target, targetName);
+    }
+    if (type != targetType) {
+        return B_NOT_SUPPORTED;
+    }
+
+    // nothing to convert, but still copied
+    for (int32 i = 0; i < count; i++) {
+        const void* data;
+        ssize_t size;
+        result = source->FindData(name, type, i, &data, &size);
+        if (result == B_OK) {
+            result = target->AddData(targetName, type, data, size, false);
+        }
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
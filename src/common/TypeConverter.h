@@ -0,0 +1,47 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+// a single raw value, like BMessage::FindData() returns it
+struct type_value {
+    const void* data;
+    ssize_t     size;
+};
+
+/**
+* converts message fields between the common attribute types int32, int64, double, float,
+* bool, string and time. The converters for all pairs of types form a matrix that is generated
+* at compile time, so picking one is a table lookup.
+* Conversions to string join all values of a field with ";" like multi-valued attributes are
+* stored, all others convert the first value only. Numbers are formatted on the stack, so joining
+* many values does not allocate per value.
+*/
+class TypeConverter {
+
+public:
+    /**
+    * converts the @count values of field @name in @source and adds the result as @targetName
+    * to @target. Returns B_BAD_VALUE if a value cannot be represented in the target type.
+    */
+    typedef status_t (*convert_func)(const BMessage* source, const char* name, int32 count,
+                                     BMessage* target, const char* targetName);
+
+    // same for @count values of @sourceType that are not stored in a message
+    typedef status_t (*convert_values_func)(const type_value* values, int32 count,
+                                            BMessage* target, const char* targetName);
+
+    // NULL if any of the types is not supported
+    static convert_func         Find(type_code sourceType, type_code targetType);
+    static convert_values_func  FindValues(type_code sourceType, type_code targetType);
+    static bool                 IsSupported(type_code type);
+
+    // converts field @name of @source to @targetType, field types that are not supported are
+    // only copied if both types are the same
+    static status_t     Convert(const BMessage* source, const char* name, type_code targetType,
+                                BMessage* target, const char* targetName);
+};
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <string.h>
+
+#include "Log.h"
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(const char* name, int32 workerCount)
+    :
+    fName(name),
+    fWorkerCount(workerCount < 1 ? 1 : workerCount),
+    fJobCount(0),
+    fNextJob(0),
+    fFailed(0)
+{
+}
+
+int32 WorkerPool::Run(int32 jobCount, job_func func)
+{
+    fJobCount = jobCount;
+    fNextJob = 0;
+    fFailed = 0;
+    fFunc = func;
+
+    int32 workerCount = fWorkerCount < jobCount ? fWorkerCount : jobCount;
+    std::vector<thread_id> workers;
+
+    // the calling thread is one of the workers
+    for (int32 i = 1; i < workerCount; i++) {
+        thread_id thread = spawn_thread(WorkerThread, fName, B_NORMAL_PRIORITY, this);
+        if (thread < 0) {
+            SLOG_WARN("%s: could only start %d of %d workers: %s\n",
+                fName, i, workerCount, strerror(thread));
+            break;
+        }
+        resume_thread(thread);
+        workers.push_back(thread);
+    }
+
+    RunJobs();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        status_t exitValue;
+        wait_for_thread(workers[i], &exitValue);
+    }
+
+    return fFailed;
+}
+
+status_t WorkerPool::WorkerThread(void* data)
+{
+    static_cast<WorkerPool*>(data)->RunJobs();
+    return B_OK;
+}
+
+void WorkerPool::RunJobs()
+{
+    int32 job;
+    while ((job = atomic_add(&fNextJob, 1)) < fJobCount) {
+        if (fFunc(job) != B_OK) {
+            atomic_add(&fFailed, 1);
+        }
+    }
+}
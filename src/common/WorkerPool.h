@@ -0,0 +1,43 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <functional>
+#include <vector>
+
+/**
+* runs a numbered set of independent jobs on a fixed number of worker threads.
+* Unlike the TaskGraph, which starts a thread per task, the number of threads is bounded
+* no matter how many jobs there are, so it is suitable for processing large batches.
+* Each worker takes the next job index until all are taken, so jobs should not depend on
+* each other.
+*/
+class WorkerPool {
+
+public:
+    typedef std::function<status_t(int32 index)> job_func;
+
+    WorkerPool(const char* name, int32 workerCount);
+
+    // runs @func for all indices below @jobCount on the calling thread and the workers,
+    // returns when all jobs are done with the number of jobs that did not return B_OK
+    int32       Run(int32 jobCount, job_func func);
+
+    int32       CountWorkers() const { return fWorkerCount; }
+
+private:
+    static status_t WorkerThread(void* data);
+    void        RunJobs();
+
+    const char* fName;
+    int32       fWorkerCount;
+    int32       fJobCount;
+    int32       fNextJob;
+    int32       fFailed;
+    job_func    fFunc;
+};
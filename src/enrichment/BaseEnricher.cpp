@@ -4,6 +4,14 @@
  */
 
 #include "BaseEnricher.h"
+#include "HostRateLimiter.h"
+#include "MappingPlan.h"
+#include "RequestPolicy.h"
+#include "UrlTemplate.h"
+#include "Sensei.h"
+#include "../common/Log.h"
+#include "../common/Metrics.h"
+#include "../common/SingleFlight.h"
 
 #include <DataIO.h>
 #include <MimeType.h>
@@ -17,7 +25,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fs_attr.h>
-#include <stdexcept>
+#include <optional>
 #include <string.h>
 
 #include <private/netservices2/ExclusiveBorrow.h>
@@ -30,16 +38,63 @@
 using namespace BPrivate::Network;
 using namespace std::literals;
 
+// requests answered with 429 or 503 are repeated after the pause requested by the host
+static const int32 kMaxThrottledRetries = 3;
+
+// a hedged request is sent as soon as its host took too long, checking more often is pointless
+static const bigtime_t kHedgePollInterval = 5000;
+
+static inline bool IsCanceled(const int32* canceled)
+{
+    return canceled != NULL && atomic_get(const_cast<int32*>(canceled)) != 0;
+}
+
+struct http_response {
+    BHttpStatus status;
+    BString     etag;
+    BString     lastModified;
+    bigtime_t   retryAfter = 0;
+};
+
+// shared by all enrichers and threads, like the HttpSessionPool
+static SingleFlight<BMessage>& JsonFlights()
+{
+    static SingleFlight<BMessage>* sJsonFlights = new SingleFlight<BMessage>("json requests");
+    return *sJsonFlights;
+}
+
+static SingleFlight<std::shared_ptr<const HttpBody> >& ContentFlights()
+{
+    static SingleFlight<std::shared_ptr<const HttpBody> >* sContentFlights
+        = new SingleFlight<std::shared_ptr<const HttpBody> >("http requests");
+    return *sContentFlights;
+}
+
 BaseEnricher::BaseEnricher(entry_ref* srcRef, MappingUtil* mapper)
 {
     fSourceRef = srcRef;
-    fHttpSession = new BHttpSession();
     fMapper = mapper;
+    fDeadline = B_INFINITE_TIMEOUT;
+    fCanceled = NULL;
 }
 
 BaseEnricher::~BaseEnricher()
 {
-    delete fHttpSession;
+}
+
+void BaseEnricher::SetDeadline(bigtime_t deadline)
+{
+    fDeadline = deadline;
+}
+
+void BaseEnricher::SetCancelFlag(const int32* canceled)
+{
+    fCanceled = canceled;
+}
+
+void BaseEnricher::SetMimeType(const char* mimeType)
+{
+    fMimeType = mimeType;
 }
 
 /**
@@ -47,6 +102,8 @@ BaseEnricher::~BaseEnricher()
 */
 status_t BaseEnricher::MapAttrsToServiceParams(const BMessage *attrMsg, BMessage *serviceParamMsg)
 {
+    METRICS_STAGE("enricher.map_params");
+
     // map all message data using mapping table for names and source types for values
     char *key;
     uint32 type;
@@ -58,288 +115,123 @@ status_t BaseEnricher::MapAttrsToServiceParams(const BMessage *attrMsg, BMessage
         result = attrMsg->GetInfo(B_ANY_TYPE, i, &key, &type);
 
         if (result != B_OK) {
-            printf("could not read attribute info #%d from message, skipping: %s\n", i, strerror(result));
+            SLOG_WARN("could not read attribute info #%d from message, skipping: %s\n", i, strerror(result));
             continue;
         }
 
         result = attrMsg->FindData(key, type, 0, &data, &dataSize);
         if (result != B_OK) {
-            printf("could not read attribute '%s' @%d from message, skipping: %s\n", key, i, strerror(result));
+            SLOG_WARN("could not read attribute '%s' @%d from message, skipping: %s\n", key, i, strerror(result));
             return result;
         }
 
         // translate key from attribute name to service parameter name from mapping table
         const char* paramName = fMapper->ResolveAlias(key);
         if (paramName == NULL) {
-            printf("could not find parameter mapping for attribute '%s', skipping.\n", key);
+            SLOG_WARN("could not find parameter mapping for attribute '%s', skipping.\n", key);
             continue;
         }
 
-        // todo: handle collection values for Strings (similar to CSV with "," and enclosing values with "," in quotes)
-        if (type == B_STRING_TYPE) {
-            BString valueStr(reinterpret_cast<const char*>(data), dataSize);
-
-            if (! valueStr.IsEmpty()) {
-                BStringList valueList;
-                valueStr.Split(";", true, valueList);
-                for (int i = 0; i < valueList.CountStrings(); i++) {
-                    serviceParamMsg->AddString(paramName, valueList.StringAt(i));
-                }
-            } else {
-                printf("ignoring empty string value for attribute '%s' [%s]\n", paramName, key);
-                continue;
-            }
-        } else {
-            // add typed data, only convert on demand later
-            serviceParamMsg->AddData(paramName, type, data, dataSize, false);
-        }
+        AddServiceParam(key, paramName, type, data, dataSize, serviceParamMsg);
     }
     return B_OK;
 }
 
 /**
-* map all service data from input message to attributes using mapping table for names and source types for values.
-* @serviceParamMsg  the data result from a service call using service parameters as keys.
-* @attrMsg          target arributes message with optionally prefilled attributes.
+* same as above but reading directly from the attributes of a node, only loading values that have a mapping.
 */
-status_t BaseEnricher::MapServiceParamsToAttrs(const BMessage *serviceParamMsg, BMessage *attrMsg)
+status_t BaseEnricher::MapAttrsToServiceParams(AttributeView* attrView, BMessage *serviceParamMsg)
 {
-    // get attribute definitions from MIME type
-    BMessage mimeAttrs;
-
-    status_t result = fMapper->GetMimeTypeAttrs(fSourceRef, &mimeAttrs);
+    std::shared_ptr<const MappingPlan> plan;
+    status_t result = GetMappingPlan(plan);
     if (result != B_OK) {
-        printf("failed to get MIME attribute definitions: %s\n", strerror(result));
         return result;
     }
+    return plan->MapAttrsToParams(attrView, serviceParamMsg);
+}
 
-    char*       paramName;
-    type_code   type, attrType;
-    int32       count;
-    const void* data;
-    ssize_t     dataSize;
-
-    for (int32 i = 0; i < serviceParamMsg->CountNames(B_ANY_TYPE); i++) {
-
-        result = serviceParamMsg->GetInfo(B_ANY_TYPE, i, &paramName, &type, &count);
-        if (result != B_OK) {
-            printf("could not read attribute info #%d from message, skipping: %s\n", i, strerror(result));
-            continue;
-        }
-
-        // translate key from service parameter name back to attribute name using the mapping table
-        const char* key = fMapper->ResolveAlias(paramName);
-        if (key == NULL) {
-            printf("no attribute mapping defined for parameter '%s', skipping.\n", paramName);
-            continue;
-        }
-
-        // get service result value
-        result = serviceParamMsg->FindData(paramName, type, &data, &dataSize);
-        if (result != B_OK) {
-            printf("could not read attribute '%s' @%d from message, skipping: %s\n", key, i, strerror(result));
-            continue;
-        }
-
-        // finish mapping and write to result message
-        switch(type) {
-            case B_MESSAGE_TYPE: {
-                printf("message mapping not supported here, try with ConvertMessageToArray().\n");
-                break;
-            }
-            // handle collection values for Strings (stored as list
-            // in service msg but as semicolon separated list in attrs)
-            case B_STRING_TYPE: {
-                BStringList values;
-                BString val;
-
-                for (int i = 0; i < count; i++) {
-                	val = serviceParamMsg->GetString(paramName, i, "");
-                	if (! val.Trim().IsEmpty()) {
-	                    values.Add(val);
-                	}
-                }
-                BString value = values.Join(";", B_ATTR_NAME_LENGTH);
-                attrMsg->AddString(key, value);
-
-                break;
-            }
-            default: {
-                // get attribute type for mapped key
-                attrType = mimeAttrs.GetInt32(key, B_STRING_TYPE);
-                void* value = NULL;
-
-                // convert values if necessary
-                if (type != attrType) {
-                    printf("conflicting types for key %s: %d (service) vs %d (attr)...\n", key, type, attrType);
-
-                    // todo: naive quick solution for current pain points, see also https://dev.haiku-os.org/ticket/19444
-                    switch(type) {
-                        case B_DOUBLE_TYPE: {
-                            double val = std::floor(*(reinterpret_cast<const double*>(data)));
-                            int32 intVal = static_cast<int32>(val);
-
-                            switch(attrType) {
-                                case B_INT32_TYPE:
-                                    attrMsg->AddInt32(key, intVal);
-                                    printf("  successfully converted Double to Int32: %u\n", intVal);
-                                    break;
-                                case B_STRING_TYPE: {
-                                    std::string strVal = std::to_string(intVal).c_str();
-                                    attrMsg->AddString(key, strVal.c_str());
-                                    printf("  successfully converted Double to String: %s\n", strVal.c_str());
-                                    break;
-                                }
-                                default:
-                                    printf("  unsupported conversion, skipping.\n");
-                            }
-                            break;
-                        }
-                        default: {
-                            printf("  not covered, falling back to system method.\n");
-                            attrMsg->AddData(key, attrType, (value != NULL) ? value : data, dataSize, false);
-                        }
-                    }
-                }
+void BaseEnricher::AddServiceParam(const char* key, const char* paramName, type_code type,
+    const void* data, ssize_t dataSize, BMessage *serviceParamMsg)
+{
+    // todo: handle collection values for Strings (similar to CSV with "," and enclosing values with "," in quotes)
+    if (type == B_STRING_TYPE) {
+        BString valueStr(reinterpret_cast<const char*>(data), dataSize);
+
+        if (! valueStr.IsEmpty()) {
+            BStringList valueList;
+            valueStr.Split(";", true, valueList);
+            for (int i = 0; i < valueList.CountStrings(); i++) {
+                serviceParamMsg->AddString(paramName, valueList.StringAt(i));
             }
+        } else {
+            SLOG_DEBUG("ignoring empty string value for attribute '%s' [%s]\n", paramName, key);
         }
+    } else {
+        // add typed data, only convert on demand later
+        serviceParamMsg->AddData(paramName, type, data, dataSize, false);
     }
-    return B_OK;
 }
 
-status_t BaseEnricher::ConvertMessageMapsToArray(const BMessage* srcMessage, BMessage* resultMsg, BStringList* keys)
+/**
+* map all service data from input message to attributes using mapping table for names and source types for values.
+* Nested arrays like those of JSON results are read in place and become multi-valued attributes.
+* @serviceParamMsg  the data result from a service call using service parameters as keys.
+* @attrMsg          target arributes message with optionally prefilled attributes.
+*/
+status_t BaseEnricher::MapServiceParamsToAttrs(const BMessage *serviceParamMsg, BMessage *attrMsg)
 {
-    status_t    result;
-
-    char*       key;
-    uint32      type;
-    int32       count;
-    const void* data;
-    ssize_t     dataSize;
-
-    for (int i = 0; i < srcMessage->CountNames(B_ANY_TYPE); i++) {
-        result = srcMessage->GetInfo(B_ANY_TYPE, i, &key, &type, &count);
-        if (result != B_OK) {
-            printf("could not read src message at index %d, aborting: %s\n", i, strerror(result));
-            return result;
-        }
-
-        result = srcMessage->FindData(key, type, &data, &dataSize);
-        if (result != B_OK) {
-            printf("could not read src message value for key %s, aborting: %s\n", key, strerror(result));
-            return result;
-        }
-
-        if ((type != B_MESSAGE_TYPE) || (keys != NULL && !(keys->HasString(key))) ) {
-            printf("not converting non-message attribute %s, adding as is.\n", key);
-
-            // still add to result as is
-            resultMsg->AddData(key, type, data, dataSize, false);
-            continue;
-        }
-
-        BMessage valueMapMsg;
-        valueMapMsg.Unflatten(reinterpret_cast<const char*>(data));
-
-        result = ConvertSingleMessageMapToArray(&valueMapMsg, key, resultMsg);
-        if (result != B_OK) {
-            return result;
-        }
+    std::shared_ptr<const MappingPlan> plan;
+    status_t result = GetMappingPlan(plan);
+    if (result != B_OK) {
+        return result;
     }
-
-    printf("successfully converted value map msg to array values:\n");
-    resultMsg->PrintToStream();
-
-    return B_OK;
+    return plan->MapResultToAttrs(serviceParamMsg, attrMsg);
 }
 
-status_t BaseEnricher::ConvertSingleMessageMapToArray(const BMessage* msg, const char* originalKey, BMessage* resultMsg)
+/**
+* the mapping plan for the MIME type of this enricher, the type is only resolved once per enricher.
+*/
+status_t BaseEnricher::GetMappingPlan(std::shared_ptr<const MappingPlan>& plan)
 {
-    if (msg == NULL) {
-        printf("no message given!\n");
-        return B_NOT_INITIALIZED;
+    status_t result = B_OK;
+    if (fMimeType.IsEmpty()) {
+        result = MappingUtil::GetMimeType(fSourceRef, &fMimeType);
     }
-
-    char*       mapKey;
-    uint32      type;
-    const void* data;
-    ssize_t     dataSize;
-    int32       count;
-    status_t    result;
-
-    for (int i = 0; i < msg->CountNames(B_ANY_TYPE); i++) {
-        result = msg->GetInfo(B_ANY_TYPE, i, &mapKey, &type, &count);
-        if (result != B_OK) {
-            printf("could not read msg info for map key at index %d, aborting: %s\n", i, strerror(result));
-            return result;
-        }
-        // check if we can/should map the entry, i.e. key is a number
-        int mapIndex;
-        try {
-            mapIndex = std::stoi(mapKey);
-        }
-        catch (std::invalid_argument const& ex)
-        {
-            printf("could not convert map key %s, skipping: %s\n", mapKey, ex.what());
-            return B_BAD_VALUE;
-        }
-        catch (std::out_of_range const& ex)
-        {
-            printf("could not convert map key %s, skipping: %s\n", mapKey, ex.what());
-            return B_BAD_VALUE;
-        }
-
-        result = msg->FindData(mapKey, type, &data, &dataSize);
-        if (result != B_OK) {
-            printf("could not read msg map data for key %s, aborting: %s\n", mapKey, strerror(result));
-            return result;
-        }
-
-        result = resultMsg->AddData(originalKey, type, data, dataSize, false);
-        if (result != B_OK) {
-            printf("could not add data for key %s to result msg, aborting: %s\n", originalKey, strerror(result));
-            return result;
-        }
+    if (result == B_OK) {
+        result = MappingPlan::Get(fMapper, fMimeType.String(), plan);
     }
-    // all done successfully!
-    return B_OK;
+    if (result != B_OK) {
+        SLOG_ERROR("failed to get attribute mapping: %s\n", strerror(result));
+    }
+    return result;
 }
 
 // HTTP query support
 
 status_t BaseEnricher::CreateHttpApiUrl(const char* apiUrlPattern, const BMessage* apiParamMapping, BUrl* resultUrl)
 {
-    BString resultStr(apiUrlPattern);
+    return CreateHttpApiUrl(UrlTemplate(apiUrlPattern), apiParamMapping, resultUrl);
+}
 
-    // replace placeholders using translation table provided
-    char        *variable;
-    const char  *value;
-    type_code   type;
-    status_t    result;
+status_t BaseEnricher::CreateHttpApiUrl(const UrlTemplate& apiUrlTemplate, const BMessage* apiParamMapping,
+    BUrl* resultUrl)
+{
+    // room for the usual short ids, so rendering does not need to grow the buffer
+    std::string url;
+    url.reserve(strlen(apiUrlTemplate.Pattern()) + 64);
 
-    for (int32 i = 0; i < apiParamMapping->CountNames(B_STRING_TYPE); i++) {
-        result = apiParamMapping->GetInfo(B_STRING_TYPE, i, &variable, &type);
-        if (result != B_OK) {
-            printf("cannot process argument mapping: %s\n", strerror(result));
-            return result;
-        }
-        // replace variable with provided value
-        value = apiParamMapping->GetString(variable);
-        if (value == NULL) {
-            printf("argument mapping is missing parameter '%s'.\n", variable);
-            return B_BAD_DATA;
-        }
-        BString placeholder(variable);
-        placeholder.Prepend("$");       // replace entire placeholder, not just variable name
-        resultStr.ReplaceAll(placeholder.String(), value);
+    status_t result = apiUrlTemplate.Render(apiParamMapping, &url);
+    if (result != B_OK) {
+        return result;
     }
 
-    *resultUrl = resultStr;
+    *resultUrl = BUrl(url.c_str(), false);
 
     return B_OK;
 }
 
-status_t BaseEnricher::FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage *msgQuery, BMessage *msgResult)
+status_t BaseEnricher::FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage *msgQuery, BMessage *msgResult,
+    const JsonProjection* projection)
 {
     BString request;
     status_t result;
@@ -359,7 +251,7 @@ status_t BaseEnricher::FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage *msgQue
             int32 valIndex = 0;
 
             if (count > 1) {
-                printf("got %d values for key %s, taking first non-empty valid value...\n", count, key);
+                SLOG_DEBUG("got %d values for key %s, taking first non-empty valid value...\n", count, key);
             }
             bool valFound = false;
             while (!valFound && valIndex < count) {
@@ -373,7 +265,7 @@ status_t BaseEnricher::FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage *msgQue
 
             if (result == B_OK) {
                 if (count > 1) {
-                    printf("got value %s at index %d\n", (const char*)data, valIndex);
+                    SLOG_DEBUG("got value %s at index %d\n", (const char*)data, valIndex);
                 }
                 if (! request.IsEmpty()) {
                     request << "&";
@@ -387,13 +279,12 @@ status_t BaseEnricher::FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage *msgQue
                         	continue;
                         // omit collections and just take first value
                         if (value.FindFirst(";") > 0) { // if separator is first char, maybe it's significant
-                            printf("value list %s split to ", value.String());
-
                             BStringList vals;
                             value.Split(";", true, vals);
-                            value = vals.StringAt(0);
 
-                            printf("%s\n", value.String());
+                            SLOG_DEBUG("value list %s split to %s\n", value.String(),
+                                vals.StringAt(0).String());
+                            value = vals.StringAt(0);
                         }
                         break;
                     }
@@ -411,94 +302,381 @@ status_t BaseEnricher::FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage *msgQue
                         break;
                     // TODO: cover remaining types!
                     default:
-                        printf("unsupported type %u, skipping.\n", type);
+                        SLOG_WARN("unsupported type %u, skipping.\n", type);
                         break;
                 }
                 request << key << "=" << BUrl::UrlEncode(value);
             } else {
-                printf("failed to fetch message data for key '%s': %s\n", key, strerror(result));
+                SLOG_ERROR("failed to fetch message data for key '%s': %s\n", key, strerror(result));
             }
         }
     }
 
     queryUrl.SetRequest(request);
 
-    return FetchRemoteJson(queryUrl, *msgResult);
+    return FetchRemoteJson(queryUrl, *msgResult, HTTP_CACHE_QUERY, projection);
 }
 
-status_t BaseEnricher::FetchRemoteJson(const BUrl& httpUrl, BMessage& jsonMsgResult)
+status_t BaseEnricher::FetchRemoteJson(const BUrl& httpUrl, BMessage& jsonMsgResult,
+    http_cache_class cacheClass, const JsonProjection* projection)
 {
-    std::string resultBody;
-    status_t result = FetchRemoteContent(httpUrl, &resultBody);
+    // the decoded result depends on the projection as well
+    char projectionKey[32];
+    snprintf(projectionKey, sizeof(projectionKey), "%p ", projection);
+    std::string key(projectionKey);
+    key += HttpCache::NormalizeUrl(httpUrl).String();
+
+    bool coalesced;
+    status_t result = JsonFlights().Do(key, &jsonMsgResult, [&](BMessage* msg) -> status_t {
+        return DecodeRemoteJson(httpUrl, *msg, cacheClass, projection);
+    }, &coalesced, fDeadline, fCanceled);
+
+    if (coalesced) {
+        SLOG_DEBUG("shared result of concurrent request for %s.\n", httpUrl.UrlString().String());
+    }
+    return result;
+}
+
+status_t BaseEnricher::DecodeRemoteJson(const BUrl& httpUrl, BMessage& jsonMsgResult,
+    http_cache_class cacheClass, const JsonProjection* projection)
+{
+    HttpBody resultBody;
+    status_t result = FetchRemoteContent(httpUrl, &resultBody, cacheClass);
+
+    if (result != B_OK) {
+        SLOG_ERROR("error accessing remote API: %s\n", strerror(result));
+        return result;
+    }
 
+    METRICS_COUNT("json.bytes", resultBody.Size());
+    METRICS_STAGE("json.decode");
+
+    if (projection == NULL) {
+        return BJson::Parse(resultBody.Data(), jsonMsgResult);
+    }
+
+    JsonDecoder decoder(projection);
+    result = decoder.Decode(resultBody.Data(), resultBody.Size(), &jsonMsgResult);
     if (result != B_OK) {
-        printf("error accessing remote API: %s\n", strerror(result));
+        SLOG_ERROR("could not decode JSON response from %s: %s\n", httpUrl.UrlString().String(), strerror(result));
         return result;
     }
+    SLOG_DEBUG("decoded JSON response, skipped %zu of %zu bytes.\n", decoder.SkippedBytes(), resultBody.Size());
 
-    return BJson::Parse(resultBody.c_str(), jsonMsgResult);
+    return B_OK;
 }
 
-status_t BaseEnricher::FetchRemoteImage(const BUrl& httpUrl, BBitmap* resultImage, size_t* imageSize)
+status_t BaseEnricher::FetchRemoteImage(const BUrl& httpUrl, BBitmap** resultImage, size_t* imageSize)
 {
-    std::string imageData;
+    *resultImage = NULL;
+
+    HttpBody imageData;
 
-    status_t result = FetchRemoteContent(httpUrl, &imageData);
+    status_t result = FetchRemoteContent(httpUrl, &imageData, HTTP_CACHE_IMAGE);
     if (result != B_OK) {
-        printf("could not access remote Url %s: %s.\n", httpUrl.UrlString().String(), strerror(result));
+        SLOG_ERROR("could not access remote Url %s: %s.\n", httpUrl.UrlString().String(), strerror(result));
         return result;
     }
 
-    *imageSize = imageData.length();
-    printf("fetched image data (%zu bytes), translating...\n", *imageSize);
+    *imageSize = imageData.Size();
+    SLOG_DEBUG("fetched image data (%zu bytes), translating...\n", *imageSize);
 
-    BMemoryIO memBuffer(imageData.c_str(), *imageSize);
-    resultImage = BTranslationUtils::GetBitmap(&memBuffer);
+    // the translators read straight from the receive buffer
+    BMemoryIO memBuffer(imageData.Data(), *imageSize);
+    BBitmap* image = BTranslationUtils::GetBitmap(&memBuffer);
 
-    if (resultImage == NULL || !resultImage->IsValid()) {
-        printf("could not handle image from %s\n", httpUrl.UrlString().String());
+    if (image == NULL || !image->IsValid()) {
+        SLOG_ERROR("could not handle image from %s\n", httpUrl.UrlString().String());
+        delete image;
         return B_BAD_DATA;
     }
 
+    *resultImage = image;
     return B_OK;
 }
 
-status_t BaseEnricher::FetchRemoteContent(const BUrl& httpUrl, std::string* resultBody)
+status_t BaseEnricher::FetchRemoteContent(const BUrl& httpUrl, HttpBody* resultBody,
+    http_cache_class cacheClass)
 {
-    auto request = BHttpRequest(httpUrl);
-    request.SetTimeout(3000 /*ms*/);
+    std::shared_ptr<const HttpBody> body;
+    bool coalesced;
 
-    auto fields = request.Fields();
-    fields.AddField("User-Agent"sv, "Haiku/SEN (Senity Book Enricher)"sv);
-    fields.AddField("Accept"sv, "*/*"sv);
+    status_t result = ContentFlights().Do(HttpCache::NormalizeUrl(httpUrl).String(), &body,
+        [&](std::shared_ptr<const HttpBody>* sharedBody) -> status_t {
+            std::shared_ptr<HttpBody> fetched = std::make_shared<HttpBody>();
+            status_t status = SendRequest(httpUrl, fetched.get(), cacheClass);
+            *sharedBody = fetched;
+            return status;
+        }, &coalesced, fDeadline, fCanceled);
 
-	auto body = make_exclusive_borrow<BMallocIO>();
-    BHttpStatus status;
+    if (result != B_OK) {
+        return result;
+    }
+    if (coalesced) {
+        SLOG_DEBUG("shared response of concurrent request for %s.\n", httpUrl.UrlString().String());
+    }
+    resultBody->Share(body);
+
+    return B_OK;
+}
 
-    printf("sending HTTP request %s...\n", httpUrl.UrlString().String());
+void BaseEnricher::GetCoalescingStats(int64* requests, int64* coalesced)
+{
+    int64 jsonRequests, jsonCoalesced;
+    JsonFlights().GetStats(&jsonRequests, &jsonCoalesced);
+    ContentFlights().GetStats(requests, coalesced);
 
+    // JSON requests that were coalesced never reached the content layer
+    *requests += jsonCoalesced;
+    *coalesced += jsonCoalesced;
+}
+
+/**
+* waits for the complete response of @result and fills in @response.
+*/
+static status_t ReadResponse(BHttpResult& result, http_response* response)
+{
     try {
-        auto result = fHttpSession->Execute(std::move(request), BBorrow<BDataIO>(body));
         // the Status() call will block until full response has been received
-        status = result.Status();
+        response->status = result.Status();
+
+        const BHttpFields& responseFields = result.Fields();
+        auto field = responseFields.FindField("ETag"sv);
+        if (field != responseFields.end()) {
+            response->etag.SetTo(field->Value().data(), field->Value().length());
+        }
+        field = responseFields.FindField("Last-Modified"sv);
+        if (field != responseFields.end()) {
+            response->lastModified.SetTo(field->Value().data(), field->Value().length());
+        }
+        field = responseFields.FindField("Retry-After"sv);
+        if (field != responseFields.end()) {
+            response->retryAfter = HostRateLimiter::ParseRetryAfter(
+                BString(field->Value().data(), field->Value().length()).String());
+        }
+
         result.Body();  // synchronize with BBorrow buffer (see HttpSession::Execute docs)
     } catch (const BPrivate::Network::BNetworkRequestError& err) {
         return err.ErrorCode();
     }
+    return B_OK;
+}
+
+static BHttpResult StartRequest(const BUrl& httpUrl, const BHttpFields& fields, bigtime_t timeout,
+    HttpBody* body)
+{
+    auto request = BHttpRequest(httpUrl);
+    request.SetTimeout(timeout);
+    request.SetFields(fields);
+
+    // the session writes directly into the buffer of the body
+    return HttpSessionPool::Default()->Session().Execute(std::move(request),
+        BBorrow<BDataIO>(body->Receiver()));
+}
+
+/**
+* sends one request for @httpUrl and waits for its response. If the host takes longer than
+* usual, a duplicate request is sent and the first response wins, its body ends up in @resultBody.
+*/
+static status_t ExecuteAttempt(const BUrl& httpUrl, const BHttpFields& fields, const char* host,
+    bigtime_t deadline, const int32* canceled, HttpBody* resultBody, http_response* response)
+{
+    HostRateLimiter* limiter = HostRateLimiter::Default();
+    RequestPolicy* policy = RequestPolicy::Default();
+
+    if (limiter->Acquire(host, deadline) != B_OK) {
+        return B_TIMED_OUT;
+    }
+    bigtime_t timeout = policy->AttemptTimeout(deadline);
+    if (timeout == 0) {
+        limiter->Release(host, 0);
+        return B_TIMED_OUT;
+    }
+
+    SLOG_DEBUG("sending HTTP request %s...\n", httpUrl.UrlString().String());
+    METRICS_COUNT("http.attempts", 1);
+    bigtime_t hedgeDelay = policy->HedgeDelay(host);
+    bigtime_t start = system_time();
+    BHttpResult primary = StartRequest(httpUrl, fields, timeout, resultBody);
+
+    HttpBody hedgeBody;
+    std::optional<BHttpResult> hedge;
+    bigtime_t hedgeStart = 0;
+
+    if (hedgeDelay > 0 && hedgeDelay < timeout) {
+        while (!primary.IsCompleted() && !IsCanceled(canceled) && system_time() - start < hedgeDelay) {
+            snooze(kHedgePollInterval);
+        }
+        // only with a free slot, hedging must not push a host over its limits
+        if (!primary.IsCompleted() && !IsCanceled(canceled) && limiter->Acquire(host, 0) == B_OK) {
+            SLOG_DEBUG("no response for %s after %" B_PRId64 " ms, hedging request.\n",
+                httpUrl.UrlString().String(), hedgeDelay / 1000);
+            hedgeStart = system_time();
+            METRICS_COUNT("http.hedged", 1);
+            hedge.emplace(StartRequest(httpUrl, fields, timeout - (hedgeStart - start), &hedgeBody));
+
+            while (!primary.IsCompleted() && !hedge->IsCompleted() && !IsCanceled(canceled)) {
+                snooze(kHedgePollInterval);
+            }
+        }
+    }
+
+    // requests that may be canceled cannot just block on the response
+    if (canceled != NULL) {
+        while (!primary.IsCompleted() && !(hedge && hedge->IsCompleted()) && !IsCanceled(canceled)) {
+            snooze(kHedgePollInterval);
+        }
+        if (!primary.IsCompleted() && !(hedge && hedge->IsCompleted())) {
+            SLOG_DEBUG("request for %s was canceled.\n", httpUrl.UrlString().String());
+            http_response ignored;
+            HttpSessionPool::Default()->Session().Cancel(primary);
+            ReadResponse(primary, &ignored);
+            limiter->Release(host, 0);
+            if (hedge) {
+                HttpSessionPool::Default()->Session().Cancel(*hedge);
+                ReadResponse(*hedge, &ignored);
+                limiter->Release(host, 0);
+            }
+            return B_CANCELED;
+        }
+    }
+
+    bool hedgeWon = hedge && !primary.IsCompleted();
+    status_t result = ReadResponse(hedgeWon ? *hedge : primary, response);
+    limiter->Release(host, result == B_OK ? response->status.code : 0, response->retryAfter);
+
+    if (result == B_OK && response->status.code < 500) {
+        policy->RecordLatency(host, system_time() - (hedgeWon ? hedgeStart : start));
+    }
+
+    if (hedge) {
+        // the session holds the body of the other request until it is finished
+        BHttpResult& loser = hedgeWon ? primary : *hedge;
+        HttpSessionPool::Default()->Session().Cancel(loser);
+        http_response ignored;
+        ReadResponse(loser, &ignored);
+        limiter->Release(host, 0);
+
+        if (hedgeWon) {
+            SLOG_DEBUG("hedged request for %s was faster.\n", httpUrl.UrlString().String());
+            METRICS_COUNT("http.hedge_wins", 1);
+            *resultBody = std::move(hedgeBody);
+        }
+    }
+    return result;
+}
+
+status_t BaseEnricher::SendRequest(const BUrl& httpUrl, HttpBody* resultBody,
+    http_cache_class cacheClass)
+{
+    METRICS_STAGE("http.fetch");
+
+    HttpCache* cache = HttpCache::Default();
+    http_cache_entry cached;
+    bool haveCached = cache->Lookup(httpUrl, cacheClass, &cached) == B_OK;
+
+    if (haveCached && cached.fresh) {
+        SLOG_DEBUG("serving %s from HTTP cache (%zu bytes).\n", httpUrl.UrlString().String(), cached.body.size());
+        resultBody->Adopt(cached.body);
+        return B_OK;
+    }
+
+    // Fields() is read-only, changes need to be set on the request explicitly
+    HttpSessionPool* pool = HttpSessionPool::Default();
+    BHttpFields fields = pool->FieldsFor(cacheClass);
+    if (haveCached) {
+        // stale entry, let the server tell us if it is still valid
+        if (!cached.etag.IsEmpty()) {
+            fields.AddField("If-None-Match"sv, std::string_view(cached.etag.String(), cached.etag.Length()));
+        }
+        if (!cached.lastModified.IsEmpty()) {
+            fields.AddField("If-Modified-Since"sv,
+                std::string_view(cached.lastModified.String(), cached.lastModified.Length()));
+        }
+    }
+
+    RequestPolicy* policy = RequestPolicy::Default();
+    BString host(httpUrl.Host());
+    host.ToLower();
+
+    http_response response;
+    int32 retries = 0;
+    int32 throttledRetries = 0;
+
+    for (;;) {
+        if (IsCanceled(fCanceled)) {
+            return B_CANCELED;
+        }
+        response = http_response();
+        status_t result = ExecuteAttempt(httpUrl, fields, host.String(), fDeadline, fCanceled, resultBody,
+            &response);
+
+        if (result == B_OK && HostRateLimiter::IsThrottled(response.status.code)) {
+            if (throttledRetries++ >= kMaxThrottledRetries) {
+                break;
+            }
+            // the limiter holds back the next attempt until the host accepts requests again
+            SLOG_DEBUG("request to %s was throttled with HTTP %d, retrying.\n",
+                httpUrl.UrlString().String(), response.status.code);
+            continue;
+        }
+
+        bigtime_t delay;
+        if (!RequestPolicy::IsTransient(result, response.status.code)
+            || retries >= policy->MaxRetries() || !policy->RetryDelay(retries, fDeadline, &delay)) {
+            if (result != B_OK) {
+                SLOG_ERROR("HTTP request for %s failed: %s\n", httpUrl.UrlString().String(),
+                    strerror(result));
+                return result;
+            }
+            break;
+        }
+        retries++;
+        METRICS_COUNT("http.retries", 1);
+        SLOG_DEBUG("HTTP request for %s failed (%s), retrying in %" B_PRId64 " ms.\n",
+            httpUrl.UrlString().String(),
+            result != B_OK ? strerror(result) : response.status.text.String(), delay / 1000);
+        snooze(delay);
+    }
+
+    const BHttpStatus& status = response.status;
+
+    if (status.code == 304 && haveCached) {
+        std::string cachedBody;
+        status_t result = cache->Revalidated(httpUrl, &cachedBody);
+        if (result == B_OK) {
+            resultBody->Adopt(cachedBody);
+            SLOG_DEBUG("HTTP cache entry for %s is still valid.\n", httpUrl.UrlString().String());
+            return B_OK;
+        }
+        SLOG_ERROR("failed to read revalidated cache entry for %s: %s\n",
+            httpUrl.UrlString().String(), strerror(result));
+        return result;
+    }
     if (status.code >= 200 && status.code <= 400) {
         try {
-            std::string bodyContent = std::string(reinterpret_cast<const char*>(body->Buffer()), body->BufferLength());
-            bool hasBody = ! bodyContent.empty();
+            status_t result = resultBody->FinishReceive();
+            if (result != B_OK) {
+                return result;
+            }
+            SLOG_DEBUG("got HTTP result with BODY length %zu\n", resultBody->Size());
+            METRICS_COUNT("http.bytes", resultBody->Size());
 
-            *resultBody = bodyContent;
-            printf("got HTTP result with BODY length %d\n", body->BufferLength());
+            if (status.code == 200) {
+                cache->Store(httpUrl, cacheClass, resultBody->Data(), resultBody->Size(),
+                    response.etag.String(), response.lastModified.String());
+            }
          } catch (const BPrivate::Network::BBorrowError& err) {
             return B_ERROR;
          }
     } else {
-        printf("HTTP error %d reading from URL %s: %s\n",
+        SLOG_ERROR("HTTP error %d reading from URL %s: %s\n",
             status.code, httpUrl.UrlString().String(), status.text.String());
-        return B_ERROR;
+        if (status.code == 404) {
+            return B_ENTRY_NOT_FOUND;
+        }
+        // still throttled after all retries, the caller may try again later
+        return HostRateLimiter::IsThrottled(status.code) ? B_BUSY : B_ERROR;
     }
     return B_OK;
 }
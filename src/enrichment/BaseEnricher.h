@@ -9,9 +9,14 @@
 #include <Message.h>
 #include <SupportDefs.h>
 #include <Url.h>
-#include <private/netservices2/HttpSession.h>
 
 #include "../common/MappingUtil.h"
+#include "HttpBody.h"
+#include "HttpCache.h"
+#include "HttpSessionPool.h"
+#include "JsonDecoder.h"
+#include "MappingPlan.h"
+#include "UrlTemplate.h"
 
 using namespace BPrivate::Network;
 
@@ -21,30 +26,64 @@ public:
     BaseEnricher(entry_ref* sourceRef, MappingUtil* mapper);
     virtual ~BaseEnricher();
 
-    /*
-    * high level mapping
+    /**
+    * sets the MIME type used for attribute type lookups, if not set it is determined from the source ref.
     */
-    status_t MapAttrsToServiceParams(const BMessage *attrMsg, BMessage *serviceParamMsg);
-    status_t MapServiceParamsToAttrs(const BMessage *serviceParamMsg, BMessage *attrMsg);
+    void     SetMimeType(const char* mimeType);
+    /**
+    * all requests of this enricher give up at the absolute @deadline, including retries.
+    * Concurrent requests for the same URL are shared and run with the deadline of the first caller.
+    */
+    void     SetDeadline(bigtime_t deadline);
+    bigtime_t Deadline() const { return fDeadline; }
+    /**
+    * requests give up with B_CANCELED as soon as *@canceled is set, NULL if they cannot be canceled.
+    */
+    void     SetCancelFlag(const int32* canceled);
 
     /*
-    * conversion
+    * high level mapping, the ones without intermediate messages use the MappingPlan of the MIME type
     */
-    static status_t ConvertMessageMapsToArray(const BMessage* mapMessage, BMessage* resultMsg, BStringList* keys = NULL);
-    static status_t ConvertSingleMessageMapToArray(const BMessage* msg, const char* originalKey, BMessage* resultMsg);
+    status_t MapAttrsToServiceParams(const BMessage *attrMsg, BMessage *serviceParamMsg);
+    status_t MapAttrsToServiceParams(AttributeView* attrView, BMessage *serviceParamMsg);
+    // nested arrays in @serviceParamMsg are mapped to multi-valued attributes as well
+    status_t MapServiceParamsToAttrs(const BMessage *serviceParamMsg, BMessage *attrMsg);
 
     status_t CreateHttpApiUrl(const char* apiUrlPattern, const BMessage* apiParamMapping, BUrl* resultUrl);
-    // these need a valid HTTP session and are bound to the lifecycle of this class
-    status_t FetchRemoteJson(const BUrl& httpUrl, BMessage& jsonMsgResult);
-    status_t FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage* msgQuery, BMessage* msgResult);
-    status_t FetchRemoteImage(const BUrl& httpUrl, BBitmap* resultImage, size_t* imageSize);
-    // Note: std::string will not alter binary content unlike BString does.
-    status_t FetchRemoteContent(const BUrl& httpUrl, std::string* resultBody);
+    // for patterns used more than once, parsed only once
+    status_t CreateHttpApiUrl(const UrlTemplate& apiUrlTemplate, const BMessage* apiParamMapping, BUrl* resultUrl);
+    // these use the shared session of the HttpSessionPool,
+    // responses are served from the HttpCache while fresh and revalidated when stale.
+    // Transient failures are retried and slow requests hedged as set up in the RequestPolicy.
+    // With a @projection, only the selected parts of the JSON response are decoded.
+    status_t FetchRemoteJson(const BUrl& httpUrl, BMessage& jsonMsgResult,
+                             http_cache_class cacheClass = HTTP_CACHE_ENTITY,
+                             const JsonProjection* projection = NULL);
+    status_t FetchByHttpQuery(const BUrl& apiBaseUrl, BMessage* msgQuery, BMessage* msgResult,
+                              const JsonProjection* projection = NULL);
+    // on success @resultImage is set to a new bitmap owned by the caller
+    status_t FetchRemoteImage(const BUrl& httpUrl, BBitmap** resultImage, size_t* imageSize);
+    // the body is handed over as received, without copying
+    status_t FetchRemoteContent(const BUrl& httpUrl, HttpBody* resultBody,
+                                http_cache_class cacheClass = HTTP_CACHE_ENTITY);
+
+    // concurrent fetches of the same URL share one request, see SingleFlight
+    static void GetCoalescingStats(int64* requests, int64* coalesced);
 
 protected:
     MappingUtil*        fMapper;
 
 private:
-    BHttpSession*       fHttpSession;
+    status_t DecodeRemoteJson(const BUrl& httpUrl, BMessage& jsonMsgResult,
+                              http_cache_class cacheClass, const JsonProjection* projection);
+    status_t SendRequest(const BUrl& httpUrl, HttpBody* resultBody, http_cache_class cacheClass);
+
+    status_t GetMappingPlan(std::shared_ptr<const MappingPlan>& plan);
+    void     AddServiceParam(const char* key, const char* paramName, type_code type,
+                             const void* data, ssize_t dataSize, BMessage *serviceParamMsg);
+
     entry_ref*          fSourceRef;
+    BString             fMimeType;
+    bigtime_t           fDeadline;
+    const int32*        fCanceled;
 };
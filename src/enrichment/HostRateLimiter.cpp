@@ -0,0 +1,165 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <OS.h>
+#include <parsedate.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "../common/Log.h"
+#include "HostRateLimiter.h"
+
+// OpenLibrary asks clients to stay well below a few requests per second
+static const double     kDefaultRate = 3.0;
+static const double     kDefaultBurst = 3.0;
+
+static const double     kMinConcurrency = 1.0;
+static const double     kInitialConcurrency = 2.0;
+static const double     kMaxConcurrency = 6.0;
+static const double     kDecreaseFactor = 0.5;
+
+// responses of requests sent before a decrease would halve the limit again right away
+static const bigtime_t  kDecreaseInterval = 1000000;
+// used when a throttling response carries no Retry-After, capped to not stall a batch forever
+static const bigtime_t  kDefaultBackoff = 2000000;
+static const bigtime_t  kMaxBackoff = 60000000;
+// waiting for a free slot is not time critical, requests take far longer than this
+static const bigtime_t  kSlotPollInterval = 20000;
+
+HostRateLimiter::HostRateLimiter()
+    :
+    fLock("host rate limiter")
+{
+}
+
+HostRateLimiter* HostRateLimiter::Default()
+{
+    static HostRateLimiter* sDefaultLimiter = new HostRateLimiter();
+    return sDefaultLimiter;
+}
+
+status_t HostRateLimiter::Acquire(const char* host, bigtime_t deadline)
+{
+    while (true) {
+        bigtime_t wait;
+        bigtime_t now;
+        {
+            BAutolock locker(fLock);
+            host_state& state = StateFor(host);
+            now = system_time();
+            Refill(state, now);
+
+            bool polling = false;
+            if (now < state.blockedUntil) {
+                wait = state.blockedUntil - now;
+            } else if (state.inFlight >= (int32)state.concurrency) {
+                wait = kSlotPollInterval;
+                polling = true;
+            } else if (state.tokens < 1.0) {
+                wait = (bigtime_t)((1.0 - state.tokens) / state.rate * 1000000);
+            } else {
+                state.tokens -= 1.0;
+                state.inFlight++;
+                return B_OK;
+            }
+
+            // a slot may free up any time, but a pause or the next token will not come earlier
+            if (polling ? now >= deadline : wait > deadline - now) {
+                return B_TIMED_OUT;
+            }
+        }
+        snooze(std::max(std::min(wait, deadline - now), (bigtime_t)1000));
+    }
+}
+
+void HostRateLimiter::Release(const char* host, int32 statusCode, bigtime_t retryAfter)
+{
+    BAutolock locker(fLock);
+    host_state& state = StateFor(host);
+    bigtime_t now = system_time();
+
+    if (state.inFlight > 0) {
+        state.inFlight--;
+    }
+
+    if (IsThrottled(statusCode)) {
+        bigtime_t backoff = std::min(retryAfter > 0 ? retryAfter : kDefaultBackoff, kMaxBackoff);
+        state.blockedUntil = std::max(state.blockedUntil, now + backoff);
+        state.tokens = 0;
+
+        if (now - state.lastDecrease >= kDecreaseInterval) {
+            state.concurrency = std::max(kMinConcurrency, state.concurrency * kDecreaseFactor);
+            state.lastDecrease = now;
+            SLOG_INFO("%s is throttling requests (HTTP %" B_PRId32 "), pausing for %.1f s "
+                "and limiting to %d concurrent requests.\n",
+                host, statusCode, backoff / 1000000.0, (int)state.concurrency);
+        }
+    } else if (statusCode > 0 && statusCode < 500) {
+        // grows by about one request per round of concurrent requests
+        state.concurrency = std::min(kMaxConcurrency, state.concurrency + 1.0 / state.concurrency);
+    }
+}
+
+void HostRateLimiter::SetRate(const char* host, double requestsPerSecond, int32 burst)
+{
+    if (requestsPerSecond <= 0 || burst < 1) {
+        return;
+    }
+
+    BAutolock locker(fLock);
+    host_state& state = StateFor(host);
+    state.rate = requestsPerSecond;
+    state.burst = burst;
+    state.tokens = std::min(state.tokens, state.burst);
+}
+
+bigtime_t HostRateLimiter::ParseRetryAfter(const char* value)
+{
+    if (value == NULL || value[0] == '\0') {
+        return 0;
+    }
+
+    char* end;
+    long seconds = strtol(value, &end, 10);
+    if (end != value && *end == '\0') {
+        return seconds > 0 ? (bigtime_t)seconds * 1000000 : 0;
+    }
+
+    time_t date = parsedate(value, -1);
+    time_t now = time(NULL);
+    if (date == -1 || date <= now) {
+        return 0;
+    }
+    return (bigtime_t)(date - now) * 1000000;
+}
+
+HostRateLimiter::host_state& HostRateLimiter::StateFor(const char* host)
+{
+    auto it = fHosts.find(host);
+    if (it != fHosts.end()) {
+        return it->second;
+    }
+
+    host_state state;
+    state.rate = kDefaultRate;
+    state.burst = kDefaultBurst;
+    state.tokens = kDefaultBurst;
+    state.lastRefill = system_time();
+    state.concurrency = kInitialConcurrency;
+    state.inFlight = 0;
+    state.blockedUntil = 0;
+    state.lastDecrease = 0;
+
+    return fHosts.emplace(host, state).first->second;
+}
+
+void HostRateLimiter::Refill(host_state& state, bigtime_t now)
+{
+    double elapsed = (now - state.lastRefill) / 1000000.0;
+    state.tokens = std::min(state.burst, state.tokens + elapsed * state.rate);
+    state.lastRefill = now;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <string>
+#include <unordered_map>
+
+/**
+* limits the requests sent to each host.
+* A token bucket bounds the request rate, and the number of concurrent requests is adapted
+* with AIMD (additive increase, multiplicative decrease): every successful response raises
+* the limit by one request per round trip, while a 429 or 503 response halves it and
+* pauses the host for the time given in its Retry-After header.
+*/
+class HostRateLimiter {
+
+public:
+    static HostRateLimiter* Default();
+
+    /**
+    * blocks until a request to @host may be sent, needs to be paired with Release() on success.
+    * Returns B_TIMED_OUT if that is not possible before the absolute @deadline, a deadline of 0
+    * only takes a slot that is free right now.
+    */
+    status_t    Acquire(const char* host, bigtime_t deadline = B_INFINITE_TIMEOUT);
+    // reports the HTTP @statusCode of a request to @host, or 0 if it failed without a response
+    void        Release(const char* host, int32 statusCode, bigtime_t retryAfter = 0);
+
+    // overrides the default rate of @requestsPerSecond with bursts of up to @burst requests
+    void        SetRate(const char* host, double requestsPerSecond, int32 burst);
+
+    static bool         IsThrottled(int32 statusCode)
+                        { return statusCode == 429 || statusCode == 503; }
+    // parses delta seconds or an HTTP date, returns 0 if @value is not valid
+    static bigtime_t    ParseRetryAfter(const char* value);
+
+private:
+    struct host_state {
+        double      rate;           // tokens per second
+        double      burst;
+        double      tokens;
+        bigtime_t   lastRefill;
+        double      concurrency;    // current AIMD limit
+        int32       inFlight;
+        bigtime_t   blockedUntil;
+        bigtime_t   lastDecrease;
+    };
+
+    HostRateLimiter();
+
+    // both need fLock to be held
+    host_state& StateFor(const char* host);
+    void        Refill(host_state& state, bigtime_t now);
+
+    BLocker     fLock;
+    std::unordered_map<std::string, host_state> fHosts;
+};
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include "HttpBody.h"
+
+// BMallocIO grows in steps of 256 bytes by default, which means one realloc() per
+// network read for covers and larger search results.
+static const size_t kReceiveBlockSize = 32 * 1024;
+
+HttpBody::HttpBody()
+    :
+    fSize(0)
+{
+}
+
+const char* HttpBody::Data() const
+{
+    if (fShared) {
+        return fShared->Data();
+    }
+    if (fReceived.HasValue()) {
+        return reinterpret_cast<const char*>(fReceived->Buffer());
+    }
+    return fStored.c_str();
+}
+
+BExclusiveBorrow<BMallocIO>& HttpBody::Receiver()
+{
+    Unset();
+
+    fReceived = make_exclusive_borrow<BMallocIO>();
+    fReceived->SetBlockSize(kReceiveBlockSize);
+
+    return fReceived;
+}
+
+status_t HttpBody::FinishReceive()
+{
+    if (!fReceived.HasValue()) {
+        return B_NO_INIT;
+    }
+
+    // throws if the session still holds the buffer, callers need to wait for the result first
+    fSize = fReceived->BufferLength();
+
+    // terminate in place, the terminator is part of the buffer but not of Size()
+    static const char kTerminator = '\0';
+    ssize_t written = fReceived->WriteAt(fSize, &kTerminator, 1);
+    if (written != 1) {
+        return written < 0 ? written : B_NO_MEMORY;
+    }
+
+    return B_OK;
+}
+
+void HttpBody::Adopt(std::string& data)
+{
+    Unset();
+
+    fStored.swap(data);
+    fSize = fStored.size();
+}
+
+void HttpBody::Share(const std::shared_ptr<const HttpBody>& body)
+{
+    Unset();
+
+    fShared = body;
+    fSize = body->Size();
+}
+
+void HttpBody::Unset()
+{
+    fReceived = BExclusiveBorrow<BMallocIO>();
+    fStored.clear();
+    fShared.reset();
+    fSize = 0;
+}
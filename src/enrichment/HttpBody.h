@@ -0,0 +1,53 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <DataIO.h>
+#include <SupportDefs.h>
+
+#include <memory>
+#include <string>
+
+#include <private/netservices2/ExclusiveBorrow.h>
+
+using namespace BPrivate::Network;
+
+/**
+* owns the body of an HTTP response, either the receive buffer the session wrote into or
+* the data read back from the HttpCache. Consumers read it in place through Data() and Size(),
+* so a response is never copied between the network and the attribute or parser it ends up in.
+* The data is always followed by a NUL byte that is not counted in Size(), so text bodies can
+* be passed to C string parsers directly.
+*/
+class HttpBody {
+
+public:
+    HttpBody();
+
+    // not copyable, that's the point
+    HttpBody(HttpBody&& other) = default;
+    HttpBody& operator=(HttpBody&& other) = default;
+
+    const char*     Data() const;
+    size_t          Size() const { return fSize; }
+    bool            IsEmpty() const { return fSize == 0; }
+
+    // buffer for the session to write the response into, replaces any previous content
+    BExclusiveBorrow<BMallocIO>& Receiver();
+    // to be called once the session released the receive buffer
+    status_t        FinishReceive();
+    // takes over @data without copying, used for bodies served from the cache
+    void            Adopt(std::string& data);
+    // refers to the data of @body, used to hand one response to several callers
+    void            Share(const std::shared_ptr<const HttpBody>& body);
+
+    void            Unset();
+
+private:
+    BExclusiveBorrow<BMallocIO> fReceived;
+    std::string                 fStored;
+    std::shared_ptr<const HttpBody> fShared;
+    size_t                      fSize;
+};
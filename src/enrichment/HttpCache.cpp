@@ -0,0 +1,475 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <OS.h>
+#include <StringList.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "HttpCache.h"
+#include "../common/HashUtil.h"
+#include "../common/Log.h"
+
+static const char* kCacheSubdir     = "sensei/http";
+static const char* kTempSuffix      = ".tmp";
+
+static const char* kUrlAttr         = "HTTP:url";
+static const char* kEtagAttr        = "HTTP:etag";
+static const char* kLastModAttr     = "HTTP:last_modified";
+static const char* kStoredAttr      = "HTTP:stored";
+static const char* kEncodingAttr    = "HTTP:encoding";
+static const char* kSizeAttr        = "HTTP:size";
+
+static const bigtime_t kOneHour = 60LL * 60 * 1000000;
+static const bigtime_t kOneDay = 24 * kOneHour;
+static const off_t     kDefaultMaxSize = 64 * 1024 * 1024;
+// not worth the effort below that, and tiny JSON error responses don't compress anyway
+static const size_t    kMinCompressSize = 256;
+
+HttpCache::HttpCache()
+    :
+    fLock("http cache"),
+    fInitStatus(B_NO_INIT),
+    fMaxSize(kDefaultMaxSize),
+    fSize(0)
+{
+    fTimeToLive[HTTP_CACHE_QUERY] = kOneDay;
+    fTimeToLive[HTTP_CACHE_ENTITY] = 7 * kOneDay;
+    fTimeToLive[HTTP_CACHE_IMAGE] = 30 * kOneDay;
+    ReadSettings();
+
+    memset(&fStats, 0, sizeof(fStats));
+
+    fInitStatus = Init();
+    if (fInitStatus != B_OK) {
+        SLOG_WARN("HTTP cache disabled, could not set up cache directory: %s\n", strerror(fInitStatus));
+    }
+}
+
+/**
+* overrides the defaults from the environment, the cache is shared by all plugins and
+* they are usually not started from a shell.
+* SENSEI_HTTP_CACHE_TTL holds the hours for queries, entities and images separated by ",",
+* empty entries keep their default. SENSEI_HTTP_CACHE_SIZE is the maximum size in MiB.
+*/
+void HttpCache::ReadSettings()
+{
+    const char* timeToLive = getenv("SENSEI_HTTP_CACHE_TTL");
+    if (timeToLive != NULL) {
+        BStringList hours;
+        BString(timeToLive).Split(",", false, hours);
+        for (int32 i = 0; i < hours.CountStrings() && i < HTTP_CACHE_CLASS_COUNT; i++) {
+            BString value = hours.StringAt(i).Trim();
+            if (value.IsEmpty()) {
+                continue;
+            }
+            char* end;
+            long long parsed = strtoll(value.String(), &end, 10);
+            if (*end != '\0' || parsed < 0) {
+                SLOG_WARN("ignoring invalid HTTP cache time to live '%s'.\n", value.String());
+                continue;
+            }
+            fTimeToLive[i] = parsed * kOneHour;
+        }
+    }
+
+    const char* maxSize = getenv("SENSEI_HTTP_CACHE_SIZE");
+    if (maxSize != NULL) {
+        char* end;
+        long long parsed = strtoll(maxSize, &end, 10);
+        if (*end != '\0' || parsed <= 0) {
+            SLOG_WARN("ignoring invalid HTTP cache size '%s'.\n", maxSize);
+        } else {
+            fMaxSize = (off_t)parsed * 1024 * 1024;
+        }
+    }
+
+    SLOG_DEBUG("HTTP cache: %" B_PRId64 " MiB, time to live %" B_PRId64 "/%" B_PRId64 "/%" B_PRId64
+        " hours for queries/entities/images.\n", (int64)(fMaxSize / (1024 * 1024)),
+        fTimeToLive[HTTP_CACHE_QUERY] / kOneHour, fTimeToLive[HTTP_CACHE_ENTITY] / kOneHour,
+        fTimeToLive[HTTP_CACHE_IMAGE] / kOneHour);
+}
+
+HttpCache* HttpCache::Default()
+{
+    // lives as long as the process, the index is rebuilt from disk on the next start
+    static HttpCache* sDefaultCache = new HttpCache();
+    return sDefaultCache;
+}
+
+/**
+* creates the cache directory if needed and rebuilds the LRU index from the modification
+* times of the entries, which are bumped on every hit.
+*/
+status_t HttpCache::Init()
+{
+    status_t result = find_directory(B_USER_CACHE_DIRECTORY, &fPath, true);
+    if (result == B_OK) {
+        result = fPath.Append(kCacheSubdir);
+    }
+    if (result == B_OK) {
+        result = create_directory(fPath.Path(), 0755);
+    }
+    if (result != B_OK) {
+        return result;
+    }
+
+    BDirectory dir(fPath.Path());
+    result = dir.InitCheck();
+    if (result != B_OK) {
+        return result;
+    }
+
+    struct ScanEntry {
+        time_t      modified;
+        std::string key;
+        off_t       size;
+    };
+    std::vector<ScanEntry> entries;
+
+    BEntry entry;
+    char name[B_FILE_NAME_LENGTH];
+    struct stat st;
+
+    while (dir.GetNextEntry(&entry) == B_OK) {
+        if (entry.GetName(name) != B_OK || entry.GetStat(&st) != B_OK || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        BString entryName(name);
+        if (entryName.EndsWith(kTempSuffix)) {
+            // leftover of an interrupted Store()
+            entry.Remove();
+            continue;
+        }
+        entries.push_back(ScanEntry{ st.st_mtime, name, st.st_size });
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const ScanEntry& a, const ScanEntry& b) {
+        return a.modified < b.modified;
+    });
+
+    BAutolock locker(fLock);
+    for (size_t i = 0; i < entries.size(); i++) {
+        Touch(entries[i].key, entries[i].size);
+    }
+    EvictIfNeeded();
+
+    SLOG_DEBUG("HTTP cache at %s has %zu entries with %" B_PRIdOFF " bytes.\n",
+        fPath.Path(), fIndex.size(), fSize);
+
+    return B_OK;
+}
+
+status_t HttpCache::Lookup(const BUrl& url, http_cache_class cacheClass, http_cache_entry* entry)
+{
+    if (fInitStatus != B_OK) {
+        return fInitStatus;
+    }
+
+    BString normalizedUrl;
+    BString key = KeyFor(url, &normalizedUrl);
+    BPath path(fPath.Path(), key.String());
+
+    BNode node(path.Path());
+    BString storedUrl;
+
+    if (node.InitCheck() != B_OK || node.ReadAttrString(kUrlAttr, &storedUrl) != B_OK
+        || storedUrl != normalizedUrl) {
+        BAutolock locker(fLock);
+        fStats.misses++;
+        return B_ENTRY_NOT_FOUND;
+    }
+
+    bigtime_t stored = 0;
+    node.ReadAttr(kStoredAttr, B_INT64_TYPE, 0, &stored, sizeof(stored));
+
+    entry->etag.Truncate(0);
+    entry->lastModified.Truncate(0);
+    node.ReadAttrString(kEtagAttr, &entry->etag);
+    node.ReadAttrString(kLastModAttr, &entry->lastModified);
+    entry->fresh = real_time_clock_usecs() - stored < fTimeToLive[cacheClass];
+
+    if (!entry->fresh) {
+        // counted as hit only if the server confirms it, see Revalidated()
+        BAutolock locker(fLock);
+        fStats.misses++;
+        return B_OK;
+    }
+
+    off_t storedSize;
+    status_t result = ReadBody(path.Path(), &entry->body, &storedSize);
+
+    BAutolock locker(fLock);
+    if (result != B_OK) {
+        SLOG_WARN("dropping unreadable HTTP cache entry for %s: %s\n", normalizedUrl.String(), strerror(result));
+        BEntry(path.Path()).Remove();
+        fStats.misses++;
+        return B_ENTRY_NOT_FOUND;
+    }
+
+    node.SetModificationTime(time(NULL));
+    Touch(key.String(), storedSize);
+    fStats.hits++;
+
+    return B_OK;
+}
+
+status_t HttpCache::Store(const BUrl& url, http_cache_class cacheClass, const char* body, size_t size,
+    const char* etag, const char* lastModified)
+{
+    if (fInitStatus != B_OK) {
+        return fInitStatus;
+    }
+
+    BString normalizedUrl;
+    BString key = KeyFor(url, &normalizedUrl);
+
+    // stored as is unless compression pays off
+    const char* data = body;
+    size_t dataSize = size;
+    std::string compressed;
+    const char* encoding = "identity";
+
+    if (cacheClass != HTTP_CACHE_IMAGE && size >= kMinCompressSize) {
+        uLongf length = compressBound(size);
+        compressed.resize(length);
+
+        if (compress2(reinterpret_cast<Bytef*>(&compressed[0]), &length,
+                reinterpret_cast<const Bytef*>(body), size, Z_DEFAULT_COMPRESSION) == Z_OK
+            && length < size) {
+            data = compressed.data();
+            dataSize = length;
+            encoding = "deflate";
+        }
+    }
+
+    // write to a private temp file first so readers never see a partial entry
+    BString tempName(key);
+    tempName << "." << find_thread(NULL) << kTempSuffix;
+    BPath tempPath(fPath.Path(), tempName.String());
+
+    BFile file(tempPath.Path(), B_CREATE_FILE | B_ERASE_FILE | B_WRITE_ONLY);
+    status_t result = file.InitCheck();
+    if (result != B_OK) {
+        return result;
+    }
+
+    ssize_t written = file.Write(data, dataSize);
+    if (written != (ssize_t)dataSize) {
+        BEntry(tempPath.Path()).Remove();
+        return written < 0 ? written : B_IO_ERROR;
+    }
+
+    BString value(encoding);
+    bigtime_t now = real_time_clock_usecs();
+    int64 bodySize = size;
+
+    file.WriteAttrString(kUrlAttr, &normalizedUrl);
+    file.WriteAttrString(kEncodingAttr, &value);
+    file.WriteAttr(kStoredAttr, B_INT64_TYPE, 0, &now, sizeof(now));
+    file.WriteAttr(kSizeAttr, B_INT64_TYPE, 0, &bodySize, sizeof(bodySize));
+    if (etag != NULL && etag[0] != '\0') {
+        value = etag;
+        file.WriteAttrString(kEtagAttr, &value);
+    }
+    if (lastModified != NULL && lastModified[0] != '\0') {
+        value = lastModified;
+        file.WriteAttrString(kLastModAttr, &value);
+    }
+    file.Unset();
+
+    BEntry tempEntry(tempPath.Path());
+    result = tempEntry.Rename(key.String(), true);
+    if (result != B_OK) {
+        tempEntry.Remove();
+        return result;
+    }
+
+    BAutolock locker(fLock);
+    Touch(key.String(), dataSize);
+    fStats.stored++;
+    EvictIfNeeded();
+
+    return B_OK;
+}
+
+status_t HttpCache::Revalidated(const BUrl& url, std::string* body)
+{
+    if (fInitStatus != B_OK) {
+        return fInitStatus;
+    }
+
+    BString key = KeyFor(url, NULL);
+    BPath path(fPath.Path(), key.String());
+
+    off_t storedSize;
+    status_t result = ReadBody(path.Path(), body, &storedSize);
+    if (result != B_OK) {
+        return result;
+    }
+
+    BNode node(path.Path());
+    bigtime_t now = real_time_clock_usecs();
+    node.WriteAttr(kStoredAttr, B_INT64_TYPE, 0, &now, sizeof(now));
+    node.SetModificationTime(time(NULL));
+
+    BAutolock locker(fLock);
+    Touch(key.String(), storedSize);
+    fStats.revalidated++;
+
+    return B_OK;
+}
+
+void HttpCache::SetTimeToLive(http_cache_class cacheClass, bigtime_t timeToLive)
+{
+    if (cacheClass >= 0 && cacheClass < HTTP_CACHE_CLASS_COUNT) {
+        fTimeToLive[cacheClass] = timeToLive;
+    }
+}
+
+void HttpCache::SetMaxSize(off_t maxSize)
+{
+    BAutolock locker(fLock);
+    fMaxSize = maxSize;
+    EvictIfNeeded();
+}
+
+void HttpCache::GetStats(http_cache_stats* stats)
+{
+    BAutolock locker(fLock);
+    *stats = fStats;
+    stats->size = fSize;
+}
+
+/**
+* lower-cases scheme and host, drops default ports and fragments and sorts the query
+* parameters, so equivalent requests end up in the same entry.
+*/
+BString HttpCache::NormalizeUrl(const BUrl& url)
+{
+    BString protocol(url.Protocol());
+    BString host(url.Host());
+    protocol.ToLower();
+    host.ToLower();
+
+    BString normalized;
+    normalized << protocol << "://" << host;
+
+    if (url.HasPort()) {
+        int port = url.Port();
+        if (!(protocol == "http" && port == 80) && !(protocol == "https" && port == 443)) {
+            normalized << ":" << port;
+        }
+    }
+
+    normalized << (url.Path().IsEmpty() ? "/" : url.Path().String());
+
+    if (url.HasRequest() && !url.Request().IsEmpty()) {
+        BStringList params;
+        url.Request().Split("&", true, params);
+        params.Sort();
+        normalized << "?" << params.Join("&");
+    }
+
+    return normalized;
+}
+
+BString HttpCache::KeyFor(const BUrl& url, BString* normalizedUrl) const
+{
+    BString normalized = NormalizeUrl(url);
+    if (normalizedUrl != NULL) {
+        *normalizedUrl = normalized;
+    }
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016" B_PRIx64, HashString(normalized.String()));
+
+    return BString(key);
+}
+
+status_t HttpCache::ReadBody(const char* path, std::string* body, off_t* storedSize)
+{
+    BFile file(path, B_READ_ONLY);
+    status_t result = file.InitCheck();
+    if (result != B_OK) {
+        return result;
+    }
+
+    off_t fileSize;
+    result = file.GetSize(&fileSize);
+    if (result != B_OK) {
+        return result;
+    }
+    *storedSize = fileSize;
+
+    std::string data(fileSize, '\0');
+    ssize_t bytesRead = file.ReadAt(0, &data[0], fileSize);
+    if (bytesRead != fileSize) {
+        return bytesRead < 0 ? bytesRead : B_IO_ERROR;
+    }
+
+    BString encoding;
+    file.ReadAttrString(kEncodingAttr, &encoding);
+    if (encoding != "deflate") {
+        body->swap(data);
+        return B_OK;
+    }
+
+    int64 size = 0;
+    if (file.ReadAttr(kSizeAttr, B_INT64_TYPE, 0, &size, sizeof(size)) != sizeof(size) || size < 0) {
+        return B_BAD_DATA;
+    }
+
+    body->resize(size);
+    uLongf length = size;
+    if (uncompress(reinterpret_cast<Bytef*>(&(*body)[0]), &length,
+            reinterpret_cast<const Bytef*>(data.data()), data.size()) != Z_OK
+        || length != (uLongf)size) {
+        body->clear();
+        return B_BAD_DATA;
+    }
+
+    return B_OK;
+}
+
+void HttpCache::Touch(const std::string& key, off_t size)
+{
+    auto it = fIndex.find(key);
+    if (it != fIndex.end()) {
+        fSize -= it->second.size;
+        it->second.size = size;
+        fLruList.splice(fLruList.end(), fLruList, it->second.lruPos);
+    } else {
+        fLruList.push_back(key);
+        fIndex[key] = IndexEntry{ std::prev(fLruList.end()), size };
+    }
+    fSize += size;
+}
+
+void HttpCache::EvictIfNeeded()
+{
+    while (fSize > fMaxSize && !fLruList.empty()) {
+        const std::string& key = fLruList.front();
+        BPath path(fPath.Path(), key.c_str());
+        BEntry(path.Path()).Remove();
+
+        auto it = fIndex.find(key);
+        fSize -= it->second.size;
+        fIndex.erase(it);
+        fLruList.pop_front();
+        fStats.evicted++;
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <Path.h>
+#include <String.h>
+#include <SupportDefs.h>
+#include <Url.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+/**
+* endpoint classes with their own time to live, see HttpCache::SetTimeToLive().
+*/
+enum http_cache_class {
+    HTTP_CACHE_QUERY = 0,   // search results, may change any time
+    HTTP_CACHE_ENTITY,      // single records like authors or works
+    HTTP_CACHE_IMAGE,       // covers and photos, already compressed and stored as is
+    HTTP_CACHE_CLASS_COUNT
+};
+
+struct http_cache_stats {
+    int64   hits;
+    int64   misses;
+    int64   revalidated;    // stale entries confirmed by the server with 304 Not Modified
+    int64   stored;
+    int64   evicted;
+    off_t   size;
+};
+
+struct http_cache_entry {
+    std::string body;       // only filled if the entry is fresh or after Revalidated()
+    BString     etag;
+    BString     lastModified;
+    bool        fresh;
+};
+
+/**
+* persistent cache for HTTP responses below the user's cache directory.
+* Entries are addressed by the hash of the normalized URL and hold the (compressed) body
+* with the validators of the response as attributes, so stale entries can be revalidated with
+* a conditional request instead of a full download. The cache is bounded in size and evicts
+* the least recently used entries first.
+* Times to live and the size limit can be set with SENSEI_HTTP_CACHE_TTL and
+* SENSEI_HTTP_CACHE_SIZE, see ReadSettings().
+*/
+class HttpCache {
+
+public:
+    static HttpCache*   Default();
+
+    status_t    InitCheck() const { return fInitStatus; }
+
+    /**
+    * looks up @url, returns B_OK if there is an entry (check @entry->fresh), B_ENTRY_NOT_FOUND else.
+    */
+    status_t    Lookup(const BUrl& url, http_cache_class cacheClass, http_cache_entry* entry);
+    status_t    Store(const BUrl& url, http_cache_class cacheClass, const char* body, size_t size,
+                      const char* etag, const char* lastModified);
+    // the server confirmed a stale entry, reads its body and restarts its time to live
+    status_t    Revalidated(const BUrl& url, std::string* body);
+
+    void        SetTimeToLive(http_cache_class cacheClass, bigtime_t timeToLive);
+    void        SetMaxSize(off_t maxSize);
+    void        GetStats(http_cache_stats* stats);
+
+    static BString NormalizeUrl(const BUrl& url);
+
+private:
+    struct IndexEntry {
+        std::list<std::string>::iterator    lruPos;
+        off_t                               size;
+    };
+
+    HttpCache();
+
+    status_t    Init();
+    void        ReadSettings();
+    status_t    ReadBody(const char* path, std::string* body, off_t* storedSize);
+    BString     KeyFor(const BUrl& url, BString* normalizedUrl) const;
+
+    // both need fLock to be held
+    void        Touch(const std::string& key, off_t size);
+    void        EvictIfNeeded();
+
+    BLocker     fLock;
+    status_t    fInitStatus;
+    BPath       fPath;
+
+    bigtime_t   fTimeToLive[HTTP_CACHE_CLASS_COUNT];
+    off_t       fMaxSize;
+    off_t       fSize;
+
+    // least recently used keys first
+    std::list<std::string>                      fLruList;
+    std::unordered_map<std::string, IndexEntry> fIndex;
+
+    http_cache_stats    fStats;
+};
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include "HttpSessionPool.h"
+
+using namespace std::literals;
+
+static const size_t kMaxHosts = 4;
+// requests per host are paced by the HostRateLimiter, this only bounds the connections it may use
+static const size_t kMaxConnectionsPerHost = 6;
+
+HttpSessionPool::HttpSessionPool()
+{
+    fSession.SetMaxHosts(kMaxHosts);
+    fSession.SetMaxConnectionsPerHost(kMaxConnectionsPerHost);
+
+    for (int32 i = 0; i < HTTP_CACHE_CLASS_COUNT; i++) {
+        fFields[i].AddField("User-Agent"sv, "Haiku/SEN (Senity Book Enricher)"sv);
+    }
+    // the session already asks for gzip and decompresses transparently
+    fFields[HTTP_CACHE_QUERY].AddField("Accept"sv, "application/json"sv);
+    fFields[HTTP_CACHE_ENTITY].AddField("Accept"sv, "application/json"sv);
+    fFields[HTTP_CACHE_IMAGE].AddField("Accept"sv, "image/*"sv);
+}
+
+HttpSessionPool* HttpSessionPool::Default()
+{
+    // lives as long as the process, like the network threads of the session
+    static HttpSessionPool* sDefaultPool = new HttpSessionPool();
+    return sDefaultPool;
+}
+
+BHttpFields HttpSessionPool::FieldsFor(http_cache_class contentClass) const
+{
+    if (contentClass < 0 || contentClass >= HTTP_CACHE_CLASS_COUNT) {
+        contentClass = HTTP_CACHE_ENTITY;
+    }
+    return fFields[contentClass];
+}
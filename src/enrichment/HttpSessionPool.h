@@ -0,0 +1,36 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+#include <private/netservices2/HttpFields.h>
+#include <private/netservices2/HttpSession.h>
+
+#include "HttpCache.h"
+
+using namespace BPrivate::Network;
+
+/**
+* process-wide HTTP session shared by all enrichers.
+* A BHttpSession runs its own control and data threads, so sharing one instance avoids
+* setting those up per enricher and lets the session schedule all requests to a host together.
+* Request header templates are built once per content class and copied into each request.
+*/
+class HttpSessionPool {
+
+public:
+    static HttpSessionPool* Default();
+
+    // Execute() is thread safe, the session may be used from any thread
+    BHttpSession&   Session() { return fSession; }
+    // common request headers for @contentClass, to be extended with request specific fields
+    BHttpFields     FieldsFor(http_cache_class contentClass) const;
+
+private:
+    HttpSessionPool();
+
+    BHttpSession    fSession;
+    BHttpFields     fFields[HTTP_CACHE_CLASS_COUNT];
+};
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+
+#include "Isbn.h"
+
+// digit value of the ISBN-10 check character 'X'
+static const uint8  kCheckX = 10;
+// values checked together, the digits of a block are stored by position so that the checksum
+// loops run over contiguous memory and can be vectorized by the compiler
+static const int32  kBlockSize = 64;
+
+/**
+* strips separators and collects the digits of @value, returns the number of digits (10 or 13)
+* or 0 if @value cannot be an ISBN.
+*/
+static int32 CollectDigits(const char* value, uint8 digits[13])
+{
+    if (value == NULL) {
+        return 0;
+    }
+
+    int32 count = 0;
+    for (const char* c = value; *c != '\0'; c++) {
+        if (*c == '-' || *c == ' ') {
+            continue;
+        }
+        if (count == 13) {
+            return 0;
+        }
+        if (*c >= '0' && *c <= '9') {
+            digits[count++] = *c - '0';
+        } else if ((*c == 'X' || *c == 'x') && count == 9) {
+            digits[count++] = kCheckX;
+        } else {
+            return 0;
+        }
+    }
+
+    if (count == 10 || (count == 13 && digits[9] != kCheckX)) {
+        return count;
+    }
+    return 0;
+}
+
+static inline uint8 CheckDigit13(const uint8 digits[12])
+{
+    int32 sum = 0;
+    for (int32 i = 0; i < 12; i++) {
+        sum += digits[i] * (i % 2 == 0 ? 1 : 3);
+    }
+    return (10 - sum % 10) % 10;
+}
+
+/**
+* builds the ISBN-13 number from valid @digits, ISBN-10 is prefixed with 978 and gets a new check digit.
+*/
+static uint64 ToIsbn13(const uint8* digits, int32 count)
+{
+    uint8 isbn[13];
+    if (count == 10) {
+        isbn[0] = 9;
+        isbn[1] = 7;
+        isbn[2] = 8;
+        for (int32 i = 0; i < 9; i++) {
+            isbn[i + 3] = digits[i];
+        }
+        isbn[12] = CheckDigit13(isbn);
+        digits = isbn;
+    }
+
+    uint64 value = 0;
+    for (int32 i = 0; i < 13; i++) {
+        value = value * 10 + digits[i];
+    }
+    return value;
+}
+
+status_t Isbn::Parse(const char* value, Isbn* isbn)
+{
+    uint8 digits[13];
+    int32 count = CollectDigits(value, digits);
+    if (count == 0) {
+        return B_BAD_VALUE;
+    }
+
+    bool valid;
+    if (count == 10) {
+        int32 sum = 0;
+        for (int32 i = 0; i < 10; i++) {
+            sum += digits[i] * (10 - i);
+        }
+        valid = sum % 11 == 0;
+    } else {
+        valid = CheckDigit13(digits) == digits[12];
+    }
+    if (!valid) {
+        return B_BAD_DATA;
+    }
+
+    isbn->fValue = ToIsbn13(digits, count);
+    return B_OK;
+}
+
+int32 Isbn::ParseBatch(const char* const* values, int32 count, uint64* isbns)
+{
+    uint8 digits[13][kBlockSize];
+    uint8 lengths[kBlockSize];
+    uint16 sum10[kBlockSize];
+    uint16 sum13[kBlockSize];
+    int32 validCount = 0;
+
+    for (int32 start = 0; start < count; start += kBlockSize) {
+        int32 blockCount = count - start < kBlockSize ? count - start : kBlockSize;
+
+        // scalar part: separators and formats vary too much to do this in parallel
+        for (int32 lane = 0; lane < kBlockSize; lane++) {
+            uint8 laneDigits[13] = { 0 };
+            lengths[lane] = lane < blockCount ? CollectDigits(values[start + lane], laneDigits) : 0;
+            for (int32 i = 0; i < 13; i++) {
+                digits[i][lane] = laneDigits[i];
+            }
+        }
+
+        // weighted sums for both formats over all lanes, missing digits of ISBN-10 are 0
+        for (int32 lane = 0; lane < kBlockSize; lane++) {
+            sum10[lane] = 0;
+            sum13[lane] = 0;
+        }
+        for (int32 i = 0; i < 13; i++) {
+            const uint16 weight10 = i < 10 ? 10 - i : 0;
+            const uint16 weight13 = i % 2 == 0 ? 1 : 3;
+            for (int32 lane = 0; lane < kBlockSize; lane++) {
+                sum10[lane] += digits[i][lane] * weight10;
+                sum13[lane] += digits[i][lane] * weight13;
+            }
+        }
+
+        for (int32 lane = 0; lane < blockCount; lane++) {
+            bool valid = (lengths[lane] == 10 && sum10[lane] % 11 == 0)
+                || (lengths[lane] == 13 && sum13[lane] % 10 == 0);
+            if (!valid) {
+                isbns[start + lane] = 0;
+                continue;
+            }
+
+            uint8 laneDigits[13];
+            for (int32 i = 0; i < 13; i++) {
+                laneDigits[i] = digits[i][lane];
+            }
+            isbns[start + lane] = ToIsbn13(laneDigits, lengths[lane]);
+            validCount++;
+        }
+    }
+
+    return validCount;
+}
+
+status_t Isbn::SelectBest(const BMessage* msg, const char* name, Isbn* best, BStringList* invalid)
+{
+    status_t result = B_ENTRY_NOT_FOUND;
+    const char* value;
+
+    for (int32 i = 0; msg->FindString(name, i, &value) == B_OK; i++) {
+        Isbn isbn;
+        if (Parse(value, &isbn) != B_OK) {
+            if (invalid != NULL) {
+                invalid->Add(value);
+            }
+            continue;
+        }
+        if (result != B_OK) {
+            *best = isbn;
+            result = B_OK;
+        }
+    }
+    return result;
+}
+
+BString Isbn::ToString() const
+{
+    char buffer[21];
+    snprintf(buffer, sizeof(buffer), "%013" B_PRIu64, fValue);
+    return BString(buffer);
+}
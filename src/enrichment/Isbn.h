@@ -0,0 +1,48 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <String.h>
+#include <StringList.h>
+#include <SupportDefs.h>
+
+/**
+* an ISBN in its canonical ISBN-13 form.
+* Parsing accepts ISBN-10 and ISBN-13 with or without separators and verifies the check digit,
+* so only numbers that can actually identify a book are ever sent to a service.
+*/
+class Isbn {
+
+public:
+    Isbn() : fValue(0) {}
+
+    /**
+    * returns B_BAD_VALUE if @value is no ISBN at all and B_BAD_DATA if its check digit is wrong.
+    */
+    static status_t Parse(const char* value, Isbn* isbn);
+
+    /**
+    * validates @count ISBNs at once, @isbns receives the ISBN-13 numbers or 0 for invalid ones.
+    * Checksums are computed for blocks of values in parallel, which is considerably faster
+    * for bulk imports than calling Parse() for each. Returns the number of valid ISBNs.
+    */
+    static int32    ParseBatch(const char* const* values, int32 count, uint64* isbns);
+
+    /**
+    * picks the first valid ISBN from the values of @name in @msg, invalid values are
+    * added to @invalid if given. Returns B_ENTRY_NOT_FOUND if there is no valid one.
+    */
+    static status_t SelectBest(const BMessage* msg, const char* name, Isbn* best,
+                               BStringList* invalid = NULL);
+
+    bool        IsValid() const { return fValue != 0; }
+    uint64      Value() const { return fValue; }
+    // 13 digits without separators
+    BString     ToString() const;
+
+private:
+    uint64      fValue;
+};
@@ -0,0 +1,483 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "JsonDecoder.h"
+
+// same message layout as BJson::Parse()
+static const uint32 kJsonObjectWhat = 'JSOB';
+static const uint32 kJsonArrayWhat  = 'JSAR';
+
+static const int32  kSkip = -1;     // not selected by the projection
+static const int32  kAll = -2;      // selected including the entire subtree
+static const int32  kMaxDepth = 64;
+
+// JsonProjection
+
+JsonProjection::JsonProjection()
+{
+    fNodes.push_back(Node{ {}, false, -1 });
+}
+
+void JsonProjection::AddPath(const char* path)
+{
+    fNodes[FindOrAdd(path)].all = true;
+}
+
+void JsonProjection::SetMaxItems(const char* path, int32 maxItems)
+{
+    fNodes[FindOrAdd(path)].maxItems = maxItems;
+}
+
+int32 JsonProjection::FindOrAdd(const char* path)
+{
+    int32 node = 0;
+    std::string_view remaining(path);
+
+    while (!remaining.empty()) {
+        size_t separator = remaining.find('/');
+        std::string_view key = remaining.substr(0, separator);
+        remaining = separator == std::string_view::npos
+            ? std::string_view() : remaining.substr(separator + 1);
+
+        if (key.empty()) {
+            continue;
+        }
+        auto it = fNodes[node].children.find(key);
+        if (it != fNodes[node].children.end()) {
+            node = it->second;
+        } else {
+            int32 child = fNodes.size();
+            fNodes.push_back(Node{ {}, false, -1 });
+            fNodes[node].children.emplace(std::string(key), child);
+            node = child;
+        }
+    }
+    return node;
+}
+
+int32 JsonProjection::Child(int32 node, std::string_view key) const
+{
+    if (node == kAll) {
+        return kAll;
+    }
+    const Node& parent = fNodes[node];
+
+    auto it = parent.children.find(key);
+    if (it != parent.children.end()) {
+        return it->second;
+    }
+    return parent.all ? kAll : kSkip;
+}
+
+int32 JsonProjection::MaxItems(int32 node) const
+{
+    return node >= 0 ? fNodes[node].maxItems : -1;
+}
+
+// JsonDecoder
+
+JsonDecoder::JsonDecoder(const JsonProjection* projection)
+    :
+    fProjection(projection),
+    fPos(NULL),
+    fEnd(NULL),
+    fSkipped(0)
+{
+}
+
+status_t JsonDecoder::Decode(const char* json, size_t length, BMessage* result)
+{
+    fPos = json;
+    fEnd = json + length;
+    fSkipped = 0;
+
+    int32 root = fProjection != NULL ? 0 : kAll;
+
+    SkipWhitespace();
+    status_t status;
+
+    if (fPos < fEnd && *fPos == '{') {
+        result->what = kJsonObjectWhat;
+        status = DecodeObject(root, result, 0);
+    } else if (fPos < fEnd && *fPos == '[') {
+        result->what = kJsonArrayWhat;
+        status = DecodeArray(root, result, 0);
+    } else {
+        return B_BAD_DATA;
+    }
+    if (status != B_OK) {
+        return status;
+    }
+
+    SkipWhitespace();
+    return fPos == fEnd ? B_OK : B_BAD_DATA;
+}
+
+status_t JsonDecoder::DecodeValue(int32 node, const char* name, BMessage* target, int32 depth)
+{
+    if (depth > kMaxDepth) {
+        return B_BAD_DATA;
+    }
+
+    SkipWhitespace();
+    if (fPos >= fEnd) {
+        return B_BAD_DATA;
+    }
+    if (node == kSkip) {
+        return SkipValue(depth);
+    }
+
+    bool selected = node == kAll || fProjection->fNodes[node].all;
+
+    switch (*fPos) {
+        case '{': {
+            BMessage object(kJsonObjectWhat);
+            status_t result = DecodeObject(node, &object, depth + 1);
+            if (result == B_OK) {
+                result = target->AddMessage(name, &object);
+            }
+            return result;
+        }
+        case '[': {
+            BMessage array(kJsonArrayWhat);
+            status_t result = DecodeArray(node, &array, depth + 1);
+            if (result == B_OK) {
+                result = target->AddMessage(name, &array);
+            }
+            return result;
+        }
+        case '"': {
+            if (!selected) {
+                return SkipValue(depth);
+            }
+            std::string value;
+            status_t result = DecodeString(&value);
+            if (result == B_OK) {
+                result = target->AddString(name, value.c_str());
+            }
+            return result;
+        }
+        case 't':
+        case 'f': {
+            bool value = *fPos == 't';
+            if (!(value ? ConsumeLiteral("true", 4) : ConsumeLiteral("false", 5))) {
+                return B_BAD_DATA;
+            }
+            return selected ? target->AddBool(name, value) : B_OK;
+        }
+        case 'n':
+            // BJson keeps nulls, but none of our mappings can do anything with them
+            return ConsumeLiteral("null", 4) ? B_OK : B_BAD_DATA;
+        default: {
+            if (!selected) {
+                return SkipValue(depth);
+            }
+            double value;
+            status_t result = DecodeNumber(&value);
+            if (result == B_OK) {
+                result = target->AddDouble(name, value);
+            }
+            return result;
+        }
+    }
+}
+
+status_t JsonDecoder::DecodeObject(int32 node, BMessage* target, int32 depth)
+{
+    if (!Consume('{')) {
+        return B_BAD_DATA;
+    }
+    SkipWhitespace();
+    if (Consume('}')) {
+        return B_OK;
+    }
+
+    std::string key;
+    for (;;) {
+        SkipWhitespace();
+        status_t result = DecodeString(&key);
+        if (result != B_OK) {
+            return result;
+        }
+        SkipWhitespace();
+        if (!Consume(':')) {
+            return B_BAD_DATA;
+        }
+
+        int32 child = node == kAll ? kAll : fProjection->Child(node, key);
+        result = DecodeValue(child, key.c_str(), target, depth);
+        if (result != B_OK) {
+            return result;
+        }
+
+        SkipWhitespace();
+        if (Consume('}')) {
+            return B_OK;
+        }
+        if (!Consume(',')) {
+            return B_BAD_DATA;
+        }
+    }
+}
+
+status_t JsonDecoder::DecodeArray(int32 node, BMessage* target, int32 depth)
+{
+    if (!Consume('[')) {
+        return B_BAD_DATA;
+    }
+    SkipWhitespace();
+    if (Consume(']')) {
+        return B_OK;
+    }
+
+    int32 element = node == kAll ? kAll : fProjection->Child(node, "*");
+    int32 maxItems = node == kAll ? -1 : fProjection->MaxItems(node);
+    char name[16];
+
+    for (int32 index = 0; ; index++) {
+        status_t result;
+        if (maxItems >= 0 && index >= maxItems) {
+            SkipWhitespace();
+            result = SkipValue(depth);
+        } else {
+            snprintf(name, sizeof(name), "%" B_PRId32, index);
+            result = DecodeValue(element, name, target, depth);
+        }
+        if (result != B_OK) {
+            return result;
+        }
+
+        SkipWhitespace();
+        if (Consume(']')) {
+            return B_OK;
+        }
+        if (!Consume(',')) {
+            return B_BAD_DATA;
+        }
+    }
+}
+
+static void AppendUtf8(std::string* target, uint32 codePoint)
+{
+    if (codePoint < 0x80) {
+        target->push_back(codePoint);
+    } else if (codePoint < 0x800) {
+        target->push_back(0xc0 | (codePoint >> 6));
+        target->push_back(0x80 | (codePoint & 0x3f));
+    } else if (codePoint < 0x10000) {
+        target->push_back(0xe0 | (codePoint >> 12));
+        target->push_back(0x80 | ((codePoint >> 6) & 0x3f));
+        target->push_back(0x80 | (codePoint & 0x3f));
+    } else {
+        target->push_back(0xf0 | (codePoint >> 18));
+        target->push_back(0x80 | ((codePoint >> 12) & 0x3f));
+        target->push_back(0x80 | ((codePoint >> 6) & 0x3f));
+        target->push_back(0x80 | (codePoint & 0x3f));
+    }
+}
+
+static bool ParseHex4(const char* pos, uint32* value)
+{
+    *value = 0;
+    for (int32 i = 0; i < 4; i++) {
+        char c = pos[i];
+        *value <<= 4;
+        if (c >= '0' && c <= '9') {
+            *value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            *value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            *value |= c - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+status_t JsonDecoder::DecodeString(std::string* value)
+{
+    if (!Consume('"')) {
+        return B_BAD_DATA;
+    }
+    value->clear();
+
+    while (fPos < fEnd) {
+        // copy unescaped runs in one go
+        const char* start = fPos;
+        while (fPos < fEnd && *fPos != '"' && *fPos != '\\') {
+            fPos++;
+        }
+        value->append(start, fPos - start);
+
+        if (fPos >= fEnd) {
+            break;
+        }
+        if (*fPos++ == '"') {
+            return B_OK;
+        }
+        if (fPos >= fEnd) {
+            break;
+        }
+
+        char escaped = *fPos++;
+        switch (escaped) {
+            case '"':
+            case '\\':
+            case '/':
+                value->push_back(escaped);
+                break;
+            case 'b': value->push_back('\b'); break;
+            case 'f': value->push_back('\f'); break;
+            case 'n': value->push_back('\n'); break;
+            case 'r': value->push_back('\r'); break;
+            case 't': value->push_back('\t'); break;
+            case 'u': {
+                uint32 codePoint;
+                if (fEnd - fPos < 4 || !ParseHex4(fPos, &codePoint)) {
+                    return B_BAD_DATA;
+                }
+                fPos += 4;
+                // combine surrogate pairs, anything else outside the BMP is invalid
+                if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+                    uint32 low;
+                    if (fEnd - fPos < 6 || fPos[0] != '\\' || fPos[1] != 'u'
+                        || !ParseHex4(fPos + 2, &low) || low < 0xdc00 || low >= 0xe000) {
+                        return B_BAD_DATA;
+                    }
+                    fPos += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                }
+                AppendUtf8(value, codePoint);
+                break;
+            }
+            default:
+                return B_BAD_DATA;
+        }
+    }
+    return B_BAD_DATA;
+}
+
+status_t JsonDecoder::DecodeNumber(double* value)
+{
+    char buffer[64];
+    size_t length = 0;
+
+    while (fPos + length < fEnd && length < sizeof(buffer) - 1
+        && strchr("+-0123456789.eE", fPos[length]) != NULL) {
+        length++;
+    }
+    if (length == 0) {
+        return B_BAD_DATA;
+    }
+
+    memcpy(buffer, fPos, length);
+    buffer[length] = '\0';
+
+    char* end;
+    *value = strtod(buffer, &end);
+    if (end != buffer + length) {
+        return B_BAD_DATA;
+    }
+
+    fPos += length;
+    return B_OK;
+}
+
+/**
+* skips any value without decoding it, containers are skipped by tracking the nesting level only.
+*/
+status_t JsonDecoder::SkipValue(int32 depth)
+{
+    const char* start = fPos;
+    status_t result = B_OK;
+
+    if (*fPos == '"') {
+        result = SkipString();
+    } else if (*fPos == '{' || *fPos == '[') {
+        int32 level = 0;
+        do {
+            switch (*fPos) {
+                case '"':
+                    result = SkipString();
+                    continue;
+                case '{':
+                case '[':
+                    if (++level + depth > kMaxDepth) {
+                        return B_BAD_DATA;
+                    }
+                    break;
+                case '}':
+                case ']':
+                    level--;
+                    break;
+            }
+            fPos++;
+        } while (result == B_OK && level > 0 && fPos < fEnd);
+
+        if (level > 0) {
+            result = B_BAD_DATA;
+        }
+    } else {
+        // number or literal
+        while (fPos < fEnd && strchr(",}] \t\r\n", *fPos) == NULL) {
+            fPos++;
+        }
+    }
+
+    fSkipped += fPos - start;
+    return result;
+}
+
+status_t JsonDecoder::SkipString()
+{
+    const char* pos = fPos + 1;
+
+    for (;;) {
+        const char* quote = static_cast<const char*>(memchr(pos, '"', fEnd - pos));
+        if (quote == NULL) {
+            fPos = fEnd;
+            return B_BAD_DATA;
+        }
+        // the quote is escaped if preceded by an odd number of backslashes
+        const char* backslash = quote;
+        while (backslash > pos && backslash[-1] == '\\') {
+            backslash--;
+        }
+        pos = quote + 1;
+        if (((quote - backslash) & 1) == 0) {
+            fPos = pos;
+            return B_OK;
+        }
+    }
+}
+
+void JsonDecoder::SkipWhitespace()
+{
+    while (fPos < fEnd && (*fPos == ' ' || *fPos == '\n' || *fPos == '\r' || *fPos == '\t')) {
+        fPos++;
+    }
+}
+
+bool JsonDecoder::Consume(char c)
+{
+    if (fPos < fEnd && *fPos == c) {
+        fPos++;
+        return true;
+    }
+    return false;
+}
+
+bool JsonDecoder::ConsumeLiteral(const char* literal, size_t length)
+{
+    if ((size_t)(fEnd - fPos) < length || memcmp(fPos, literal, length) != 0) {
+        return false;
+    }
+    fPos += length;
+    return true;
+}
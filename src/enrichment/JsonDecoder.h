@@ -0,0 +1,82 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+* selects the parts of a JSON document to decode.
+* Paths are object keys separated by '/', with "*" matching any array element, so the titles
+* of all search results are selected by the keys "docs", "*" and "title".
+* A path selects the entire subtree below its last key.
+*/
+class JsonProjection {
+
+public:
+    JsonProjection();
+
+    void        AddPath(const char* path);
+    // only decode the first @maxItems elements of the array at @path, skip the rest
+    void        SetMaxItems(const char* path, int32 maxItems);
+
+    bool        IsEmpty() const { return fNodes.size() == 1 && !fNodes[0].all; }
+
+private:
+    friend class JsonDecoder;
+
+    struct Node {
+        std::map<std::string, int32, std::less<> >  children;
+        bool                                        all;
+        int32                                       maxItems;
+    };
+
+    int32       FindOrAdd(const char* path);
+    // returns the projection node for @key below @node, kSkip or kAll
+    int32       Child(int32 node, std::string_view key) const;
+    int32       MaxItems(int32 node) const;
+
+    std::vector<Node>   fNodes;     // root is at 0
+};
+
+/**
+* single pass JSON decoder producing the same BMessage layout as BJson::Parse(), but only for
+* the parts selected by a JsonProjection. Everything else is skipped with a structural scan that
+* only looks for quotes and brackets, without unescaping strings or converting numbers.
+*/
+class JsonDecoder {
+
+public:
+    // without projection, the whole document is decoded
+    JsonDecoder(const JsonProjection* projection = NULL);
+
+    status_t    Decode(const char* json, size_t length, BMessage* result);
+
+    // bytes passed over without decoding in the last Decode() call
+    size_t      SkippedBytes() const { return fSkipped; }
+
+private:
+    status_t    DecodeValue(int32 node, const char* name, BMessage* target, int32 depth);
+    status_t    DecodeObject(int32 node, BMessage* target, int32 depth);
+    status_t    DecodeArray(int32 node, BMessage* target, int32 depth);
+    status_t    DecodeString(std::string* value);
+    status_t    DecodeNumber(double* value);
+    status_t    SkipValue(int32 depth);
+    status_t    SkipString();
+
+    void        SkipWhitespace();
+    bool        Consume(char c);
+    bool        ConsumeLiteral(const char* literal, size_t length);
+
+    const JsonProjection*   fProjection;
+    const char*             fPos;
+    const char*             fEnd;
+    size_t                  fSkipped;
+};
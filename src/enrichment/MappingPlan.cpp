@@ -0,0 +1,330 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <Locker.h>
+#include <ctype.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "MappingPlan.h"
+#include "Sensei.h"
+#include "../common/FlatMessage.h"
+#include "../common/Log.h"
+#include "../common/Metrics.h"
+
+// separates the values of multi-valued string attributes
+static const char kValueSeparator = ';';
+
+// arrays up to this size are converted without allocating
+static const int32 kMaxStackValues = 16;
+
+static void Trim(const char** value, size_t* length)
+{
+    while (*length > 0 && isspace((unsigned char)**value)) {
+        (*value)++;
+        (*length)--;
+    }
+    while (*length > 0 && isspace((unsigned char)(*value)[*length - 1])) {
+        (*length)--;
+    }
+}
+
+// the string up to the terminating NUL, which is included in the attribute size
+static size_t StringLength(const void* data, ssize_t size)
+{
+    return size > 0 ? strnlen(reinterpret_cast<const char*>(data), size) : 0;
+}
+
+MappingPlan::MappingPlan(const MappingUtil* mapper, std::shared_ptr<const MimeSchema> schema)
+    :
+    fSchema(schema),
+    fNameParam(-1)
+{
+    // attributes to parameters, without the internal attributes that are never sent
+    for (int32 i = 0; i < mapper->CountAttributes(); i++) {
+        const char* attrName = mapper->AttributeAt(i);
+        const char* paramName = mapper->ResolveAlias(attrName);
+        bool isName = strcmp(attrName, SENSEI_NAME) == 0;
+        if (paramName == NULL || (!isName && MappingUtil::IsInternalAttr(attrName))) {
+            continue;
+        }
+
+        auto it = std::find(fParamNames.begin(), fParamNames.end(), paramName);
+        int32 param = it - fParamNames.begin();
+        if (it == fParamNames.end()) {
+            fParamNames.push_back(BString(paramName));
+        }
+
+        if (isName) {
+            fNameParam = param;
+        } else {
+            fParams.push_back({ BString(attrName), param });
+        }
+    }
+    std::sort(fParams.begin(), fParams.end(),
+        [](const ParamEntry& a, const ParamEntry& b) {
+            return strcmp(a.attrName.String(), b.attrName.String()) < 0;
+        });
+
+    // and back, attributes not in the schema are kept as strings like before
+    for (int32 i = 0; i < mapper->CountAliases(); i++) {
+        const char* paramName = mapper->AliasAt(i);
+        const char* attrName = mapper->ResolveAlias(paramName);
+        if (attrName == NULL) {
+            continue;
+        }
+        type_code attrType = fSchema != NULL ? fSchema->TypeOf(attrName, B_STRING_TYPE) : B_STRING_TYPE;
+        fAttrs.push_back({ BString(paramName), BString(attrName), attrType });
+    }
+}
+
+status_t MappingPlan::Get(const MappingUtil* mapper, const char* mimeType,
+    std::shared_ptr<const MappingPlan>& plan)
+{
+    static BLocker sLock("mapping plans");
+    static std::map<std::pair<const MappingUtil*, std::string>, std::shared_ptr<const MappingPlan> > sPlans;
+
+    std::shared_ptr<const MimeSchema> schema;
+    status_t result = MappingUtil::GetMimeTypeSchema(mimeType, schema);
+    if (result != B_OK) {
+        SLOG_ERROR("failed to get MIME attribute definitions for %s: %s\n", mimeType, strerror(result));
+        return result;
+    }
+
+    if (!mapper->IsCompiled()) {
+        plan = std::make_shared<MappingPlan>(mapper, schema);
+        return B_OK;
+    }
+
+    BAutolock locker(sLock);
+
+    // the schema cache drops a schema when its MIME type changes, so a new one means a new plan
+    std::shared_ptr<const MappingPlan>& cached = sPlans[std::make_pair(mapper, std::string(mimeType))];
+    if (cached == NULL || cached->Schema() != schema.get()) {
+        METRICS_COUNT("mapping.plans_compiled", 1);
+        cached = std::make_shared<MappingPlan>(mapper, schema);
+    }
+    plan = cached;
+
+    return B_OK;
+}
+
+int32 MappingPlan::FindParam(const char* attrName) const
+{
+    auto it = std::lower_bound(fParams.begin(), fParams.end(), attrName,
+        [](const ParamEntry& entry, const char* name) {
+            return strcmp(entry.attrName.String(), name) < 0;
+        });
+
+    if (it == fParams.end() || strcmp(it->attrName.String(), attrName) != 0) {
+        return -1;
+    }
+    return it->param;
+}
+
+status_t MappingPlan::MapAttrsToParams(AttributeView* attrView, BMessage* params) const
+{
+    METRICS_STAGE("enricher.map_params");
+
+    status_t result = attrView->InitCheck();
+    if (result != B_OK) {
+        SLOG_ERROR("could not read attributes of %s: %s\n", attrView->Ref()->name, strerror(result));
+        return result;
+    }
+
+    const void* data;
+    ssize_t size;
+
+    for (int32 i = 0; i <= attrView->CountAttrs(); i++) {
+        int32 param;
+        type_code type = B_STRING_TYPE;
+        const char* attrName;
+
+        if (i < attrView->CountAttrs()) {
+            attrName = attrView->NameAt(i);
+            param = FindParam(attrName);
+            if (param < 0) {
+                continue;
+            }
+            type = attrView->TypeAt(i);
+            result = attrView->FindDataAt(i, &data, &size);
+            if (result != B_OK) {
+                SLOG_WARN("could not read attribute '%s' @%d, skipping: %s\n", attrName, i, strerror(result));
+                continue;
+            }
+        } else {
+            attrName = SENSEI_NAME;
+            param = fNameParam;
+            if (param < 0) {
+                break;
+            }
+            data = attrView->Ref()->name;
+            size = strlen(attrView->Ref()->name) + 1;
+        }
+
+        const char* paramName = fParamNames[param].String();
+        if (type != B_STRING_TYPE) {
+            // add typed data, only convert on demand later
+            params->AddData(paramName, type, data, size, false);
+            continue;
+        }
+
+        // multi-valued strings are added as one value each, empty values are dropped
+        const char* value = reinterpret_cast<const char*>(data);
+        const char* end = value + StringLength(data, size);
+        if (value == end) {
+            SLOG_DEBUG("ignoring empty string value for attribute '%s' [%s]\n", paramName, attrName);
+            continue;
+        }
+        while (value <= end) {
+            const char* separator = std::find(value, end, kValueSeparator);
+            const char* part = value;
+            size_t length = separator - value;
+            Trim(&part, &length);
+            if (length > 0) {
+                params->AddString(paramName, BString(part, length));
+            }
+            value = separator + 1;
+        }
+    }
+    return B_OK;
+}
+
+status_t MappingPlan::MapResultToAttrs(const BMessage* result, BMessage* attrs) const
+{
+    METRICS_STAGE("enricher.map_result");
+
+    type_code type;
+    int32 count;
+    const void* data;
+    ssize_t size;
+    status_t status;
+
+    for (const AttrEntry& entry : fAttrs) {
+        const char* paramName = entry.paramName.String();
+        if (result->GetInfo(paramName, &type, &count) != B_OK) {
+            continue;
+        }
+
+        if (type == B_MESSAGE_TYPE) {
+            // JSON arrays are nested messages, read in place and converted in one go
+            status = result->FindData(paramName, type, 0, &data, &size);
+            if (status == B_OK) {
+                status = MapArray(data, size, entry, attrs);
+            }
+        } else {
+            // the converter is selected once per field, not per value
+            TypeConverter::convert_func convert = TypeConverter::Find(type, entry.attrType);
+            if (convert != NULL) {
+                status = convert(result, paramName, count, attrs, entry.attrName.String());
+            } else if (type == entry.attrType) {
+                status = TypeConverter::Convert(result, paramName, type, attrs, entry.attrName.String());
+            } else {
+                status = B_NOT_SUPPORTED;
+            }
+        }
+
+        if (status != B_OK) {
+            SLOG_WARN("could not convert '%s' from type %d to %d, skipping: %s\n", entry.attrName.String(),
+                type, entry.attrType, strerror(status));
+        }
+    }
+    return B_OK;
+}
+
+status_t MappingPlan::MapArray(const void* data, ssize_t size, const AttrEntry& entry, BMessage* attrs) const
+{
+    type_value stackValues[kMaxStackValues];
+    std::vector<type_value> heapValues;
+    type_value* values = stackValues;
+    int32 count = 0;
+    type_code type = 0;
+
+    // only needed for messages in a format FlatMessage cannot read
+    BMessage unflattened;
+
+    FlatMessage array(data, size);
+    if (array.InitCheck() == B_OK) {
+        if (!array.IsArray()) {
+            SLOG_DEBUG("skipping '%s', objects cannot be mapped to attributes.\n", entry.paramName.String());
+            return B_OK;
+        }
+        count = array.CountFields();
+    } else {
+        status_t result = unflattened.Unflatten(reinterpret_cast<const char*>(data));
+        if (result != B_OK) {
+            return result;
+        }
+        if (!FlatMessage::IsArray(&unflattened)) {
+            SLOG_DEBUG("skipping '%s', objects cannot be mapped to attributes.\n", entry.paramName.String());
+            return B_OK;
+        }
+        count = unflattened.CountNames(B_ANY_TYPE);
+    }
+
+    if (count > kMaxStackValues) {
+        heapValues.resize(count);
+        values = heapValues.data();
+    }
+
+    // all elements should have the type of the first, others are skipped
+    int32 valueCount = 0;
+    for (int32 i = 0; i < count; i++) {
+        const char* name;
+        char* unflattenedName;
+        type_code elementType;
+        int32 elementCount;
+        status_t result;
+
+        if (array.InitCheck() == B_OK) {
+            result = array.GetFieldAt(i, &name, &elementType, &elementCount);
+            if (result == B_OK) {
+                result = array.FindDataAt(i, 0, &values[valueCount].data, &values[valueCount].size);
+            }
+        } else {
+            result = unflattened.GetInfo(B_ANY_TYPE, i, &unflattenedName, &elementType, &elementCount);
+            if (result == B_OK) {
+                result = unflattened.FindData(unflattenedName, elementType, 0, &values[valueCount].data,
+                    &values[valueCount].size);
+            }
+        }
+        if (result != B_OK) {
+            return result;
+        }
+
+        if (valueCount == 0) {
+            type = elementType;
+        } else if (elementType != type) {
+            SLOG_DEBUG("skipping element %d of '%s' with type %d instead of %d.\n", i,
+                entry.paramName.String(), elementType, type);
+            continue;
+        }
+        valueCount++;
+    }
+    if (valueCount == 0) {
+        return B_OK;
+    }
+
+    TypeConverter::convert_values_func convert = TypeConverter::FindValues(type, entry.attrType);
+    if (convert != NULL) {
+        return convert(values, valueCount, attrs, entry.attrName.String());
+    }
+    if (type != entry.attrType) {
+        return B_NOT_SUPPORTED;
+    }
+
+    // nothing to convert, but still copied
+    for (int32 i = 0; i < valueCount; i++) {
+        status_t result = attrs->AddData(entry.attrName.String(), type, values[i].data, values[i].size, false);
+        if (result != B_OK) {
+            return result;
+        }
+    }
+    return B_OK;
+}
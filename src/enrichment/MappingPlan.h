@@ -0,0 +1,76 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <memory>
+#include <vector>
+
+#include "../common/AttributeView.h"
+#include "../common/MappingUtil.h"
+#include "../common/TypeConverter.h"
+
+/**
+* the mapping between the attributes of one entity type and the parameters of a service,
+* compiled once from the aliases of a MappingUtil and the attribute types of a MIME type.
+* Both directions run in a single pass: attributes are read from an AttributeView straight into
+* service parameters, and result fields, including the nested arrays of decoded JSON, are read in
+* place and converted straight to the attribute types.
+*/
+class MappingPlan {
+
+public:
+    MappingPlan(const MappingUtil* mapper, std::shared_ptr<const MimeSchema> schema);
+
+    /**
+    * returns the plan of @mapper for @mimeType, compiled on first use and again when the schema
+    * of the MIME type changed. Only plans of compiled mappers are cached, as others may still change.
+    */
+    static status_t Get(const MappingUtil* mapper, const char* mimeType,
+                        std::shared_ptr<const MappingPlan>& plan);
+
+    const MimeSchema*   Schema() const { return fSchema.get(); }
+    int32               CountParams() const { return fParamNames.size(); }
+    int32               CountAttrs() const { return fAttrs.size(); }
+
+    /**
+    * adds the mapped attributes of @attrView to @params, multi-valued strings are split.
+    */
+    status_t    MapAttrsToParams(AttributeView* attrView, BMessage* params) const;
+    /**
+    * adds the mapped fields of the service result @result to @attrs, converted to the types of
+    * the attributes. Arrays (nested messages keyed "0", "1", ...) become multi-valued attributes.
+    */
+    status_t    MapResultToAttrs(const BMessage* result, BMessage* attrs) const;
+
+private:
+    struct ParamEntry {
+        BString     attrName;
+        int32       param;      // index into fParamNames
+    };
+
+    struct AttrEntry {
+        BString     paramName;
+        BString     attrName;
+        type_code   attrType;
+    };
+
+    int32               FindParam(const char* attrName) const;
+    status_t            MapArray(const void* data, ssize_t size, const AttrEntry& entry,
+                                 BMessage* attrs) const;
+
+    std::shared_ptr<const MimeSchema>   fSchema;
+
+    // sorted by attribute name, several attributes may map to the same parameter as fallbacks
+    std::vector<ParamEntry>     fParams;
+    std::vector<BString>        fParamNames;
+    // the file name is a pseudo attribute, only used if mapped and always after the real ones
+    int32                       fNameParam;
+
+    std::vector<AttrEntry>      fAttrs;
+};
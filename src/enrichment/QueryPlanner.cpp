@@ -0,0 +1,184 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <Locker.h>
+#include <OS.h>
+
+#include <algorithm>
+
+#include "QueryPlanner.h"
+#include "../common/Log.h"
+#include "../common/TaskGraph.h"
+
+// a strategy needs this many attempts before its hit rate is trusted
+static const int64 kMinAttemptsForRanking = 20;
+// strategies with fewer confident answers than this percentage of attempts are tried last
+static const int64 kMinHitRatePercent = 10;
+
+QueryPlanner::QueryPlanner(const char* name, int32 speculation)
+    :
+    fName(name),
+    fSpeculation(std::max(speculation, (int32)1))
+{
+}
+
+int32 QueryPlanner::AddStrategy(const char* name)
+{
+    BString prefix;
+    prefix << "query." << fName << "." << name;
+
+    Metrics* metrics = Metrics::Default();
+    Strategy strategy;
+    strategy.name = name;
+    strategy.latency = metrics->HistogramFor(prefix.String());
+    strategy.attempts = metrics->CounterFor(BString(prefix).Append(".attempts").String());
+    strategy.hits = metrics->CounterFor(BString(prefix).Append(".hits").String());
+    strategy.wins = metrics->CounterFor(BString(prefix).Append(".wins").String());
+    strategy.canceled = metrics->CounterFor(BString(prefix).Append(".canceled").String());
+
+    fStrategies.push_back(strategy);
+    return fStrategies.size() - 1;
+}
+
+const char* QueryPlanner::StrategyName(int32 strategy) const
+{
+    if (strategy < 0 || strategy >= (int32)fStrategies.size()) {
+        return NULL;
+    }
+    return fStrategies[strategy].name.String();
+}
+
+void QueryPlanner::SetSpeculation(int32 speculation)
+{
+    fSpeculation = std::max(speculation, (int32)1);
+}
+
+status_t QueryPlanner::Execute(std::vector<query_step>& plan, strategy_func func, BMessage* result,
+    int32* winner)
+{
+    // demoted strategies go last, otherwise the order of registration counts
+    std::stable_sort(plan.begin(), plan.end(),
+        [this](const query_step& a, const query_step& b) {
+            bool demotedA = IsDemoted(a.strategy);
+            bool demotedB = IsDemoted(b.strategy);
+            if (demotedA != demotedB) {
+                return demotedB;
+            }
+            return a.strategy < b.strategy;
+        });
+
+    BLocker lock("query plan");
+    int32 canceled = 0;
+    int32 best = -1;                            // index of the step whose result was taken
+    query_confidence bestConfidence = QUERY_MISS;
+    status_t firstError = B_OK;                 // of the best ranked step that failed
+    int32 firstErrorIndex = -1;
+    bool anyCompleted = false;
+
+    result->MakeEmpty();
+
+    auto runStep = [&](int32 index) -> status_t {
+        const query_step& step = plan[index];
+        Strategy& strategy = fStrategies[step.strategy];
+
+        if (atomic_get(&canceled) != 0) {
+            strategy.canceled->fetch_add(1, std::memory_order_relaxed);
+            return B_CANCELED;
+        }
+
+        strategy.attempts->fetch_add(1, std::memory_order_relaxed);
+        SLOG_DEBUG("running %s query strategy '%s'.\n", fName.String(), strategy.name.String());
+
+        BMessage stepResult;
+        query_confidence confidence = QUERY_MISS;
+        bigtime_t start = system_time();
+        status_t status = func(&step, &canceled, &stepResult, &confidence);
+
+        if (status == B_CANCELED) {
+            strategy.canceled->fetch_add(1, std::memory_order_relaxed);
+            return status;
+        }
+        strategy.latency->Record(system_time() - start);
+        if (status != B_OK) {
+            confidence = QUERY_MISS;
+        } else if (confidence == QUERY_CONFIDENT) {
+            strategy.hits->fetch_add(1, std::memory_order_relaxed);
+        }
+
+        BAutolock locker(lock);
+        if (status == B_OK) {
+            anyCompleted = true;
+        } else if (firstErrorIndex < 0 || index < firstErrorIndex) {
+            firstError = status;
+            firstErrorIndex = index;
+        }
+
+        // the first confident answer is taken, weak answers only replace worse ranked ones
+        if (bestConfidence != QUERY_CONFIDENT && confidence != QUERY_MISS
+            && (confidence > bestConfidence || index < best)) {
+            best = index;
+            bestConfidence = confidence;
+            *result = stepResult;
+
+            if (confidence == QUERY_CONFIDENT) {
+                atomic_set(&canceled, 1);
+            }
+        }
+        return status;
+    };
+
+    int32 count = plan.size();
+    for (int32 waveStart = 0; waveStart < count && bestConfidence != QUERY_CONFIDENT;
+            waveStart += fSpeculation) {
+        int32 waveEnd = std::min(count, waveStart + fSpeculation);
+
+        if (waveEnd - waveStart == 1) {
+            runStep(waveStart);
+            continue;
+        }
+
+        TaskGraph graph(fName.String());
+        for (int32 index = waveStart; index < waveEnd; index++) {
+            graph.AddTask(StrategyName(plan[index].strategy), [&runStep, index]() {
+                return runStep(index);
+            });
+        }
+        if (graph.Run() != B_OK) {
+            // no threads, still try the steps one after the other
+            for (int32 index = waveStart; index < waveEnd && bestConfidence != QUERY_CONFIDENT; index++) {
+                runStep(index);
+            }
+            continue;
+        }
+        graph.Wait();
+    }
+
+    if (best < 0) {
+        if (!anyCompleted && firstErrorIndex >= 0) {
+            return firstError;
+        }
+        return B_ENTRY_NOT_FOUND;
+    }
+
+    const query_step& step = plan[best];
+    fStrategies[step.strategy].wins->fetch_add(1, std::memory_order_relaxed);
+    SLOG_DEBUG("%s query strategy '%s' won with %s answer.\n", fName.String(),
+        StrategyName(step.strategy), bestConfidence == QUERY_CONFIDENT ? "confident" : "weak");
+
+    if (winner != NULL) {
+        *winner = step.strategy;
+    }
+    return B_OK;
+}
+
+bool QueryPlanner::IsDemoted(int32 strategy) const
+{
+    int64 attempts = fStrategies[strategy].attempts->load(std::memory_order_relaxed);
+    if (attempts < kMinAttemptsForRanking) {
+        return false;
+    }
+    int64 hits = fStrategies[strategy].hits->load(std::memory_order_relaxed);
+    return hits * 100 < attempts * kMinHitRatePercent;
+}
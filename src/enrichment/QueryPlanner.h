@@ -0,0 +1,81 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "../common/Metrics.h"
+
+enum query_confidence {
+    QUERY_MISS = 0,     // nothing found
+    QUERY_WEAK,         // found something, but it may not be what we are looking for
+    QUERY_CONFIDENT     // found it, no need to wait for other strategies
+};
+
+// one strategy to run for a lookup, with the parameters it needs
+struct query_step {
+    int32       strategy;
+    BMessage    params;
+};
+
+/**
+* runs alternative lookup strategies for one entity, like searching a book by ISBN, by title and
+* author or by free text.
+* Strategies are ranked by their order of registration, but a strategy that rarely finds
+* anything is tried after the others. The top ranked steps of a plan run speculatively in
+* parallel, the first confident answer wins and cancels the others. Without a confident answer,
+* the next steps run, and if none is confident, the best ranked weak answer is taken.
+* Attempts, hits, wins and latency are tracked per strategy in the Metrics as
+* "query.<planner>.<strategy>.*". Execute() may be called for several lookups at once.
+*/
+class QueryPlanner {
+
+public:
+    /**
+    * runs the strategy @step->strategy with @step->params, sets @confidence and fills @result.
+    * Once @canceled is set, it should give up as soon as possible with B_CANCELED.
+    */
+    typedef std::function<status_t(const query_step* step, const int32* canceled,
+                                   BMessage* result, query_confidence* confidence)> strategy_func;
+
+    QueryPlanner(const char* name, int32 speculation = 2);
+
+    // returns the strategy ID, strategies added first rank highest
+    int32       AddStrategy(const char* name);
+    const char* StrategyName(int32 strategy) const;
+
+    // number of strategies run in parallel
+    void        SetSpeculation(int32 speculation);
+
+    /**
+    * runs the steps of @plan as ranked, @winner is set to the strategy of the @result taken.
+    * Returns B_ENTRY_NOT_FOUND if all steps missed, or the error of the best ranked step if
+    * all steps failed.
+    */
+    status_t    Execute(std::vector<query_step>& plan, strategy_func func, BMessage* result,
+                        int32* winner = NULL);
+
+private:
+    struct Strategy {
+        BString             name;
+        Histogram*          latency;
+        std::atomic<int64>* attempts;
+        std::atomic<int64>* hits;       // confident answers
+        std::atomic<int64>* wins;       // answers taken
+        std::atomic<int64>* canceled;
+    };
+
+    bool        IsDemoted(int32 strategy) const;
+
+    BString                 fName;
+    int32                   fSpeculation;
+    std::vector<Strategy>   fStrategies;
+};
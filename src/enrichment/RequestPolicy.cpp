@@ -0,0 +1,133 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Autolock.h>
+#include <OS.h>
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "RequestPolicy.h"
+
+static const int32      kDefaultMaxRetries = 2;
+static const bigtime_t  kDefaultInitialDelay = 250000;
+static const bigtime_t  kDefaultMaxDelay = 2000000;
+static const bigtime_t  kDefaultAttemptTimeout = 3000000;
+
+// the percentile is meaningless for fewer samples, and hedging too early doubles the load
+static const int32      kMinHedgeSamples = 16;
+static const bigtime_t  kMinHedgeDelay = 50000;
+
+RequestPolicy::RequestPolicy()
+    :
+    fLock("request policy"),
+    fMaxRetries(kDefaultMaxRetries),
+    fInitialDelay(kDefaultInitialDelay),
+    fMaxDelay(kDefaultMaxDelay),
+    fAttemptTimeout(kDefaultAttemptTimeout),
+    fHedging(false)
+{
+}
+
+RequestPolicy* RequestPolicy::Default()
+{
+    static RequestPolicy* sDefaultPolicy = new RequestPolicy();
+    return sDefaultPolicy;
+}
+
+void RequestPolicy::SetMaxRetries(int32 maxRetries)
+{
+    fMaxRetries = std::max(maxRetries, (int32)0);
+}
+
+void RequestPolicy::SetBackoff(bigtime_t initialDelay, bigtime_t maxDelay)
+{
+    fInitialDelay = std::max(initialDelay, (bigtime_t)0);
+    fMaxDelay = std::max(maxDelay, fInitialDelay);
+}
+
+void RequestPolicy::SetAttemptTimeout(bigtime_t timeout)
+{
+    fAttemptTimeout = timeout > 0 ? timeout : kDefaultAttemptTimeout;
+}
+
+void RequestPolicy::SetHedging(bool enabled)
+{
+    fHedging = enabled;
+}
+
+bigtime_t RequestPolicy::AttemptTimeout(bigtime_t deadline) const
+{
+    bigtime_t remaining = deadline - system_time();
+    if (remaining <= 0) {
+        return 0;
+    }
+    return std::min(fAttemptTimeout, remaining);
+}
+
+bool RequestPolicy::RetryDelay(int32 retry, bigtime_t deadline, bigtime_t* delay) const
+{
+    bigtime_t backoff = fInitialDelay;
+    for (int32 i = 0; i < retry && backoff < fMaxDelay; i++) {
+        backoff *= 2;
+    }
+    backoff = std::min(backoff, fMaxDelay);
+
+    // half of it at random, so requests that failed together are not retried together
+    *delay = backoff / 2 + (bigtime_t)(backoff / 2 * (rand() / (RAND_MAX + 1.0)));
+
+    return *delay < deadline - system_time();
+}
+
+bool RequestPolicy::IsTransient(status_t error, int32 statusCode)
+{
+    if (error != B_OK) {
+        // anything but a cancelled request, the network is allowed to fail once in a while
+        return error != B_CANCELED;
+    }
+    return statusCode == 500 || statusCode == 502 || statusCode == 504;
+}
+
+void RequestPolicy::RecordLatency(const char* host, bigtime_t latency)
+{
+    BAutolock locker(fLock);
+
+    auto it = fLatencies.find(host);
+    if (it == fLatencies.end()) {
+        latency_window window;
+        window.count = 0;
+        window.next = 0;
+        it = fLatencies.emplace(host, window).first;
+    }
+
+    latency_window& window = it->second;
+    window.samples[window.next] = latency;
+    window.next = (window.next + 1) % kLatencyWindow;
+    window.count = std::min(window.count + 1, (int32)kLatencyWindow);
+}
+
+bigtime_t RequestPolicy::HedgeDelay(const char* host)
+{
+    if (!fHedging) {
+        return 0;
+    }
+
+    bigtime_t samples[kLatencyWindow];
+    int32 count;
+    {
+        BAutolock locker(fLock);
+        auto it = fLatencies.find(host);
+        if (it == fLatencies.end() || it->second.count < kMinHedgeSamples) {
+            return 0;
+        }
+        count = it->second.count;
+        std::copy(it->second.samples, it->second.samples + count, samples);
+    }
+
+    // nearest rank
+    int32 rank = (count * 95 + 99) / 100 - 1;
+    std::nth_element(samples, samples + rank, samples + count);
+
+    return std::max(samples[rank], kMinHedgeDelay);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Locker.h>
+#include <SupportDefs.h>
+
+#include <string>
+#include <unordered_map>
+
+/**
+* decides how long and how often requests are attempted.
+* Transient failures are retried with exponential backoff, and a slow request may be hedged by
+* sending a duplicate once the 95th percentile latency of its host has passed, the first response
+* wins. Every attempt and every wait is capped by the deadline of the request, if it has one.
+*/
+class RequestPolicy {
+
+public:
+    static RequestPolicy* Default();
+
+    void        SetMaxRetries(int32 maxRetries);
+    void        SetBackoff(bigtime_t initialDelay, bigtime_t maxDelay);
+    void        SetAttemptTimeout(bigtime_t timeout);
+    void        SetHedging(bool enabled);
+
+    int32       MaxRetries() const { return fMaxRetries; }
+    /**
+    * timeout for the next attempt with the absolute @deadline, 0 if the deadline has passed.
+    */
+    bigtime_t   AttemptTimeout(bigtime_t deadline) const;
+    /**
+    * delay before retry number @retry (starting at 0), returns false if the request
+    * would not be sent before @deadline anyway.
+    */
+    bool        RetryDelay(int32 retry, bigtime_t deadline, bigtime_t* delay) const;
+
+    // network errors and server errors that may go away on their own
+    static bool IsTransient(status_t error, int32 statusCode);
+
+    void        RecordLatency(const char* host, bigtime_t latency);
+    // time to wait for a response from @host before hedging, 0 if the request should not be hedged
+    bigtime_t   HedgeDelay(const char* host);
+
+private:
+    enum { kLatencyWindow = 64 };
+
+    struct latency_window {
+        bigtime_t   samples[kLatencyWindow];
+        int32       count;
+        int32       next;
+    };
+
+    RequestPolicy();
+
+    BLocker     fLock;
+    int32       fMaxRetries;
+    bigtime_t   fInitialDelay;
+    bigtime_t   fMaxDelay;
+    bigtime_t   fAttemptTimeout;
+    bool        fHedging;
+
+    // the most recent latencies of successful requests per host
+    std::unordered_map<std::string, latency_window> fLatencies;
+};
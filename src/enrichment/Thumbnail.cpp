@@ -0,0 +1,52 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Node.h>
+#include <string.h>
+
+#include "Thumbnail.h"
+#include "../common/Log.h"
+
+status_t Thumbnail::Write(const entry_ref* ref, const HttpBody& image)
+{
+    if (image.IsEmpty()) {
+        SLOG_WARN("got empty image for %s, skipping thumbnail.\n", ref->name);
+        return B_OK;
+    }
+
+    BNode outputNode(ref);
+    status_t result = outputNode.InitCheck();
+    if (result != B_OK) {
+        SLOG_ERROR("error opening output file %s: %s\n", ref->name, strerror(result));
+        return result;
+    }
+
+    // written straight from the receive buffer
+    ssize_t size = outputNode.WriteAttr(THUMBNAIL_ATTR_NAME, B_RAW_TYPE, 0, image.Data(), image.Size());
+    if (size < (ssize_t)image.Size()) {
+        result = size < 0 ? size : B_IO_ERROR;
+        SLOG_ERROR("error writing thumbnail to file %s: %s\n", ref->name, strerror(result));
+        return result;
+    }
+
+    // set thumbnail creation time so it doesn't get removed, use modification time from node
+    time_t modtime;
+    result = outputNode.GetModificationTime(&modtime);
+    modtime++;  // thumbnail creation time needs to be after file change time to be kept.
+
+    if (result == B_OK) {
+        SLOG_DEBUG("writing thumbnail modification time...\n");
+        size = outputNode.WriteAttr(THUMBNAIL_CREATION_TIME, B_TIME_TYPE, 0, &modtime, sizeof(time_t));
+        if (size < 0) {
+            result = size;
+        }
+    }
+    if (result != B_OK) {
+        SLOG_ERROR("error writing thumbnail to %s: %s\n", ref->name, strerror(result));
+        return result;
+    }
+
+    SLOG_INFO("Cover image written to thumbnail of %s successfully.\n", ref->name);
+    return outputNode.Sync();
+}
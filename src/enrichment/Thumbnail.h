@@ -0,0 +1,27 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Entry.h>
+#include <SupportDefs.h>
+
+#include "HttpBody.h"
+
+#define THUMBNAIL_ATTR_NAME     "Media:Thumbnail"
+#define THUMBNAIL_CREATION_TIME THUMBNAIL_ATTR_NAME ":CreationTime"
+
+/**
+* the thumbnail Tracker shows for a file, stored in its attributes.
+*/
+class Thumbnail {
+
+public:
+    /**
+    * writes @image to the thumbnail attribute of @ref straight from its buffer, needs to be
+    * called after all other attributes are written, or Tracker will consider the thumbnail
+    * outdated and remove it.
+    */
+    static status_t Write(const entry_ref* ref, const HttpBody& image);
+};
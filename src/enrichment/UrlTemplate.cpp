@@ -0,0 +1,134 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <string.h>
+
+#include <charconv>
+
+#include "UrlTemplate.h"
+#include "../common/Log.h"
+#include "../common/TypeConverter.h"
+
+// RFC 3986 unreserved characters, everything else in a value is percent encoded
+static bool IsUnreserved(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+        || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+static void AppendEncoded(const char* value, size_t length, std::string* url)
+{
+    static const char kHexDigits[] = "0123456789ABCDEF";
+
+    for (size_t i = 0; i < length; i++) {
+        char c = value[i];
+        if (IsUnreserved(c)) {
+            url->push_back(c);
+        } else {
+            url->push_back('%');
+            url->push_back(kHexDigits[(uint8)c >> 4]);
+            url->push_back(kHexDigits[(uint8)c & 0x0f]);
+        }
+    }
+}
+
+UrlTemplate::UrlTemplate(const char* pattern)
+    :
+    fPattern(pattern)
+{
+    const char* start = fPattern.String();
+    const char* literal = start;
+    const char* c = start;
+
+    while (*c != '\0') {
+        int32 length = 0;
+        if (*c == '$') {
+            while (IsNameChar(c[length + 1])) {
+                length++;
+            }
+        }
+        if (length == 0) {
+            // a '$' without name is just part of the literal
+            c++;
+            continue;
+        }
+
+        if (c > literal) {
+            fSegments.push_back({ (int32)(literal - start), (int32)(c - literal) });
+        }
+        fSegments.push_back({ (int32)fNames.size(), -1 });
+        fNames.push_back(BString(c + 1, length));
+
+        c += length + 1;
+        literal = c;
+    }
+    if (c > literal) {
+        fSegments.push_back({ (int32)(literal - start), (int32)(c - literal) });
+    }
+}
+
+const char* UrlTemplate::PlaceholderAt(int32 index) const
+{
+    if (index < 0 || index >= CountPlaceholders()) {
+        return NULL;
+    }
+    return fNames[index].String();
+}
+
+status_t UrlTemplate::Render(const BMessage* params, std::string* url) const
+{
+    size_t originalSize = url->size();
+    const char* pattern = fPattern.String();
+
+    for (const Segment& segment : fSegments) {
+        if (segment.length >= 0) {
+            url->append(pattern + segment.offset, segment.length);
+            continue;
+        }
+
+        const char* name = fNames[segment.offset].String();
+        type_code type;
+        int32 count;
+        status_t result = params->GetInfo(name, &type, &count);
+        if (result != B_OK) {
+            SLOG_ERROR("argument mapping is missing parameter '%s'.\n", name);
+            url->resize(originalSize);
+            return B_BAD_DATA;
+        }
+
+        // the common types are formatted without a detour through another message
+        char buffer[32];
+        const char* value = NULL;
+        size_t length = 0;
+
+        switch (type) {
+            case B_STRING_TYPE:
+                value = params->GetString(name, "");
+                length = strlen(value);
+                break;
+            case B_INT32_TYPE:
+                value = buffer;
+                length = std::to_chars(buffer, buffer + sizeof(buffer), params->GetInt32(name, 0)).ptr - buffer;
+                break;
+            case B_INT64_TYPE:
+                value = buffer;
+                length = std::to_chars(buffer, buffer + sizeof(buffer), params->GetInt64(name, 0)).ptr - buffer;
+                break;
+            default: {
+                BMessage converted;
+                result = TypeConverter::Convert(params, name, B_STRING_TYPE, &converted, name);
+                if (result != B_OK) {
+                    SLOG_ERROR("cannot use parameter '%s' of type %d in URL: %s\n", name, type, strerror(result));
+                    url->resize(originalSize);
+                    return B_BAD_DATA;
+                }
+                value = converted.GetString(name, "");
+                AppendEncoded(value, strlen(value), url);
+                continue;
+            }
+        }
+        AppendEncoded(value, length, url);
+    }
+    return B_OK;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/**
+* URL pattern with placeholders like "$coverId", parsed once into literal and placeholder segments.
+* A placeholder name consists of letters, digits and '_'. Values are URL encoded when rendered,
+* so they may contain any characters.
+*/
+class UrlTemplate {
+
+public:
+    UrlTemplate(const char* pattern);
+
+    const char* Pattern() const { return fPattern.String(); }
+    int32       CountPlaceholders() const { return fNames.size(); }
+    const char* PlaceholderAt(int32 index) const;
+
+    /**
+    * appends the URL to @url, with the placeholders replaced by the fields of @params of the
+    * same name. Strings and integers are used as is, other types are converted to strings.
+    * Returns B_BAD_DATA if a placeholder has no value, @url is then left unchanged.
+    */
+    status_t    Render(const BMessage* params, std::string* url) const;
+
+    /**
+    * true if @pattern uses exactly the placeholders in @names, each at least once.
+    * Meant for static_assert()s on the URL constants, so typos are caught at compile time.
+    */
+    static constexpr bool Matches(const char* pattern, std::initializer_list<const char*> names);
+
+private:
+    struct Segment {
+        int32   offset;     // into fPattern for literals, into fNames for placeholders
+        int32   length;     // -1 for placeholders
+    };
+
+    static constexpr bool IsNameChar(char c);
+    static constexpr bool NameEquals(const char* name, int32 length, const char* other);
+
+    BString                 fPattern;
+    std::vector<Segment>    fSegments;
+    std::vector<BString>    fNames;
+};
+
+constexpr bool UrlTemplate::IsNameChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+constexpr bool UrlTemplate::NameEquals(const char* name, int32 length, const char* other)
+{
+    for (int32 i = 0; i < length; i++) {
+        if (other[i] != name[i]) {
+            return false;
+        }
+    }
+    return other[length] == '\0';
+}
+
+constexpr bool UrlTemplate::Matches(const char* pattern, std::initializer_list<const char*> names)
+{
+    // every placeholder has to be in @names
+    for (const char* c = pattern; *c != '\0'; c++) {
+        if (*c != '$') {
+            continue;
+        }
+        int32 length = 0;
+        while (IsNameChar(c[length + 1])) {
+            length++;
+        }
+        if (length == 0) {
+            return false;
+        }
+        bool known = false;
+        for (const char* name : names) {
+            known = known || NameEquals(c + 1, length, name);
+        }
+        if (!known) {
+            return false;
+        }
+        c += length;
+    }
+
+    // and every name has to be used
+    for (const char* name : names) {
+        bool used = false;
+        for (const char* c = pattern; *c != '\0' && !used; c++) {
+            if (*c != '$') {
+                continue;
+            }
+            int32 length = 0;
+            while (IsNameChar(c[length + 1])) {
+                length++;
+            }
+            used = NameEquals(c + 1, length, name);
+        }
+        if (!used) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -6,33 +6,117 @@
  * a simple SEN plugin for grabbing metadata for books, can also be used as a standalone tool.
  */
 #include <Alert.h>
+#include <Autolock.h>
+#include <Directory.h>
 #include <Entry.h>
 #include <Errors.h>
+#include <FindDirectory.h>
 #include <StringList.h>
 #include <fs_attr.h>
 #include <NodeInfo.h>
+#include <Query.h>
+#include <Roster.h>
 #include <MimeType.h>
 #include <Path.h>
+#include <Volume.h>
+#include <VolumeRoster.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include "App.h"
 #include "Sen.h"
 #include "Sensei.h"
+#include "../Isbn.h"
+#include "../RequestPolicy.h"
+#include "../Thumbnail.h"
+#include "../../common/Log.h"
+#include "../../common/Metrics.h"
+#include "../../common/WorkerPool.h"
 
 const char* kApplicationSignature = "application/x-vnd.sen-labs.bert";
 
-App::App() : BApplication(kApplicationSignature)
+// the parameters filled in below have to match the placeholders of the URL patterns
+static_assert(UrlTemplate::Matches(API_AUTHORS_URL, { "id" }), "author URL placeholders changed");
+static_assert(UrlTemplate::Matches(API_COVER_URL, { "coverId", "size" }), "cover URL placeholders changed");
+static_assert(UrlTemplate::Matches(API_AUTHOR_IMG_URL, { "photoId", "size" }), "photo URL placeholders changed");
+
+static const UrlTemplate kAuthorsUrl(API_AUTHORS_URL);
+static const UrlTemplate kCoverUrl(API_COVER_URL);
+static const UrlTemplate kAuthorImageUrl(API_AUTHOR_IMG_URL);
+
+App::App()
+    :
+    BApplication(kApplicationSignature),
+    fBookQueries("book", BOOK_QUERY_SPECULATION),
+    fAuthorLock("bert author files")
 {
+    fIndex = NULL;
+    fFileBudget = (bigtime_t)DEFAULT_FILE_BUDGET * 1000000;
+    fImageMemoryLimit = DEFAULT_IMAGE_MEMORY;
+    fImageMemory = create_sem(fImageMemoryLimit, "bert image memory");
+
+    // set up mapping tables once (all Strings because it's only about names, not values!)
     fMapper = new MappingUtil();
+    fAuthorMapper = new MappingUtil();
+
+    LoadMapping(fMapper, SENSEI_ATTR_MAPPING,
+        kBookMappingProfile, MAPPING_PROFILE_SIZE(kBookMappingProfile));
+    // add file name as fallback if Media:Title is empty, it's a pseudo attribute so not part of the profile
+    fMapper->AddAlias(SENSEI_NAME, "title");
+
+    LoadMapping(fAuthorMapper, AUTHOR_ATTR_MAPPING,
+        kAuthorMappingProfile, MAPPING_PROFILE_SIZE(kAuthorMappingProfile));
+
+    // plugins may declare additional internal attributes to never map
+    app_info appInfo;
+    if (GetAppInfo(&appInfo) == B_OK) {
+        MappingUtil::LoadInternalPrefixes(&appInfo.ref);
+    }
+
+    // freeze for fast read-only lookups
+    fMapper->Compile();
+    fAuthorMapper->Compile();
+
+    // list attributes are merged as sets of values, all others keep a single value
+    static const char* kListAttrs[] = { "Book:Authors", "Book:Languages", "Book:Subjects",
+        "Book:Publisher", "OPENLIB:author_keys" };
+    for (size_t i = 0; i < sizeof(kListAttrs) / sizeof(kListAttrs[0]); i++) {
+        fMerger.SetMultiValued(kListAttrs[i]);
+    }
+
+    BuildProjections();
+
+    // registered in order of preference, IDs are the book_query_strategy values
+    fBookQueries.AddStrategy("isbn");
+    fBookQueries.AddStrategy("title_author");
+    fBookQueries.AddStrategy("free_text");
+    fBookQueries.AddStrategy("attributes");
+
+    // only maps author attributes, requests are made by the enricher of the book, see EnrichBook()
+    fAuthorEnricher = new BaseEnricher(NULL, fAuthorMapper);
+    fAuthorEnricher->SetMimeType(AUTHOR_MIME_TYPE);
 }
 
 App::~App()
 {
-    if (fBaseEnricher) {
-        delete fBaseEnricher;
-    }
+    delete fAuthorEnricher;
     delete fMapper;
+    delete fAuthorMapper;
+    delete fIndex;
+    delete_sem(fImageMemory);
+}
+
+/**
+* nearest rank percentile of the sorted @values.
+*/
+static bigtime_t Percentile(const std::vector<bigtime_t>& values, int32 percent)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    size_t rank = (values.size() * percent + 99) / 100;
+    return values[rank > 0 ? rank - 1 : 0];
 }
 
 int main()
@@ -59,23 +143,63 @@ void App::ArgvReceived(int32 argc, char ** argv) {
     int argIndex = 1;
     bool debug = false;
     bool wipe = false;
-    BString inputPath;
+    int32 jobs = 0;
+    int32 imageMemory = 0;
+    int32 budget = -1;
+    bool hedge = false;
+    BStringList inputPaths;
     BString outputPath;
+    BString query;
+    BString indexPath;
 
-    while (argIndex < argc) {   // last argument is always input file
+    while (argIndex < argc) {   // all other arguments are input files or directories
         const char* arg = argv[argIndex];
-        printf("handling argument #%d: '%s'...\n", argIndex, arg);
+        SLOG_DEBUG("handling argument #%d: '%s'...\n", argIndex, arg);
 
         if (strncmp(arg, "-h", 2) == 0 || strncmp(arg, "--help", 6) == 0) {
             PrintUsage();
             exit(1);
         } else if (strncmp(arg, "-d", 2) == 0 || strncmp(arg, "--debug", 7) == 0) {
             debug = true;
+            Logger::SetLevel(SLOG_LEVEL_DEBUG);
         } else if (strncmp(arg, "-w", 2) == 0 || strncmp(arg, "--wipe", 6) == 0) {
             wipe = true;
         } else if (strncmp(arg, "-o", 2) == 0 || strncmp(arg, "--output", 8) == 0) {
             argIndex++; // advance to next argument after option switch
             outputPath = argv[argIndex];
+        } else if (strncmp(arg, "-j", 2) == 0 || strncmp(arg, "--jobs", 6) == 0) {
+            argIndex++;
+            jobs = argIndex < argc ? atoi(argv[argIndex]) : 0;
+            if (jobs < 1 || jobs > MAX_BATCH_JOBS) {
+                PrintUsage("Invalid number of jobs.");
+                exit(1);
+            }
+        } else if (strncmp(arg, "-m", 2) == 0 || strncmp(arg, "--image-memory", 14) == 0) {
+            argIndex++;
+            imageMemory = argIndex < argc ? atoi(argv[argIndex]) : 0;
+            if (imageMemory < 1) {
+                PrintUsage("Invalid image memory limit.");
+                exit(1);
+            }
+        } else if (strncmp(arg, "-b", 2) == 0 || strncmp(arg, "--budget", 8) == 0) {
+            argIndex++;
+            budget = argIndex < argc ? atoi(argv[argIndex]) : -1;
+            if (budget < 0) {
+                PrintUsage("Invalid time budget.");
+                exit(1);
+            }
+        } else if (strncmp(arg, "--hedge", 7) == 0) {
+            hedge = true;
+        } else if (strncmp(arg, "-i", 2) == 0 || strncmp(arg, "--index", 7) == 0) {
+            argIndex++;
+            if (argIndex < argc) {
+                indexPath = argv[argIndex];
+            }
+        } else if (strncmp(arg, "-q", 2) == 0 || strncmp(arg, "--query", 7) == 0) {
+            argIndex++;
+            if (argIndex < argc) {
+                query = argv[argIndex];
+            }
         } else {
             if (strncmp(arg, "-", 1) == 0 ) {
                 BString errorMsg("unknown parameter ");
@@ -84,23 +208,46 @@ void App::ArgvReceived(int32 argc, char ** argv) {
 
                 exit(1);
             }
-            inputPath = arg;
+            inputPaths.Add(arg);
         }
 
         argIndex++;
     }
 
-    if (inputPath.IsEmpty()) {
+    if (inputPaths.IsEmpty() && query.IsEmpty()) {
         PrintUsage("Missing input file." );
         exit(1);
     }
 
     BMessage refsMsg(B_REFS_RECEIVED);
-    BEntry inputEntry(inputPath);
-    entry_ref ref;
 
-    inputEntry.GetRef(&ref);
-    refsMsg.AddRef("refs", &ref);
+    for (int32 i = 0; i < inputPaths.CountStrings(); i++) {
+        BEntry inputEntry(inputPaths.StringAt(i));
+        entry_ref ref;
+
+        if (inputEntry.GetRef(&ref) == B_OK) {
+            refsMsg.AddRef("refs", &ref);
+        }
+    }
+    if (!query.IsEmpty()) {
+        refsMsg.AddString("query", query);
+    }
+    if (jobs > 0) {
+        refsMsg.AddBool("batch", true);
+        refsMsg.AddInt32("jobs", jobs);
+    }
+    if (imageMemory > 0) {
+        refsMsg.AddInt32("imageMemory", imageMemory);
+    }
+    if (!indexPath.IsEmpty()) {
+        refsMsg.AddString("index", indexPath);
+    }
+    if (budget >= 0) {
+        refsMsg.AddInt32("budget", budget);
+    }
+    if (hedge) {
+        refsMsg.AddBool("hedge", true);
+    }
 
     if (outputPath != NULL) {
         BEntry outputEntry(outputPath);
@@ -122,9 +269,28 @@ void App::ArgvReceived(int32 argc, char ** argv) {
 
 void App::RefsReceived(BMessage *message)
 {
-    entry_ref ref;
+    if (message->GetBool("debug", false)) {
+        Logger::SetLevel(SLOG_LEVEL_DEBUG);
+    }
+    fOverwrite = message->GetBool("wipe", true);
 
-    if (message->FindRef("refs", &ref) != B_OK) {
+    OpenIndex(message->GetString("index", NULL));
+
+    // 0 means no limit
+    fFileBudget = (bigtime_t)message->GetInt32("budget", DEFAULT_FILE_BUDGET) * 1000000;
+    RequestPolicy::Default()->SetHedging(message->GetBool("hedge", false));
+
+    int32 imageMemory = message->GetInt32("imageMemory", 0);
+    if (imageMemory > 0) {
+        delete_sem(fImageMemory);
+        fImageMemoryLimit = imageMemory * 1024;
+        fImageMemory = create_sem(fImageMemoryLimit, "bert image memory");
+    }
+
+    std::vector<entry_ref> refs;
+    CollectRefs(message, &refs);
+
+    if (refs.empty()) {
         BAlert* alert = new BAlert("Error launching SEN Book Enricher",
             "Failed to resolve input file.",
             "Oh no.");
@@ -133,359 +299,538 @@ void App::RefsReceived(BMessage *message)
         return;
     }
 
-    fDebugMode = message->GetBool("debug", false);
-    fOverwrite = message->GetBool("wipe", true);
+    BMessage reply(SENSEI_MESSAGE_RESULT);
+    status_t result;
 
-    fBaseEnricher = new BaseEnricher(&ref, fMapper);
-
-    // set up global mapping table (all Strings because it's only about names, not values!)
-    fMapper->AddAlias("Book:ISBN", "isbn");
-    fMapper->AddAlias("Book:Authors", "author_name");
-    fMapper->AddAlias("Book:Languages", "language");
-    fMapper->AddAlias("Book:Publisher", "publisher");
-    fMapper->AddAlias("Book:Format", "format");
-    fMapper->AddAlias("Book:Subjects", "subject");
-    fMapper->AddAlias("Book:Class", "lcc");
-    fMapper->AddAlias("Book:Pages", "number_of_pages_median");
-    fMapper->AddAlias("Media:Title", "title");
-    fMapper->AddAlias(SENSEI_NAME, "title");    // add file name as fallback if Media:Title is empty
-    fMapper->AddAlias("Book:Year", "publish_year");
-
-    // keep these for later to save another lookup query for relations
-    fMapper->AddAlias(OPENLIBRARY_API_AUTHOR_KEY, "author_key");
-    fMapper->AddAlias(OPENLIBRARY_API_COVER_KEY, "cover_i");
+    bool batch = refs.size() > 1 || message->HasString("query") || message->GetBool("batch", false);
+    if (batch) {
+        if (message->HasRef("outRefs")) {
+            SLOG_WARN("output file is ignored in batch mode, results are written back to the input files.\n");
+        }
+        result = RunBatch(refs, message->GetInt32("jobs", DEFAULT_BATCH_JOBS), &reply);
+    } else {
+        entry_ref outRef;
+        bool hasOutRef = message->FindRef("outRefs", &outRef) == B_OK;
+        BString errorMsg;
 
-    BMessage reply(SENSEI_MESSAGE_RESULT);
-    status_t result = FetchBookMetadata(&ref, &reply);
+        result = EnrichBook(&refs[0], hasOutRef ? &outRef : NULL, &reply, &errorMsg);
+        if (!errorMsg.IsEmpty()) {
+            BAlert* alert = new BAlert("Error in SEN Book Enricher",
+                errorMsg.String(),
+                "Oh no.");
+            alert->SetFlags(alert->Flags() | B_WARNING_ALERT | B_CLOSE_ON_ESCAPE);
+            alert->Go();
+            exit(1);
+        }
+    }
 
-    if (result != B_OK) {
-        BAlert* alert = new BAlert("Error launching SEN Book Enricher",
-            "Failed to look up metadata.",
-            "Oh no.");
-        alert->SetFlags(alert->Flags() | B_WARNING_ALERT | B_CLOSE_ON_ESCAPE);
-        alert->Go();
-        exit(1);
+    reply.AddInt32("resultCode", result);
+
+    http_cache_stats cacheStats;
+    HttpCache::Default()->GetStats(&cacheStats);
+    reply.AddInt64("httpCacheHits", cacheStats.hits);
+    reply.AddInt64("httpCacheMisses", cacheStats.misses);
+    reply.AddInt64("httpCacheRevalidated", cacheStats.revalidated);
+    SLOG_INFO("HTTP cache: %" B_PRId64 " hits, %" B_PRId64 " misses, %" B_PRId64 " revalidated.\n",
+        cacheStats.hits, cacheStats.misses, cacheStats.revalidated);
+
+    int64 requests, coalesced;
+    BaseEnricher::GetCoalescingStats(&requests, &coalesced);
+    reply.AddInt64("httpRequests", requests);
+    reply.AddInt64("httpRequestsCoalesced", coalesced);
+    SLOG_INFO("HTTP requests: %" B_PRId64 ", %" B_PRId64 " saved by sharing concurrent requests.\n",
+        requests, coalesced);
+
+    Metrics::Default()->AddToMessage(&reply);
+    if (Metrics::Default()->Export() != B_OK) {
+        SLOG_ERROR("could not write metrics to %s\n", getenv("SENSEI_METRICS_FILE"));
     }
-    if (fDebugMode) {
-        printf("BERT: metadata reply:\n");
-        reply.PrintToStream();
+
+    SLOG_DEBUG("reply message:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, &reply);
+
+    // we don't expect a reply but run into a race condition with the app
+    // being deleted too early, resulting in a malloc assertion failure.
+    message->SendReply(&reply, this);
+
+    Quit();
+}
+
+/**
+* looks up the book for @ref and writes the result to @outRef, or back to @ref if NULL,
+* together with its cover and authors. Safe to be called for several books concurrently.
+* If the book itself could not be enriched, @errorMsg describes the step that failed,
+* errors for authors are only returned. Covers and photos that cannot be fetched or written
+* are skipped and never fail the book.
+*/
+status_t App::EnrichBook(const entry_ref* ref, const entry_ref* outRef, BMessage* reply, BString* errorMsg)
+{
+    METRICS_STAGE("book.enrich");
+
+    // the enricher resolves the MIME type of its source file, so every book needs its own
+    entry_ref sourceRef(*ref);
+    BaseEnricher enricher(&sourceRef, fMapper);
+
+    // the budget covers all requests for this book, from the search to the last author photo
+    if (fFileBudget > 0) {
+        enricher.SetDeadline(system_time() + fFileBudget);
     }
 
-    // write back enriched result
-    entry_ref resultRef, outRef;
-    result = message->FindRef("outRefs", &outRef);
+    // everything in the reply is written to the book, the rest is only reported when done
+    BMessage lookupInfo;
+    status_t result = FetchBookMetadata(&enricher, ref, reply, &lookupInfo);
     if (result != B_OK) {
-        resultRef = ref;
-    } else {
+        *errorMsg = "Failed to look up metadata.";
+        return result;
+    }
+    SLOG_DEBUG("BERT: metadata reply:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, reply);
+
+    // write back enriched result
+    entry_ref resultRef = *ref;
+
+    if (outRef != NULL) {
         // create empty output file for result metadata in attributes
-        BFile outputFile(&outRef, B_CREATE_FILE | B_READ_WRITE);
+        BFile outputFile(outRef, B_CREATE_FILE | B_READ_WRITE);
         outputFile.Sync();  // ensure file is created so we can access up-to-date attributes below
 
-        // ensure all input attributes are writte to new file
-        fOverwrite = true;
-
-        BNode node(&outRef);
+        BNode node(outRef);
         BNodeInfo nodeInfo(&node);
 
         // always ensure to set correct file type
         result = nodeInfo.SetType(BOOK_MIME_TYPE);
         if (result != B_OK) {
-            BAlert* alert = new BAlert("Error in SEN Book Enricher",
-                "Failed to create book.",
-                "Oh no.");
-            alert->SetFlags(alert->Flags() | B_WARNING_ALERT | B_CLOSE_ON_ESCAPE);
-            alert->Go();
-            exit(1);
+            *errorMsg = "Failed to create book.";
+            return result;
         }
-        resultRef = outRef;
+        resultRef = *outRef;
     }
 
-    result = fMapper->MapMsgToAttrs(&reply, &resultRef, fOverwrite);
-    if (result != B_OK) {
-        BAlert* alert = new BAlert("Error in SEN Book Enricher",
-            "Failed to write back metadata.",
-            "Oh no.");
-        alert->SetFlags(alert->Flags() | B_WARNING_ALERT | B_CLOSE_ON_ESCAPE);
-        alert->Go();
-        exit(1);
+    // everything below only depends on the search result: write the book attributes while
+    // fetching the cover and all authors concurrently, thumbnails are written as soon as
+    // both the image and the file they belong to are ready.
+    TaskGraph tasks("book enrichment");
+
+    attr_write_stats writeStats = { 0, 0, 0 };
+    int32 writeBook = tasks.AddTask("write book", [&]() -> status_t {
+        // existing values are already merged into the reply, see FetchBookMetadata(), so attributes
+        // are only rewritten if values were added, and left alone when enriched again
+        return fMapper->MapMsgToAttrs(reply, &resultRef, true, &writeStats);
+    });
+
+    BString coverId = reply->GetString(OPENLIBRARY_API_COVER_KEY, "");
+    HttpBody coverImage;
+    int32 coverReserved = 0;
+
+    if (!coverId.IsEmpty()) {
+        // a missing cover is skipped like before, it does not fail the book
+        int32 fetchCover = tasks.AddTask("fetch cover", [&]() -> status_t {
+            status_t status = FetchCover(&enricher, coverId.String(), &coverImage);
+            if (status != B_OK) {
+                SLOG_WARN("could not fetch cover %s, skipping: %s\n", coverId.String(), strerror(status));
+                return B_OK;
+            }
+            ReserveImageMemory(coverImage, &coverReserved);
+            return B_OK;
+        });
+        tasks.AddTask("write cover", [&]() -> status_t {
+            if (coverImage.IsEmpty()) {
+                return B_OK;
+            }
+            status_t status = Thumbnail::Write(&resultRef, coverImage);
+            if (status != B_OK) {
+                SLOG_WARN("could not write cover of %s, skipping: %s\n", resultRef.name, strerror(status));
+            }
+            coverImage.Unset();
+            ReleaseImageMemory(&coverReserved);
+            return B_OK;
+        }, { writeBook, fetchCover });
+    } else {
+        SLOG_WARN("could not get cover image ID from result, skipping.\n");
     }
 
-    // fetch cover image
-    const char* coverId = reply.GetString(OPENLIBRARY_API_COVER_KEY);
-    if (coverId != NULL) {
-        std::string coverImage;
-
-        result = FetchCover(coverId, &coverImage);
-        if (result == B_OK && coverImage.length() > 0) {
-            printf("successfully retrieved cover image, writing to thumbnail...\n");
-
-            // write image to thumbnail attribute
-            BNode outputNode(&resultRef);
-            if ((result = outputNode.InitCheck()) == B_OK) {
-                ssize_t size = outputNode.WriteAttr(THUMBNAIL_ATTR_NAME, B_RAW_TYPE, 0, coverImage.c_str(), coverImage.length());
-
-                if (size < coverImage.length()) {
-                    printf("error writing thumbnail to file %s: %s\n", resultRef.name, strerror(-size));
-                } else {
-                    // set thumbnail creation time so it doesn't get removed, use modification time from node
-                    time_t modtime;
-                    result = outputNode.GetModificationTime(&modtime);
-                    modtime++;  // thumbnail creation time needs to be after file change time to be kept.
-
-                    if (result == B_OK) {
-                        printf("writing thumbnail modification time...\n");
-                        size = outputNode.WriteAttr(THUMBNAIL_CREATION_TIME, B_TIME_TYPE, 0, &modtime, sizeof(time_t));
-                        if (size < 0 ) {
-                            result = -size;
-                        }
-                    }
-                    if (result != B_OK) {
-                        printf("error writing thumbnail to %s: %s\n", resultRef.name, strerror(result));
-                    }
-                }
-                if (result == B_OK) {
-                    printf("Cover image written to thumbnail successfully.\n");
-                    outputNode.Sync();
-                }
-            } else {
-                printf("error opening output file %s: %s\n", resultRef.name, strerror(result));
+    BStringList authorIds;
+    BString(reply->GetString(OPENLIBRARY_API_AUTHOR_KEY, "")).Split(";", true, authorIds);
+
+    // sized once, tasks keep references to their element
+    std::vector<author_result> authors(authorIds.CountStrings());
+
+    for (int32 i = 0; i < authorIds.CountStrings(); i++) {
+        author_result& author = authors[i];
+        author.id = authorIds.StringAt(i);
+        author.photoReserved = 0;
+
+        int32 fetchAuthor = tasks.AddTask("fetch author", [this, &enricher, &author]() -> status_t {
+            return FetchAuthor(&enricher, author.id.String(), &author.attrs);
+        });
+        int32 writeAuthor = tasks.AddTask("write author", [this, &author]() -> status_t {
+            return WriteAuthor(&author.attrs, &author.ref);
+        }, { fetchAuthor });
+        int32 fetchPhoto = tasks.AddTask("fetch photo", [this, &enricher, &author]() -> status_t {
+            const char* photoId = author.attrs.GetString(OPENLIBRARY_API_COVER_KEY);
+            if (photoId == NULL) {
+                SLOG_WARN("could not get photo ID for author %s, skipping.\n", author.id.String());
+                return B_OK;
             }
-        } else {
-            printf("error fetching cover image, skipping.\n");
-        }
-    } else {
-        printf("could not get cover image ID from result, skipping.\n");
+            status_t status = FetchPhoto(&enricher, photoId, &author.photo);
+            if (status != B_OK) {
+                SLOG_WARN("could not fetch photo %s of author %s, skipping: %s\n", photoId,
+                    author.id.String(), strerror(status));
+                return B_OK;
+            }
+            ReserveImageMemory(author.photo, &author.photoReserved);
+            return B_OK;
+        }, { fetchAuthor });
+        tasks.AddTask("write photo", [this, &author]() -> status_t {
+            if (author.photo.IsEmpty()) {
+                return B_OK;
+            }
+            status_t status;
+            {
+                // the photo goes to the same file, see WriteAuthor()
+                BAutolock locker(fAuthorLock);
+                status = Thumbnail::Write(&author.ref, author.photo);
+            }
+            if (status != B_OK) {
+                SLOG_WARN("could not write photo of author %s, skipping: %s\n", author.id.String(),
+                    strerror(status));
+            }
+            author.photo.Unset();
+            ReleaseImageMemory(&author.photoReserved);
+            return B_OK;
+        }, { writeAuthor, fetchPhoto });
     }
 
-    if (result == B_OK) {
-        printf("All Book data retrieved successfully, done.\n");
+    tasks.Run();
+    result = tasks.Wait();
+
+    // images of cancelled writes are still reserved
+    ReleaseImageMemory(&coverReserved);
+    for (size_t i = 0; i < authors.size(); i++) {
+        ReleaseImageMemory(&authors[i].photoReserved);
     }
 
-    // fetch author - todo: demo, outfactor later
-    const char* authorId = reply.GetString(OPENLIBRARY_API_AUTHOR_KEY);
-    BMessage authorResult;
+    // report per file write statistics, unchanged attributes are not written again
+    reply->AddInt32("attrsWritten", writeStats.written);
+    reply->AddInt32("attrsSkipped", writeStats.skipped);
+    reply->AddInt32("attrsFailed", writeStats.failed);
+    reply->Append(lookupInfo);
 
-    result = FetchAuthor(authorId, &authorResult);
+    if (tasks.StatusOf(writeBook) != B_OK) {
+        *errorMsg = "Failed to write back metadata.";
+        return tasks.StatusOf(writeBook);
+    }
 
     if (result == B_OK) {
-        // create output file for result metadata in attributes
-        BString name = authorResult.GetString("META:name", "Unknown Author");
-        printf("creating Author with name '%s'...\n", name.String());
+        SLOG_INFO("All Book data retrieved successfully, done.\n");
+    }
+    return result;
+}
+
+/**
+* enriches all @refs on a pool of @jobs workers and reports throughput and latency of the run.
+*/
+status_t App::RunBatch(const std::vector<entry_ref>& refs, int32 jobs, BMessage* reply)
+{
+    // written by index from the workers, so no locking needed
+    std::vector<bigtime_t> latencies(refs.size(), 0);
+
+    WorkerPool pool("bert worker", jobs);
+    SLOG_INFO("enriching %zu books with %" B_PRId32 " workers...\n", refs.size(), pool.CountWorkers());
+
+    bigtime_t start = system_time();
 
-        BFile outputFile(name.String(), B_CREATE_FILE | B_READ_WRITE);
-        BEntry entry(name);
+    int32 failed = pool.Run(refs.size(), [&](int32 index) -> status_t {
+        const entry_ref* ref = &refs[index];
+        bigtime_t jobStart = system_time();
 
-        entry_ref authorRef;
-        entry.GetRef(&authorRef);
+        BMessage bookReply(SENSEI_MESSAGE_RESULT);
+        BString errorMsg;
+        status_t result = EnrichBook(ref, NULL, &bookReply, &errorMsg);
 
-        result = entry.InitCheck();
+        latencies[index] = system_time() - jobStart;
         if (result != B_OK) {
-            printf("could not create author file %s: %s\n", name.String(), strerror(result));
-            exit(1);
+            SLOG_ERROR("failed to enrich %s: %s%s%s\n", ref->name, errorMsg.String(),
+                errorMsg.IsEmpty() ? "" : " ", strerror(result));
         }
+        return result;
+    });
 
-        BaseEnricher authorEnricher(&authorRef, fMapper);
-        outputFile.Sync();  // ensure file is created so we can access up-to-date attributes below
+    bigtime_t elapsed = system_time() - start;
+    std::sort(latencies.begin(), latencies.end());
 
-        // ensure all input attributes are writte to new file
-        fOverwrite = true;
-        BNode node(&authorRef);
-        BNodeInfo nodeInfo(&node);
-        result = nodeInfo.InitCheck();
+    bigtime_t p50 = Percentile(latencies, 50);
+    bigtime_t p95 = Percentile(latencies, 95);
+    bigtime_t p99 = Percentile(latencies, 99);
+    double throughput = elapsed > 0 ? refs.size() * 1000000.0 / elapsed : 0;
 
-        // always ensure to set correct file type
-        if (result == B_OK) result = nodeInfo.SetType(AUTHOR_MIME_TYPE);
+    SLOG_INFO("batch done: %zu books, %" B_PRId32 " failed in %.1f s (%.2f books/s).\n",
+        refs.size(), failed, elapsed / 1000000.0, throughput);
+    SLOG_INFO("latency per book: p50 %.0f ms, p95 %.0f ms, p99 %.0f ms.\n",
+        p50 / 1000.0, p95 / 1000.0, p99 / 1000.0);
+
+    reply->AddInt32("booksProcessed", refs.size());
+    reply->AddInt32("booksFailed", failed);
+    reply->AddInt64("elapsed", elapsed);
+    reply->AddInt64("latencyP50", p50);
+    reply->AddInt64("latencyP95", p95);
+    reply->AddInt64("latencyP99", p99);
+
+    return failed == 0 ? B_OK : B_ERROR;
+}
+
+/**
+* gathers the books to enrich from the "refs" of @message, descending into directories,
+* and from the results of a "query" on all persistent volumes.
+*/
+void App::CollectRefs(const BMessage* message, std::vector<entry_ref>* refs)
+{
+    entry_ref ref;
+    for (int32 i = 0; message->FindRef("refs", i, &ref) == B_OK; i++) {
+        BEntry entry(&ref);
+        if (entry.IsDirectory()) {
+            AddDirectory(&ref, refs);
+        } else {
+            refs->push_back(ref);
+        }
+    }
+
+    const char* predicate = message->GetString("query", NULL);
+    if (predicate == NULL) {
+        return;
+    }
+
+    BVolumeRoster volumeRoster;
+    BVolume volume;
+    while (volumeRoster.GetNextVolume(&volume) == B_OK) {
+        if (!volume.KnowsQuery() || !volume.IsPersistent()) {
+            continue;
+        }
+        BQuery query;
+        query.SetVolume(&volume);
+        status_t result = query.SetPredicate(predicate);
+        if (result == B_OK) {
+            result = query.Fetch();
+        }
         if (result != B_OK) {
-            BAlert* alert = new BAlert("Error in SEN Book Enricher",
-                "Failed to write back metadata for author.",
-                "Oh no.");
-            alert->SetFlags(alert->Flags() | B_WARNING_ALERT | B_CLOSE_ON_ESCAPE);
-            alert->Go();
-            exit(1);
+            SLOG_ERROR("invalid query '%s': %s\n", predicate, strerror(result));
+            return;
+        }
+        while (query.GetNextRef(&ref) == B_OK) {
+            refs->push_back(ref);
         }
-        // write info to attrs
-        result = fMapper->MapMsgToAttrs(&authorResult, &authorRef, true);  // TODO: fOverwrite
-
-        // fetch author photo
-        const char* photoId = authorResult.GetString(OPENLIBRARY_API_COVER_KEY);
-        if (photoId != NULL) {
-            std::string photo;
-
-            result = FetchPhoto(photoId, &photo);
-            if (result == B_OK && photo.length() > 0) {
-                printf("successfully retrieved cover image, writing to thumbnail...\n");
-
-                // write image to thumbnail attribute
-                BNode outputNode(&authorRef);
-                if ((result = outputNode.InitCheck()) == B_OK) {
-                    ssize_t size = outputNode.WriteAttr(THUMBNAIL_ATTR_NAME, B_RAW_TYPE, 0, photo.c_str(), photo.length());
-
-                    if (size < photo.length()) {
-                        printf("error writing thumbnail to file %s: %s\n", authorRef.name, strerror(-size));
-                    } else {
-                        // set thumbnail creation time so it doesn't get removed, use modification time from node
-                        time_t modtime;
-                        result = outputNode.GetModificationTime(&modtime);
-                        modtime++;  // thumbnail creation time needs to be after file change time to be kept.
-
-                        if (result == B_OK) {
-                            printf("writing thumbnail modification time...\n");
-                            size = outputNode.WriteAttr(THUMBNAIL_CREATION_TIME, B_TIME_TYPE, 0, &modtime, sizeof(time_t));
-                            if (size < 0 ) {
-                                result = -size;
-                            }
-                        }
-                        if (result != B_OK) {
-                            printf("error writing thumbnail to %s: %s\n", authorRef.name, strerror(result));
-                        }
-                    }
-                    if (result == B_OK) {
-                        printf("Cover image written to thumbnail successfully.\n");
-                        outputNode.Sync();
-                    }
-                } else {
-                    printf("error opening output file %s: %s\n", authorRef.name, strerror(result));
-                }
-            } else {
-                printf("error fetching cover image, skipping.\n");
+    }
+}
+
+void App::AddDirectory(const entry_ref* dirRef, std::vector<entry_ref>* refs)
+{
+    BDirectory dir(dirRef);
+    entry_ref ref;
+    char type[B_MIME_TYPE_LENGTH];
+
+    while (dir.GetNextRef(&ref) == B_OK) {
+        // does not traverse links, so we cannot end up in a cycle
+        BEntry entry(&ref);
+        if (entry.IsDirectory()) {
+            AddDirectory(&ref, refs);
+        } else if (entry.IsFile()) {
+            // only books, a folder usually also holds covers, authors and other files
+            BNode node(&ref);
+            BNodeInfo nodeInfo(&node);
+            if (nodeInfo.GetType(type) != B_OK || strcmp(type, BOOK_MIME_TYPE) != 0) {
+                SLOG_DEBUG("skipping %s, not a book.\n", ref.name);
+                continue;
             }
-        } else {
-            printf("could not get cover image ID from result, skipping.\n");
+            refs->push_back(ref);
         }
     }
+}
 
-    reply.AddInt32("resultCode", result);
+/**
+* blocks until @image fits into the budget for images held in memory until they are written,
+* @reserved receives the amount to give back with ReleaseImageMemory().
+*/
+void App::ReserveImageMemory(const HttpBody& image, int32* reserved)
+{
+    *reserved = 0;
+    if (fImageMemory < 0) {
+        return;
+    }
 
-    printf("reply message:\n");
-    reply.PrintToStream();
+    // an image larger than the whole budget still gets through, but only on its own
+    int32 size = std::min<size_t>((image.Size() + 1023) / 1024, fImageMemoryLimit);
+    if (size <= 0) {
+        return;
+    }
 
-    // we don't expect a reply but run into a race condition with the app
-    // being deleted too early, resulting in a malloc assertion failure.
-    message->SendReply(&reply, this);
+    status_t result;
+    while ((result = acquire_sem_etc(fImageMemory, size, 0, 0)) == B_INTERRUPTED)
+        ;
+    if (result == B_OK) {
+        *reserved = size;
+    }
+}
 
-    Quit();
+void App::ReleaseImageMemory(int32* reserved)
+{
+    if (*reserved > 0) {
+        release_sem_etc(fImageMemory, *reserved, 0);
+        *reserved = 0;
+    }
 }
 
-status_t App::FetchBookMetadata(const entry_ref* ref, BMessage *resultMsg)
+/**
+* creates the author file named after the author and writes the author attributes to it.
+*/
+status_t App::WriteAuthor(BMessage* authorAttrs, entry_ref* authorRef)
 {
-    status_t result;
+    BString name = authorAttrs->GetString("META:name", "Unknown Author");
+    SLOG_INFO("creating Author with name '%s'...\n", name.String());
 
-    // gather attributes from ref to map and use as search params
-    BMessage inputAttrsMsg;
-    result = fMapper->MapAttrsToMsg(ref, &inputAttrsMsg);
-    if (fDebugMode) {
-        printf("input msg from attrs:\n");
-        inputAttrsMsg.PrintToStream();
-    }
+    // batch workers may write the same author for different books, serialize creating the file
+    // and writing its attributes so the last writer finds a complete file
+    BAutolock locker(fAuthorLock);
 
-    BMessage paramsMsg;
-    result = fBaseEnricher->MapAttrsToServiceParams(&inputAttrsMsg, &paramsMsg);
+    BFile outputFile(name.String(), B_CREATE_FILE | B_READ_WRITE);
+    BEntry entry(name);
+
+    status_t result = entry.InitCheck();
+    if (result == B_OK) {
+        result = entry.GetRef(authorRef);
+    }
     if (result != B_OK) {
-        printf("error mapping attributes to lookup parameters, aborting.\n");
+        SLOG_ERROR("could not create author file %s: %s\n", name.String(), strerror(result));
         return result;
     }
 
-    // if the title was taken from the file name, we need to send it as a defined API query parameter "q"
-    // because it may contain anything from author name to book title to year
-    if (paramsMsg.HasString("title")) {
-        BString title;
-        if ((title = paramsMsg.GetString("title")) == inputAttrsMsg.GetString(SENSEI_NAME)) {
-            printf("sending file name '%s' as query param 'q'.\n", title.String());
-            paramsMsg.RemoveData("title");
-            paramsMsg.AddString("q", title);
-        }
-    }
+    outputFile.Sync();  // ensure file is created so we can access up-to-date attributes below
 
-    // add advanced fields to result, esp. ISBN, number of pages and lcc classification
-    paramsMsg.AddString("fields", "*");
+    BNode node(authorRef);
+    BNodeInfo nodeInfo(&node);
+    result = nodeInfo.InitCheck();
 
-    if (fDebugMode) {
-        printf("service params msg:\n");
-        paramsMsg.PrintToStream();
+    // always ensure to set correct file type
+    if (result == B_OK) result = nodeInfo.SetType(AUTHOR_MIME_TYPE);
+    if (result != B_OK) {
+        SLOG_ERROR("failed to write back metadata for author %s: %s\n", name.String(), strerror(result));
+        return result;
     }
 
-    BUrl queryUrl(API_BASE_URL "search.json", true);
-    BMessage queryResult;
+    // ensure all input attributes are written to the new file
+    return fAuthorMapper->MapMsgToAttrs(authorAttrs, authorRef, true);  // TODO: fOverwrite
+}
+
+status_t App::FetchBookMetadata(BaseEnricher* enricher, const entry_ref* ref, BMessage *resultMsg,
+    BMessage* lookupInfo)
+{
+    status_t result;
+
+    // gather mapped attributes from ref to use as search params, values are only read on demand
+    AttributeView inputAttrs(ref);
+    SLOG_DEBUG("input attrs:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, &inputAttrs);
 
-    result = fBaseEnricher->FetchByHttpQuery(queryUrl, &paramsMsg, &queryResult);
+    BMessage paramsMsg;
+    result = enricher->MapAttrsToServiceParams(&inputAttrs, &paramsMsg);
     if (result != B_OK) {
-        printf("error in remote service call: %s\n", strerror(result));
+        SLOG_ERROR("error mapping attributes to lookup parameters, aborting.\n");
         return result;
     }
 
-    // get docs
-    BMessage books;
-    double numFound = -1;
+    // only send one valid ISBN in canonical form, multi-valued attributes and typos are common
+    if (paramsMsg.HasString("isbn")) {
+        Isbn best;
+        BStringList invalid;
+        result = Isbn::SelectBest(&paramsMsg, "isbn", &best, &invalid);
 
-    result = queryResult.FindDouble("num_found", &numFound);
-    if (result == B_OK) {
-        result = queryResult.FindMessage("docs", &books);
-    }
-    if (fDebugMode) {
+        for (int32 i = 0; i < invalid.CountStrings(); i++) {
+            SLOG_WARN("ignoring invalid ISBN '%s' of %s.\n", invalid.StringAt(i).String(), ref->name);
+            lookupInfo->AddString("invalidIsbn", invalid.StringAt(i));
+        }
+        paramsMsg.RemoveName("isbn");
         if (result == B_OK) {
-            printf("received %f results:\n", numFound);
-            books.PrintToStream();
-        } else {
-            printf("unexpected result format, could not find books in 'docs' list: %s\n", strerror(result));
-            // print result msg as is for debugging purposes
-            queryResult.PrintToStream();
-            return result;
+            paramsMsg.AddString("isbn", best.ToString());
+        } else if (paramsMsg.IsEmpty()) {
+            SLOG_ERROR("no valid ISBN and nothing else to look up %s by.\n", ref->name);
+            return B_BAD_VALUE;
         }
     }
 
-    if (numFound > 1) {
-        // user needs to select a result
-        // todo: implement columnlistview with attributes/params as columns and results in rows
-        //       let the user select one *or more* results, so we can gather an entire result set.
-        printf("got %f books, please select... TBI\n", numFound);
-    }
-
-    // map back result fields to attributes from input ref and write back to return *message
+    // the offline index only knows editions by ISBN, everything else needs a search
     BMessage bookFound;
-    books.FindMessage("0", &bookFound);  // already error-checked above
-    if (fDebugMode) {
-        printf("book result:\n");
-        bookFound.PrintToStream();
-    }
+    const char* isbn = paramsMsg.GetString("isbn", NULL);
 
-    BMessage resultBook;
+    if (fIndex != NULL && isbn != NULL && fIndex->FindEdition(isbn, &bookFound) == B_OK) {
+        SLOG_DEBUG("found ISBN %s in offline index.\n", isbn);
+    } else {
+        std::vector<query_step> plan;
+        PlanBookQueries(&paramsMsg, ref, &plan);
+
+        // search results are ranked against what we already know about the book
+        CandidateRanker ranker;
+        ranker.SetFromParams(&paramsMsg);
+
+        int32 strategy = -1;
+        BMessage queryResult;
+        result = fBookQueries.Execute(plan,
+            [this, enricher, &ranker](const query_step* step, const int32* canceled, BMessage* stepResult,
+                query_confidence* confidence) {
+                return RunBookQuery(enricher, &ranker, step, canceled, stepResult, confidence);
+            }, &queryResult, &strategy);
+        if (result == B_OK) {
+            result = queryResult.FindMessage("book", &bookFound);
+        }
+        if (result != B_OK) {
+            SLOG_ERROR("no book found for %s: %s\n", ref->name, strerror(result));
+            return result;
+        }
 
-    // convert map values to arrays, they are always indexed by number!
-    // TODO: automate this when keys are numbers and values are strings
-    BStringList valueMapKeys;
-    valueMapKeys.Add("author_name");
-    valueMapKeys.Add("author_key");
-    valueMapKeys.Add("publisher");
-    valueMapKeys.Add("publish_year");
-    valueMapKeys.Add("language");
-    valueMapKeys.Add("format");
-    valueMapKeys.Add("isbn");
-    valueMapKeys.Add("lcc");
-    valueMapKeys.Add("subject");
+        float score = queryResult.GetFloat("score", 0);
+        SLOG_DEBUG("found %s by %s search, candidate %d of %d with score %.2f.\n", ref->name,
+            fBookQueries.StrategyName(strategy), queryResult.GetInt32("index", 0),
+            queryResult.GetInt32("count", 0), score);
+        lookupInfo->AddInt32("candidateIndex", queryResult.GetInt32("index", 0));
+        lookupInfo->AddInt32("candidateCount", queryResult.GetInt32("count", 0));
+        lookupInfo->AddFloat("candidateScore", score);
+    }
+    SLOG_DEBUG("book result:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, &bookFound);
 
-    BaseEnricher::ConvertMessageMapsToArray(&bookFound, &resultBook, &valueMapKeys);
+    // arrays in the result are mapped in place, straight to the attribute types
+    BMessage remoteAttrs;
+    result = enricher->MapServiceParamsToAttrs(&bookFound, &remoteAttrs);
+    if (result != B_OK) {
+        SLOG_ERROR("error mapping back result: %s\n", strerror(result));
+        return result;
+    }
 
-	if (!fOverwrite) {
-	   // use input attributes as base for result so they get updated and type converted below
-	   // todo: we need to merge same values here!
-	   resultMsg->Append(inputAttrsMsg);
-	}
+    // keep existing values and only add new ones to multi-valued attributes, so enriching the
+    // same file again changes nothing. Even without, duplicates in the results are dropped.
+    BMessage localAttrs;
+    if (!fOverwrite) {
+        result = fMapper->MapAttrsToMsg(&inputAttrs, &localAttrs, true);
+        if (result != B_OK) {
+            SLOG_ERROR("error reading input attributes: %s\n", strerror(result));
+            return result;
+        }
+    }
 
-    result = fBaseEnricher->MapServiceParamsToAttrs(&resultBook, resultMsg);
+    attr_merge_stats mergeStats;
+    result = fMerger.Merge(&localAttrs, &remoteAttrs, resultMsg, &mergeStats);
     if (result != B_OK) {
-        printf("error mapping back result: %s\n", strerror(result));
+        SLOG_ERROR("error merging attributes: %s\n", strerror(result));
         return result;
     }
-    if (fDebugMode) {
-        printf("Got attribute result message:\n");
-        resultMsg->PrintToStream();
-    }
+    SLOG_DEBUG("merged %d attributes, dropped %d duplicate values.\n", mergeStats.merged,
+        mergeStats.duplicates);
+    SLOG_DEBUG("Got attribute result message:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, resultMsg);
 
     // update empty or default file name if we may overwrite
     // todo: find a better (i.e. translation safe!) way to determine the default file name
     if (fOverwrite) {
     	// update empty file name with title if exists
-    	BString fileName = inputAttrsMsg.GetString(SENSEI_NAME, "");
+    	BString fileName = ref->name;
     	if (fileName.Trim().IsEmpty() || fileName == "New Book") {
     		BString title = resultMsg->GetString("Media:Title", "");
     		if (!title.IsEmpty()) {
@@ -496,40 +841,196 @@ status_t App::FetchBookMetadata(const entry_ref* ref, BMessage *resultMsg)
     return B_OK;
 }
 
-// todo: make this on demand and bind to filetype application/x-person
-status_t App::FetchAuthor(const char* authorId, BMessage *resultMsg)
+/**
+* adds a search step to @plan for every strategy the parameters are good for.
+*/
+void App::PlanBookQueries(const BMessage* paramsMsg, const entry_ref* ref, std::vector<query_step>* plan)
 {
-    // add author attribute mapping
-    fMapper->AddAlias("META:name", "name");
-    fMapper->AddAlias("META:birthdate", "birth_date");
-    fMapper->AddAlias(OPENLIBRARY_API_COVER_KEY, "photos");
+    const char* isbn = paramsMsg->GetString("isbn", NULL);
+    const char* title = paramsMsg->GetString("title", NULL);
+
+    // only the first of several authors, a search for all of them rarely finds anything
+    BString author = paramsMsg->GetString("author_name", "");
+    int32 separator = author.FindFirst(';');
+    if (separator > 0) {
+        author.Truncate(separator);
+    }
+    author.Trim();
+
+    // a title taken from the file name may contain anything from author name to book title to year
+    bool titleFromName = title != NULL && strcmp(title, ref->name) == 0;
+
+    if (isbn != NULL) {
+        query_step step;
+        step.strategy = BOOK_QUERY_ISBN;
+        step.params.AddString("isbn", isbn);
+        plan->push_back(step);
+    }
+
+    if (title != NULL && !titleFromName) {
+        query_step step;
+        step.strategy = BOOK_QUERY_TITLE_AUTHOR;
+        step.params.AddString("title", title);
+        if (!author.IsEmpty()) {
+            step.params.AddString("author", author);
+        }
+        plan->push_back(step);
+    }
 
+    if (title != NULL) {
+        BString text(title);
+        if (!titleFromName && !author.IsEmpty()) {
+            text << " " << author;
+        }
+        query_step step;
+        step.strategy = BOOK_QUERY_FREE_TEXT;
+        step.params.AddString("q", text);
+        plan->push_back(step);
+    }
+
+    if (plan->empty()) {
+        query_step step;
+        step.strategy = BOOK_QUERY_ATTRIBUTES;
+        step.params = *paramsMsg;
+        plan->push_back(step);
+    }
+}
+
+/**
+* runs one search strategy of the QueryPlanner, with its own enricher so it can be canceled
+* on its own, but with the deadline of the book.
+* @result gets the best ranked doc as "book", with its "index", "score" and the "count" of docs.
+*/
+status_t App::RunBookQuery(BaseEnricher* enricher, const CandidateRanker* ranker, const query_step* step,
+    const int32* canceled, BMessage* result, query_confidence* confidence)
+{
+    BaseEnricher queryEnricher(NULL, fMapper);
+    queryEnricher.SetDeadline(enricher->Deadline());
+    queryEnricher.SetCancelFlag(canceled);
+
+    BMessage params(step->params);
+    BMessage books;
+    double numFound = 0;
+
+    *confidence = QUERY_MISS;
+    status_t status = SearchBook(&queryEnricher, &params, &books, &numFound);
+    if (status == B_ENTRY_NOT_FOUND) {
+        return B_OK;
+    }
+    if (status != B_OK) {
+        return status;
+    }
+
+    // without anything to compare, the search engine knows best
+    float score = 0;
+    int32 best = ranker->IsEmpty() ? 0 : ranker->Rank(&books, &score);
+
+    BString index;
+    index << std::max(best, (int32)0);
+
+    BMessage book;
+    status = books.FindMessage(index.String(), &book);
+    if (status != B_OK) {
+        return status;
+    }
+    if (numFound > 1) {
+        SLOG_DEBUG("got %g books, taking #%d with score %.2f.\n", numFound, best, score);
+    }
+
+    switch (step->strategy) {
+        case BOOK_QUERY_ISBN:
+            *confidence = QUERY_CONFIDENT;
+            break;
+        case BOOK_QUERY_TITLE_AUTHOR:
+        case BOOK_QUERY_FREE_TEXT:
+            *confidence = numFound == 1 || score >= CONFIDENT_SEARCH_SCORE ? QUERY_CONFIDENT : QUERY_WEAK;
+            break;
+        default:
+            *confidence = QUERY_WEAK;
+            break;
+    }
+
+    result->AddMessage("book", &book);
+    result->AddInt32("index", best);
+    result->AddInt32("count", (int32)numFound);
+    result->AddFloat("score", score);
+    return B_OK;
+}
+
+/**
+* searches the web service with @paramsMsg, @books receives the docs found in order of relevance.
+*/
+status_t App::SearchBook(BaseEnricher* enricher, BMessage* paramsMsg, BMessage* books,
+    double* numFoundResult)
+{
+    // request only the mapped fields, this includes advanced fields like ISBN, number of pages
+    // and lcc classification that are not returned by default
+    paramsMsg->AddString("fields", fSearchFields);
+    paramsMsg->AddString("limit", BString() << MAX_SEARCH_RESULTS);
+
+    SLOG_DEBUG("service params msg:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, paramsMsg);
+
+    BUrl queryUrl(API_BASE_URL "search.json", true);
+    BMessage queryResult;
+
+    status_t result = enricher->FetchByHttpQuery(queryUrl, paramsMsg, &queryResult, &fSearchProjection);
+    if (result != B_OK) {
+        SLOG_ERROR("error in remote service call: %s\n", strerror(result));
+        return result;
+    }
+
+    // get docs
+    double numFound = -1;
+
+    result = queryResult.FindDouble("num_found", &numFound);
+    if (result == B_OK) {
+        result = queryResult.FindMessage("docs", books);
+    }
+    if (result == B_OK) {
+        SLOG_DEBUG("received %f results:\n", numFound);
+        SLOG_MESSAGE(SLOG_LEVEL_DEBUG, books);
+    } else {
+        SLOG_ERROR("unexpected result format, could not find books in 'docs' list: %s\n", strerror(result));
+        // print result msg as is for debugging purposes
+        SLOG_MESSAGE(SLOG_LEVEL_DEBUG, &queryResult);
+        return result;
+    }
+
+    if (numFoundResult != NULL) {
+        *numFoundResult = numFound;
+    }
+    // results are sorted by relevance, RunBookQuery() ranks them by what we know about the book
+    return numFound < 1 ? B_ENTRY_NOT_FOUND : B_OK;
+}
+
+// todo: make this on demand and bind to filetype application/x-person
+status_t App::FetchAuthor(BaseEnricher* enricher, const char* authorId, BMessage *resultMsg)
+{
     BUrl queryUrl;
     BMessage queryParams;
     queryParams.AddString("id", authorId);
 
-    status_t result = fBaseEnricher->CreateHttpApiUrl(API_AUTHORS_URL, &queryParams, &queryUrl);
+    status_t result = enricher->CreateHttpApiUrl(kAuthorsUrl, &queryParams, &queryUrl);
     if (result != B_OK) {
-        printf("error in constructing service call: %s\n", strerror(result));
+        SLOG_ERROR("error in constructing service call: %s\n", strerror(result));
         return result;
     }
 
     BMessage authorResult;
-    result = fBaseEnricher->FetchRemoteJson(queryUrl, authorResult);
+    if (fIndex != NULL && fIndex->FindAuthor(authorId, &authorResult) == B_OK) {
+        SLOG_DEBUG("found author %s in offline index.\n", authorId);
+    } else {
+        result = enricher->FetchRemoteJson(queryUrl, authorResult, HTTP_CACHE_ENTITY, &fAuthorProjection);
+    }
 
     if (result != B_OK) {
-        printf("error accessing remote API: %s", strerror(result));
+        SLOG_ERROR("error accessing remote API: %s\n", strerror(result));
         return result;
     }
 
-    printf("got author result:\n");
-    authorResult.PrintToStream();
-
-    BMessage author;
-    BStringList valueMapKeys;
-    valueMapKeys.Add("photos");
-
-    BaseEnricher::ConvertMessageMapsToArray(&authorResult, &author, &valueMapKeys);
+    SLOG_DEBUG("got author result:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, &authorResult);
 
 	if (!fOverwrite) {
 	   // use input attributes as base for result so they get updated and type converted below
@@ -537,15 +1038,13 @@ status_t App::FetchAuthor(const char* authorId, BMessage *resultMsg)
 	  // resultMsg->Append(inputAttrsMsg);
 	}
 
-    result = fBaseEnricher->MapServiceParamsToAttrs(&author, resultMsg);
+    result = fAuthorEnricher->MapServiceParamsToAttrs(&authorResult, resultMsg);
     if (result != B_OK) {
-        printf("error mapping back result: %s\n", strerror(result));
+        SLOG_ERROR("error mapping back result: %s\n", strerror(result));
         return result;
     }
-    if (fDebugMode) {
-        printf("Got attribute result message:\n");
-        resultMsg->PrintToStream();
-    }
+    SLOG_DEBUG("Got attribute result message:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, resultMsg);
 
     // update empty or default file name if we may overwrite
     // todo: find a better (i.e. translation safe!) way to determine the default file name
@@ -563,56 +1062,149 @@ status_t App::FetchAuthor(const char* authorId, BMessage *resultMsg)
     return B_OK;
 }
 
-status_t App::FetchCover(const char* coverId, std::string* coverImage)
+status_t App::FetchCover(BaseEnricher* enricher, const char* coverId, HttpBody* coverImage)
 {
     BUrl queryUrl;
     BMessage queryParams;
     queryParams.AddString("coverId", coverId);
     queryParams.AddString("size", "M");
 
-    status_t result = fBaseEnricher->CreateHttpApiUrl(API_COVER_URL, &queryParams, &queryUrl);
+    status_t result = enricher->CreateHttpApiUrl(kCoverUrl, &queryParams, &queryUrl);
     if (result != B_OK) {
-        printf("error in constructing service call: %s\n", strerror(result));
+        SLOG_ERROR("error in constructing service call: %s\n", strerror(result));
         return result;
     }
 
-    result = fBaseEnricher->FetchRemoteContent(queryUrl, coverImage);
+    result = enricher->FetchRemoteContent(queryUrl, coverImage, HTTP_CACHE_IMAGE);
     if (result != B_OK) {
-        printf("error executing remote service call: %s\n", strerror(result));
+        SLOG_ERROR("error executing remote service call: %s\n", strerror(result));
         return result;
     }
 
     return B_OK;
 }
 
-status_t App::FetchPhoto(const char* photoId, std::string* image)
+status_t App::FetchPhoto(BaseEnricher* enricher, const char* photoId, HttpBody* image)
 {
     BUrl queryUrl;
     BMessage queryParams;
     queryParams.AddString("photoId", photoId);
     queryParams.AddString("size", "M");
 
-    status_t result = fBaseEnricher->CreateHttpApiUrl(API_AUTHOR_IMG_URL, &queryParams, &queryUrl);
+    status_t result = enricher->CreateHttpApiUrl(kAuthorImageUrl, &queryParams, &queryUrl);
     if (result != B_OK) {
-        printf("error in constructing service call: %s\n", strerror(result));
+        SLOG_ERROR("error in constructing service call: %s\n", strerror(result));
         return result;
     }
 
-    result = fBaseEnricher->FetchRemoteContent(queryUrl, image);
+    result = enricher->FetchRemoteContent(queryUrl, image, HTTP_CACHE_IMAGE);
     if (result != B_OK) {
-        printf("error executing remote service call: %s\n", strerror(result));
+        SLOG_ERROR("error executing remote service call: %s\n", strerror(result));
         return result;
     }
 
     return B_OK;
 }
 
+/**
+* loads the mapping profile from the plugin binary's attribute @attrName (see Resources.rdef),
+* falling back to the built-in @profile.
+*/
+status_t App::LoadMapping(MappingUtil* mapper, const char* attrName,
+    const alias_def* profile, size_t profileSize)
+{
+    app_info appInfo;
+    status_t result = GetAppInfo(&appInfo);
+
+    if (result == B_OK) {
+        result = mapper->LoadAliases(&appInfo.ref, attrName);
+    }
+    if (result != B_OK) {
+        SLOG_DEBUG("no mapping %s found in plugin, using built-in profile.\n", attrName);
+        result = mapper->AddAliases(profile, profileSize);
+    }
+    if (result != B_OK) {
+        SLOG_ERROR("failed to set up mapping %s: %s\n", attrName, strerror(result));
+    }
+    return result;
+}
+
+/**
+* opens the offline index at @path, or at its default location in the user's data directory.
+* Without an index, all lookups go to the web service.
+*/
+void App::OpenIndex(const char* path)
+{
+    BPath indexPath;
+    if (path != NULL) {
+        indexPath.SetTo(path);
+    } else if (find_directory(B_USER_DATA_DIRECTORY, &indexPath) == B_OK) {
+        indexPath.Append("sensei/" OL_INDEX_FILE_NAME);
+    }
+
+    OpenLibraryIndex* index = new OpenLibraryIndex();
+    status_t result = index->Open(indexPath.Path());
+    if (result != B_OK) {
+        if (path != NULL) {
+            SLOG_ERROR("could not open offline index %s: %s\n", path, strerror(result));
+        }
+        delete index;
+        return;
+    }
+
+    delete fIndex;
+    fIndex = index;
+}
+
+/**
+* derives the JSON projections and requested search fields from the compiled mappings,
+* so fields added to a mapping profile are fetched and decoded without further changes.
+*/
+void App::BuildProjections()
+{
+    fSearchProjection.AddPath("num_found");
+    fSearchProjection.SetMaxItems("docs", MAX_SEARCH_RESULTS);
+
+    for (int32 i = 0; i < fMapper->CountAliases(); i++) {
+        const char* alias = fMapper->AliasAt(i);
+        if (!fSearchFields.IsEmpty()) {
+            fSearchFields << ",";
+        }
+        fSearchFields << alias;
+        fSearchProjection.AddPath(BString("docs/*/") << alias);
+    }
+
+    // the CandidateRanker needs its fields even if they are not mapped
+    for (int32 i = 0; i < CandidateRanker::CountFields(); i++) {
+        const char* field = CandidateRanker::FieldAt(i);
+        if (fMapper->ResolveAlias(field) == NULL) {
+            fSearchFields << "," << field;
+            fSearchProjection.AddPath(BString("docs/*/") << field);
+        }
+    }
+
+    for (int32 i = 0; i < fAuthorMapper->CountAliases(); i++) {
+        fAuthorProjection.AddPath(fAuthorMapper->AliasAt(i));
+    }
+    // the first photo becomes the photo ID, converting all of them would join them with ";"
+    fAuthorProjection.SetMaxItems("photos", 1);
+}
+
 void App::PrintUsage(const char* errorMsg)
 {
     if (errorMsg) {
         std::cerr << "error: " << errorMsg << std::endl;
     }
-    std::cout << "Usage: bert <input file>" << std::endl;
+    std::cout << "Usage: bert [-d] [-w] [-i <index>] [-b <seconds>] [--hedge] [-o <output file>] <input file>" << std::endl;
+    std::cout << "       bert [-d] [-w] [-i <index>] [-b <seconds>] [--hedge] [-j <jobs>] [-m <MiB>] [-q <query>] <input files or directories>..." << std::endl;
     std::cout << "retrieves book metadata from online sources, currently OpenLibrary.org." << std::endl;
+    std::cout << "Books are looked up by ISBN in the offline index built by olindex first, if there is one." << std::endl;
+    std::cout << "With several inputs, directories or a query, books are enriched in batch mode by" << std::endl;
+    std::cout << "<jobs> workers (default " << DEFAULT_BATCH_JOBS << "), keeping at most <MiB> of images"
+              << " in memory (default " << DEFAULT_IMAGE_MEMORY / 1024 << ")." << std::endl;
+    std::cout << "All requests for one book give up after <seconds> (default " << DEFAULT_FILE_BUDGET
+              << ", 0 for no limit), with --hedge slow requests are sent twice." << std::endl;
+    std::cout << "Responses are cached, set SENSEI_HTTP_CACHE_TTL=<query>,<entity>,<image> hours"
+              << " (default 24,168,720) and SENSEI_HTTP_CACHE_SIZE=<MiB> (default 64) to change." << std::endl;
     Quit();
 }
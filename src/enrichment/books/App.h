@@ -5,12 +5,19 @@
 #pragma once
 
 #include <Application.h>
+#include <Locker.h>
+
+#include <vector>
+
 #include "../BaseEnricher.h"
+#include "../QueryPlanner.h"
+#include "CandidateRanker.h"
+#include "OpenLibraryIndex.h"
+#include "../../common/AttrMerger.h"
+#include "../../common/TaskGraph.h"
 
 #define BOOK_MIME_TYPE          "entity/book"
 #define AUTHOR_MIME_TYPE        "application/x-person"
-#define THUMBNAIL_ATTR_NAME     "Media:Thumbnail"
-#define THUMBNAIL_CREATION_TIME THUMBNAIL_ATTR_NAME ":CreationTime"
 
 #define API_BASE_URL            "http://openlibrary.org/"
 #define API_AUTHORS_URL         API_BASE_URL "authors/$id.json"
@@ -20,6 +27,40 @@
 #define OPENLIBRARY_API_AUTHOR_KEY  "OPENLIB:author_keys"
 #define OPENLIBRARY_API_COVER_KEY   "OPENLIB:cover_key"     // also used for author photos
 
+#define AUTHOR_ATTR_MAPPING     SENSEI_ATTR_MAPPING ":author"
+
+// search results to decode, we only ever use the first one for now
+#define MAX_SEARCH_RESULTS      10
+
+// book search strategies of the QueryPlanner in order of preference, see PlanBookQueries()
+enum book_query_strategy {
+    BOOK_QUERY_ISBN = 0,        // exact match by ISBN
+    BOOK_QUERY_TITLE_AUTHOR,    // title and author as separate search fields
+    BOOK_QUERY_FREE_TEXT,       // everything we know as one free text query
+    BOOK_QUERY_ATTRIBUTES       // all mapped attributes, only if nothing else applies
+};
+// search strategies run in parallel per book
+#define BOOK_QUERY_SPECULATION  2
+// search results with at least this CandidateRanker score need no other strategies
+#define CONFIDENT_SEARCH_SCORE  0.85f
+
+// batch mode, requests to one host are still paced by the HostRateLimiter
+#define DEFAULT_BATCH_JOBS      4
+#define MAX_BATCH_JOBS          64
+// budget for fetched images waiting to be written, in KiB
+#define DEFAULT_IMAGE_MEMORY    (64 * 1024)
+// time budget for all requests of one book, in seconds
+#define DEFAULT_FILE_BUDGET     30
+
+// per author state shared by the fetch and write tasks of one author
+struct author_result {
+    BString     id;
+    BMessage    attrs;
+    entry_ref   ref;
+    HttpBody    photo;
+    int32       photoReserved;  // KiB of the image memory budget
+};
+
 class App : public BApplication
 {
 public:
@@ -30,19 +71,66 @@ public:
 
     /**
      * call lookup service with params in message.
+     * @lookupInfo receives how the book was found, which is reported but never written to the file.
      */
-    status_t            FetchBookMetadata(const entry_ref* ref, BMessage *resultMsg);
+    status_t            FetchBookMetadata(BaseEnricher* enricher, const entry_ref* ref,
+                                          BMessage *resultMsg, BMessage* lookupInfo);
 
 private:
+    // batch handling
+    status_t            EnrichBook(const entry_ref* ref, const entry_ref* outRef, BMessage* reply,
+                                   BString* errorMsg);
+    status_t            RunBatch(const std::vector<entry_ref>& refs, int32 jobs, BMessage* reply);
+    void                CollectRefs(const BMessage* message, std::vector<entry_ref>* refs);
+    // adds the books in @dirRef and its subdirectories, files of other types are skipped
+    void                AddDirectory(const entry_ref* dirRef, std::vector<entry_ref>* refs);
+    void                ReserveImageMemory(const HttpBody& image, int32* reserved);
+    void                ReleaseImageMemory(int32* reserved);
+
     // query handling
-    status_t            FetchAuthor(const char* authorId, BMessage *msgResult);
-    status_t            FetchCover(const char* coverId, std::string* coverImage);
-    status_t            FetchPhoto(const char* photoId, std::string* photo);
+    void                OpenIndex(const char* path);
+    void                PlanBookQueries(const BMessage* paramsMsg, const entry_ref* ref,
+                                        std::vector<query_step>* plan);
+    status_t            RunBookQuery(BaseEnricher* enricher, const CandidateRanker* ranker,
+                                     const query_step* step, const int32* canceled,
+                                     BMessage* result, query_confidence* confidence);
+    // @books gets the docs of the search result
+    status_t            SearchBook(BaseEnricher* enricher, BMessage* paramsMsg, BMessage* books,
+                                   double* numFound = NULL);
+    status_t            FetchAuthor(BaseEnricher* enricher, const char* authorId, BMessage *msgResult);
+    status_t            FetchCover(BaseEnricher* enricher, const char* coverId, HttpBody* coverImage);
+    status_t            FetchPhoto(BaseEnricher* enricher, const char* photoId, HttpBody* photo);
+
+    // result handling
+    status_t            WriteAuthor(BMessage* authorAttrs, entry_ref* authorRef);
+
+    status_t            LoadMapping(MappingUtil* mapper, const char* attrName,
+                                   const alias_def* profile, size_t profileSize);
+    void                BuildProjections();
 
     void                PrintUsage(const char* errorMsg = NULL);
-    bool                fDebugMode;
     bool                fOverwrite;
 
-    BaseEnricher*       fBaseEnricher;
+    // maps author attributes, requests use the enricher of their book, see EnrichBook()
+    BaseEnricher*       fAuthorEnricher;
+    // per book deadline for all of its requests, 0 for none
+    bigtime_t           fFileBudget;
+    // offline lookups by ISBN, NULL if there is no index
+    OpenLibraryIndex*   fIndex;
+    // mapping profiles are loaded once and compiled, see LoadMapping()
     MappingUtil*        fMapper;
+    MappingUtil*        fAuthorMapper;
+    // only the mapped fields of service responses are decoded
+    JsonProjection      fSearchProjection;
+    JsonProjection      fAuthorProjection;
+    BString             fSearchFields;
+    // picks the search strategies for each book and keeps their hit rates
+    QueryPlanner        fBookQueries;
+    // merges existing and fetched book attributes, existing values take precedence
+    AttrMerger          fMerger;
+    // counts free KiB of the image memory budget
+    sem_id              fImageMemory;
+    int32               fImageMemoryLimit;
+    // author files are named after the author, books of the same author must not write it at once
+    BLocker             fAuthorLock;
 };
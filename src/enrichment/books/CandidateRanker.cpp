@@ -0,0 +1,316 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <StringList.h>
+#include <string.h>
+#include <strings.h>
+
+#include <math.h>
+
+#include "CandidateRanker.h"
+#include "../../common/FlatMessage.h"
+#include "../../common/TypeConverter.h"
+
+// how much each criterion counts, criteria we know nothing about are left out
+static const float kTitleWeight = 0.5f;
+static const float kAuthorWeight = 0.3f;
+static const float kYearWeight = 0.1f;
+static const float kLanguageWeight = 0.1f;
+// for docs that do not have a year or language at all
+static const float kUnknownScore = 0.5f;
+
+static const char* const kTitleField = "title";
+static const char* const kAuthorField = "author_name";
+static const char* const kYearField = "publish_year";
+static const char* const kLanguageField = "language";
+
+static const char* const kFields[] = { kTitleField, kAuthorField, kYearField, kLanguageField };
+
+/**
+* calls @func with the data of every value of field @name of @type, whether the values are
+* stored in the field itself or as array in a nested message.
+*/
+template<typename Func>
+static void ForEachValue(const BMessage* doc, const char* name, type_code type, Func func)
+{
+    type_code fieldType;
+    int32 count;
+    if (doc->GetInfo(name, &fieldType, &count) != B_OK) {
+        return;
+    }
+
+    const void* data;
+    ssize_t size;
+
+    if (fieldType == type) {
+        for (int32 i = 0; i < count; i++) {
+            if (doc->FindData(name, type, i, &data, &size) == B_OK) {
+                func(data, size);
+            }
+        }
+        return;
+    }
+    if (fieldType != B_MESSAGE_TYPE || doc->FindData(name, B_MESSAGE_TYPE, &data, &size) != B_OK) {
+        return;
+    }
+
+    // arrays are read in place, without unflattening them first
+    FlatMessage array(data, size);
+    if (array.InitCheck() == B_OK) {
+        type_code valueType;
+        for (int32 i = 0; i < array.CountFields(); i++) {
+            if (array.GetFieldAt(i, NULL, &valueType, NULL) == B_OK && valueType == type
+                && array.FindDataAt(i, 0, &data, &size) == B_OK) {
+                func(data, size);
+            }
+        }
+        return;
+    }
+
+    BMessage arrayMsg;
+    if (doc->FindMessage(name, &arrayMsg) != B_OK) {
+        return;
+    }
+    char* valueName;
+    type_code valueType;
+    for (int32 i = 0; arrayMsg.GetInfo(type, i, &valueName, &valueType) == B_OK; i++) {
+        if (arrayMsg.FindData(valueName, type, &data, &size) == B_OK) {
+            func(data, size);
+        }
+    }
+}
+
+CandidateRanker::CandidateRanker()
+    :
+    fHasTitle(false),
+    fYear(0)
+{
+}
+
+void CandidateRanker::SetTitle(const char* title)
+{
+    MakeSignature(title, &fTitle);
+    fHasTitle = fTitle.count > 0;
+}
+
+void CandidateRanker::AddAuthor(const char* author)
+{
+    Signature signature;
+    MakeSignature(author, &signature);
+    if (signature.count > 0) {
+        fAuthors.push_back(signature);
+    }
+}
+
+void CandidateRanker::SetYear(int32 year)
+{
+    fYear = year;
+}
+
+void CandidateRanker::AddLanguage(const char* language)
+{
+    BString value(language);
+    if (!value.Trim().IsEmpty()) {
+        fLanguages.push_back(value.ToLower());
+    }
+}
+
+void CandidateRanker::SetFromParams(const BMessage* params)
+{
+    const char* value;
+    if (params->FindString(kTitleField, &value) == B_OK) {
+        SetTitle(value);
+    }
+
+    // multi-valued attributes arrive as one string separated by ';'
+    for (int32 i = 0; params->FindString(kAuthorField, i, &value) == B_OK; i++) {
+        BStringList authors;
+        BString(value).Split(";", true, authors);
+        for (int32 author = 0; author < authors.CountStrings(); author++) {
+            AddAuthor(authors.StringAt(author).String());
+        }
+    }
+    for (int32 i = 0; params->FindString(kLanguageField, i, &value) == B_OK; i++) {
+        BStringList languages;
+        BString(value).Split(";", true, languages);
+        for (int32 language = 0; language < languages.CountStrings(); language++) {
+            AddLanguage(languages.StringAt(language).String());
+        }
+    }
+
+    BMessage year;
+    if (TypeConverter::Convert(params, kYearField, B_INT32_TYPE, &year, kYearField) == B_OK) {
+        SetYear(year.GetInt32(kYearField, 0));
+    }
+}
+
+bool CandidateRanker::IsEmpty() const
+{
+    return !fHasTitle && fAuthors.empty() && fYear == 0 && fLanguages.empty();
+}
+
+float CandidateRanker::Score(const BMessage* doc) const
+{
+    float score = 0;
+    float weights = 0;
+
+    if (fHasTitle) {
+        float title = 0;
+        ForEachValue(doc, kTitleField, B_STRING_TYPE, [&](const void* data, ssize_t) {
+            Signature signature;
+            MakeSignature(reinterpret_cast<const char*>(data), &signature);
+            title = fmaxf(title, Similarity(fTitle, signature));
+        });
+        score += kTitleWeight * title;
+        weights += kTitleWeight;
+    }
+
+    if (!fAuthors.empty()) {
+        std::vector<Signature> docAuthors;
+        ForEachValue(doc, kAuthorField, B_STRING_TYPE, [&](const void* data, ssize_t) {
+            docAuthors.resize(docAuthors.size() + 1);
+            MakeSignature(reinterpret_cast<const char*>(data), &docAuthors.back());
+        });
+
+        // every author we know should be among the authors of the doc
+        float authors = 0;
+        for (const Signature& author : fAuthors) {
+            float best = 0;
+            for (const Signature& docAuthor : docAuthors) {
+                best = fmaxf(best, Similarity(author, docAuthor));
+            }
+            authors += best;
+        }
+        score += kAuthorWeight * authors / fAuthors.size();
+        weights += kAuthorWeight;
+    }
+
+    if (fYear != 0) {
+        float year = -1;
+        ForEachValue(doc, kYearField, B_DOUBLE_TYPE, [&](const void* data, ssize_t) {
+            double value;
+            memcpy(&value, data, sizeof(value));
+            double distance = fabs(value - fYear);
+            year = fmaxf(year, distance < 0.5 ? 1.0f : (distance < 1.5 ? 0.5f : 0.0f));
+        });
+        score += kYearWeight * (year < 0 ? kUnknownScore : year);
+        weights += kYearWeight;
+    }
+
+    if (!fLanguages.empty()) {
+        float language = -1;
+        ForEachValue(doc, kLanguageField, B_STRING_TYPE, [&](const void* data, ssize_t) {
+            const char* code = reinterpret_cast<const char*>(data);
+            size_t length = strlen(code);
+            for (const BString& known : fLanguages) {
+                // search results use MARC codes like "eng" or "ger", attributes may also
+                // have the English name, which mostly starts with the code
+                bool match = strcasecmp(known.String(), code) == 0
+                    || (length == 3 && known.Length() > 3 && strncasecmp(known.String(), code, 3) == 0);
+                language = fmaxf(language, match ? 1.0f : 0.0f);
+            }
+        });
+        score += kLanguageWeight * (language < 0 ? kUnknownScore : language);
+        weights += kLanguageWeight;
+    }
+
+    return weights > 0 ? score / weights : 0;
+}
+
+int32 CandidateRanker::Rank(const BMessage* docs, float* bestScore) const
+{
+    int32 best = -1;
+    float bestValue = -1;
+
+    BMessage doc;
+    for (int32 i = 0; ; i++) {
+        BString name;
+        name << i;
+        if (docs->FindMessage(name.String(), &doc) != B_OK) {
+            break;
+        }
+        float score = Score(&doc);
+        if (score > bestValue) {
+            best = i;
+            bestValue = score;
+        }
+    }
+
+    if (bestScore != NULL) {
+        *bestScore = best < 0 ? 0 : bestValue;
+    }
+    return best;
+}
+
+float CandidateRanker::Similarity(const char* a, const char* b)
+{
+    Signature signatureA, signatureB;
+    MakeSignature(a, &signatureA);
+    MakeSignature(b, &signatureB);
+    return Similarity(signatureA, signatureB);
+}
+
+int32 CandidateRanker::CountFields()
+{
+    return sizeof(kFields) / sizeof(kFields[0]);
+}
+
+const char* CandidateRanker::FieldAt(int32 index)
+{
+    if (index < 0 || index >= CountFields()) {
+        return NULL;
+    }
+    return kFields[index];
+}
+
+/**
+* sets a bit for every bigram of @text, after lower casing ASCII and turning punctuation into
+* single spaces. Words are padded with spaces, so their first and last letters count as well.
+* Bytes of multibyte characters are kept as they are.
+*/
+void CandidateRanker::MakeSignature(const char* text, Signature* signature)
+{
+    memset(signature->bits, 0, sizeof(signature->bits));
+
+    uint8 previous = ' ';
+    for (const uint8* c = reinterpret_cast<const uint8*>(text); ; c++) {
+        uint8 current = *c;
+        if (current >= 'A' && current <= 'Z') {
+            current += 'a' - 'A';
+        } else if (!((current >= 'a' && current <= 'z') || (current >= '0' && current <= '9')
+                || current >= 0x80)) {
+            current = ' ';
+        }
+
+        if (current != ' ' || previous != ' ') {
+            uint32 hash = (previous * 0x9E3779B1u) ^ (current * 0x85EBCA77u);
+            uint32 bit = (hash ^ (hash >> 15)) & (kSignatureWords * 64 - 1);
+            signature->bits[bit / 64] |= (uint64)1 << (bit % 64);
+        }
+        if (*c == '\0') {
+            break;
+        }
+        previous = current;
+    }
+
+    int32 count = 0;
+    for (int32 i = 0; i < kSignatureWords; i++) {
+        count += __builtin_popcountll(signature->bits[i]);
+    }
+    signature->count = count;
+}
+
+float CandidateRanker::Similarity(const Signature& a, const Signature& b)
+{
+    if (a.count == 0 || b.count == 0) {
+        return 0;
+    }
+
+    // fixed length and branch free, so the compiler can vectorize it
+    int32 common = 0;
+    for (int32 i = 0; i < kSignatureWords; i++) {
+        common += __builtin_popcountll(a.bits[i] & b.bits[i]);
+    }
+    return 2.0f * common / (a.count + b.count);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <vector>
+
+/**
+* scores the docs of a book search against what we already know about the book: title
+* similarity, author overlap, year and language. Docs are read as decoded from search.json,
+* with multi-valued fields as arrays.
+* Strings are compared by the character bigrams of their normalized form, stored in a small
+* bitset per string, so comparing two strings is a few AND and popcount operations.
+*/
+class CandidateRanker {
+
+public:
+    CandidateRanker();
+
+    void        SetTitle(const char* title);
+    void        AddAuthor(const char* author);
+    void        SetYear(int32 year);
+    void        AddLanguage(const char* language);
+
+    // takes title, author_name, publish_year and language from search parameters
+    void        SetFromParams(const BMessage* params);
+
+    bool        IsEmpty() const;
+
+    // between 0 (nothing matches) and 1 (everything matches)
+    float       Score(const BMessage* doc) const;
+
+    /**
+    * returns the index of the best doc in @docs, an array message as decoded from JSON,
+    * or -1 if there are none. Ties go to the earlier doc, since results are sorted by relevance.
+    */
+    int32       Rank(const BMessage* docs, float* bestScore = NULL) const;
+
+    // Dice coefficient of the bigrams of the normalized strings, between 0 and 1
+    static float Similarity(const char* a, const char* b);
+
+    // doc fields the ranker looks at, so they can be requested
+    static int32        CountFields();
+    static const char*  FieldAt(int32 index);
+
+private:
+    static const int32  kSignatureWords = 16;     // 1024 bits
+
+    struct Signature {
+        uint64  bits[kSignatureWords];
+        int32   count;                          // bits set
+    };
+
+    static void     MakeSignature(const char* text, Signature* signature);
+    static float    Similarity(const Signature& a, const Signature& b);
+
+    Signature               fTitle;
+    bool                    fHasTitle;
+    std::vector<Signature>  fAuthors;
+    int32                   fYear;              // 0 if unknown
+    std::vector<BString>    fLanguages;         // lower case
+};
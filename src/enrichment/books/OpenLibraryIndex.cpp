@@ -0,0 +1,235 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "OpenLibraryIndex.h"
+#include "../Isbn.h"
+#include "../../common/Log.h"
+
+// same message layout as BJson::Parse(), see JsonDecoder
+static const uint32 kJsonObjectWhat = 'JSOB';
+static const uint32 kJsonArrayWhat  = 'JSAR';
+
+OpenLibraryIndex::OpenLibraryIndex()
+    :
+    fMapping(MAP_FAILED),
+    fMappingSize(0),
+    fHeader(NULL),
+    fIsbns(NULL),
+    fEditions(NULL),
+    fAuthors(NULL),
+    fAuthorRefs(NULL),
+    fStrings(NULL)
+{
+}
+
+OpenLibraryIndex::~OpenLibraryIndex()
+{
+    if (fMapping != MAP_FAILED) {
+        munmap(fMapping, fMappingSize);
+    }
+}
+
+/**
+* maps the index at @path, the file is only paged in as far as lookups touch it.
+*/
+status_t OpenLibraryIndex::Open(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        status_t result = errno;
+        close(fd);
+        return result;
+    }
+    if ((size_t)st.st_size < sizeof(ol_index_header)) {
+        close(fd);
+        return B_BAD_DATA;
+    }
+
+    void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    status_t result = mapping == MAP_FAILED ? errno : B_OK;
+    close(fd);
+    if (result != B_OK) {
+        return result;
+    }
+
+    const ol_index_header* header = static_cast<const ol_index_header*>(mapping);
+    const uint64 size = st.st_size;
+
+    // never trust offsets read from a file
+    bool valid = header->magic == OL_INDEX_MAGIC && header->version == OL_INDEX_VERSION
+        && header->isbnOffset + (uint64)header->isbnCount * sizeof(ol_isbn_entry) <= size
+        && header->editionOffset + (uint64)header->editionCount * sizeof(ol_edition) <= size
+        && header->authorOffset + (uint64)header->authorCount * sizeof(ol_author) <= size
+        && header->authorRefOffset + (uint64)header->authorRefCount * sizeof(uint32) <= size
+        && header->stringSize > 0 && header->stringOffset + header->stringSize <= size;
+
+    const char* base = static_cast<const char*>(mapping);
+    if (valid && base[header->stringOffset + header->stringSize - 1] != '\0') {
+        valid = false;
+    }
+    if (!valid) {
+        SLOG_ERROR("%s is not a valid OpenLibrary index.\n", path);
+        munmap(mapping, st.st_size);
+        return B_BAD_DATA;
+    }
+
+    if (fMapping != MAP_FAILED) {
+        munmap(fMapping, fMappingSize);
+    }
+    fMapping = mapping;
+    fMappingSize = st.st_size;
+    fHeader = header;
+    fIsbns = reinterpret_cast<const ol_isbn_entry*>(base + header->isbnOffset);
+    fEditions = reinterpret_cast<const ol_edition*>(base + header->editionOffset);
+    fAuthors = reinterpret_cast<const ol_author*>(base + header->authorOffset);
+    fAuthorRefs = reinterpret_cast<const uint32*>(base + header->authorRefOffset);
+    fStrings = base + header->stringOffset;
+
+    SLOG_INFO("opened OpenLibrary index %s with %" B_PRIu32 " editions and %" B_PRIu32 " authors.\n",
+        path, header->editionCount, header->authorCount);
+    return B_OK;
+}
+
+status_t OpenLibraryIndex::FindEdition(const char* isbn, BMessage* doc) const
+{
+    if (fHeader == NULL) {
+        return B_NO_INIT;
+    }
+
+    Isbn parsed;
+    if (Isbn::Parse(isbn, &parsed) != B_OK) {
+        return B_BAD_VALUE;
+    }
+    uint64 isbn13 = parsed.Value();
+
+    const ol_isbn_entry* end = fIsbns + fHeader->isbnCount;
+    const ol_isbn_entry* entry = std::lower_bound(fIsbns, end, isbn13,
+        [](const ol_isbn_entry& entry, uint64 value) {
+            return entry.isbn < value;
+        });
+    if (entry == end || entry->isbn != isbn13 || entry->edition >= fHeader->editionCount) {
+        return B_ENTRY_NOT_FOUND;
+    }
+
+    const ol_edition& edition = fEditions[entry->edition];
+    doc->MakeEmpty();
+    doc->what = kJsonObjectWhat;
+
+    AddString(doc, "title", edition.title);
+
+    BMessage authorNames(kJsonArrayWhat);
+    BMessage authorKeys(kJsonArrayWhat);
+    char index[16];
+    int32 count = 0;
+    for (uint32 i = 0; i < edition.authorCount; i++) {
+        uint32 ref = edition.firstAuthorRef + i;
+        if (ref >= fHeader->authorRefCount || fAuthorRefs[ref] >= fHeader->authorCount) {
+            break;
+        }
+        const ol_author& author = fAuthors[fAuthorRefs[ref]];
+        snprintf(index, sizeof(index), "%" B_PRId32, count++);
+        authorNames.AddString(index, StringAt(author.name));
+        authorKeys.AddString(index, StringAt(author.key));
+    }
+    if (count > 0) {
+        doc->AddMessage("author_name", &authorNames);
+        doc->AddMessage("author_key", &authorKeys);
+    }
+
+    // single values are still returned as arrays, like the search API does
+    const struct { const char* name; uint32 offset; } arrays[] = {
+        { "publisher", edition.publisher },
+        { "language", edition.language },
+        { "lcc", edition.lcc }
+    };
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        if (arrays[i].offset == 0) {
+            continue;
+        }
+        BMessage array(kJsonArrayWhat);
+        AddString(&array, "0", arrays[i].offset);
+        doc->AddMessage(arrays[i].name, &array);
+    }
+
+    if (edition.publishYear > 0) {
+        BMessage years(kJsonArrayWhat);
+        years.AddDouble("0", edition.publishYear);
+        doc->AddMessage("publish_year", &years);
+    }
+
+    BMessage isbns(kJsonArrayWhat);
+    snprintf(index, sizeof(index), "%" B_PRIu64, isbn13);
+    isbns.AddString("0", index);
+    doc->AddMessage("isbn", &isbns);
+
+    if (edition.pages > 0) {
+        doc->AddDouble("number_of_pages_median", edition.pages);
+    }
+    if (edition.coverId >= 0) {
+        doc->AddDouble("cover_i", edition.coverId);
+    }
+
+    return B_OK;
+}
+
+status_t OpenLibraryIndex::FindAuthor(const char* authorKey, BMessage* author) const
+{
+    if (fHeader == NULL) {
+        return B_NO_INIT;
+    }
+
+    const ol_author* end = fAuthors + fHeader->authorCount;
+    const ol_author* entry = std::lower_bound(fAuthors, end, authorKey,
+        [this](const ol_author& author, const char* key) {
+            return strcmp(StringAt(author.key), key) < 0;
+        });
+    if (entry == end || strcmp(StringAt(entry->key), authorKey) != 0) {
+        return B_ENTRY_NOT_FOUND;
+    }
+
+    author->MakeEmpty();
+    author->what = kJsonObjectWhat;
+
+    AddString(author, "name", entry->name);
+    AddString(author, "birth_date", entry->birthDate);
+    if (entry->photoId >= 0) {
+        BMessage photos(kJsonArrayWhat);
+        photos.AddDouble("0", entry->photoId);
+        author->AddMessage("photos", &photos);
+    }
+
+    return B_OK;
+}
+
+uint32 OpenLibraryIndex::CountEditions() const
+{
+    return fHeader != NULL ? fHeader->editionCount : 0;
+}
+
+const char* OpenLibraryIndex::StringAt(uint32 offset) const
+{
+    return offset < fHeader->stringSize ? fStrings + offset : "";
+}
+
+void OpenLibraryIndex::AddString(BMessage* msg, const char* name, uint32 offset) const
+{
+    if (offset != 0) {
+        msg->AddString(name, StringAt(offset));
+    }
+}
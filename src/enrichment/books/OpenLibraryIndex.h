@@ -0,0 +1,93 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+#define OL_INDEX_MAGIC          'OLIX'
+#define OL_INDEX_VERSION        1
+#define OL_INDEX_FILE_NAME      "openlibrary.idx"
+
+/*
+* on-disk layout of the offline OpenLibrary index, written by the olindex tool.
+* All sections are arrays of fixed size records in host byte order, strings are referenced
+* by their offset into a pool of NUL terminated strings that starts with an empty string,
+* so offset 0 means "not set".
+*/
+struct ol_index_header {
+    uint32  magic;
+    uint32  version;
+    uint32  isbnCount;
+    uint32  editionCount;
+    uint32  authorCount;
+    uint32  authorRefCount;
+    uint64  isbnOffset;         // ol_isbn_entry, sorted by ISBN
+    uint64  editionOffset;      // ol_edition
+    uint64  authorOffset;       // ol_author, sorted by key
+    uint64  authorRefOffset;    // uint32 author indices, referenced by editions
+    uint64  stringOffset;
+    uint64  stringSize;
+};
+
+struct ol_isbn_entry {
+    uint64  isbn;               // ISBN-13 as number, ISBN-10 is converted on import
+    uint32  edition;
+    uint32  reserved;
+};
+
+struct ol_edition {
+    uint32  title;
+    uint32  publisher;
+    uint32  language;           // 3 letter code like "eng"
+    uint32  lcc;
+    uint32  firstAuthorRef;
+    uint16  authorCount;
+    uint16  publishYear;
+    uint32  pages;
+    int32   coverId;            // -1 if there is no cover
+};
+
+struct ol_author {
+    uint32  key;                // without the "/authors/" prefix, e.g. "OL23919A"
+    uint32  name;
+    uint32  birthDate;
+    int32   photoId;            // -1 if there is no photo
+};
+
+/**
+* read-only view of a memory-mapped offline OpenLibrary index.
+* Lookups return messages in the layout of the corresponding OpenLibrary API responses,
+* i.e. a single result of search.json or an authors/$id.json record, so results can be
+* mapped just like the ones fetched from the web service.
+*/
+class OpenLibraryIndex {
+
+public:
+    OpenLibraryIndex();
+    ~OpenLibraryIndex();
+
+    status_t    Open(const char* path);
+    status_t    InitCheck() const { return fHeader != NULL ? B_OK : B_NO_INIT; }
+
+    // @isbn may be an ISBN-10 or ISBN-13 with or without dashes
+    status_t    FindEdition(const char* isbn, BMessage* doc) const;
+    status_t    FindAuthor(const char* authorKey, BMessage* author) const;
+
+    uint32      CountEditions() const;
+
+private:
+    const char* StringAt(uint32 offset) const;
+    void        AddString(BMessage* msg, const char* name, uint32 offset) const;
+
+    void*                   fMapping;
+    size_t                  fMappingSize;
+    const ol_index_header*  fHeader;
+    const ol_isbn_entry*    fIsbns;
+    const ol_edition*       fEditions;
+    const ol_author*        fAuthors;
+    const uint32*           fAuthorRefs;
+    const char*             fStrings;
+};
@@ -0,0 +1,570 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ * olindex - builds the offline OpenLibrary index used by bert from the OpenLibrary data dumps,
+ * see https://openlibrary.org/developers/dumps
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../OpenLibraryIndex.h"
+#include "../../Isbn.h"
+#include "../../JsonDecoder.h"
+#include "../../../common/Log.h"
+
+// dump lines are "type \t key \t revision \t last_modified \t JSON"
+static const int32  kJsonColumn = 4;
+static const size_t kMaxLineLength = 4 * 1024 * 1024;
+// ISBNs are validated in batches, which is a lot faster than one by one
+static const size_t kIsbnBatchSize = 4096;
+
+/**
+* pool of NUL terminated strings, short values that repeat a lot are stored once.
+* The index addresses strings by uint32 offsets, so the pool is full after 4 GiB.
+*/
+class StringPool {
+
+public:
+    StringPool()
+        :
+        fFull(false)
+    {
+        fData.push_back('\0');
+    }
+
+    // returns 0 for empty values and once the pool is full, see IsFull()
+    uint32 Add(const char* value, bool shared = false)
+    {
+        if (value == NULL || value[0] == '\0') {
+            return 0;
+        }
+        if (shared) {
+            auto it = fShared.find(value);
+            if (it != fShared.end()) {
+                return it->second;
+            }
+        }
+        if (fData.size() > UINT32_MAX) {
+            fFull = true;
+            return 0;
+        }
+        uint32 offset = fData.size();
+        fData.insert(fData.end(), value, value + strlen(value) + 1);
+        if (shared) {
+            fShared.emplace(value, offset);
+        }
+        return offset;
+    }
+
+    const std::vector<char>& Data() const { return fData; }
+    const char* At(uint32 offset) const { return &fData[offset]; }
+    // true if a string did not fit anymore
+    bool        IsFull() const { return fFull; }
+
+private:
+    std::vector<char>                           fData;
+    std::unordered_map<std::string, uint32>     fShared;
+    bool                                        fFull;
+};
+
+/**
+* collects authors, works and editions from the dumps and writes them as an OpenLibraryIndex.
+*/
+class IndexBuilder {
+
+public:
+                IndexBuilder();
+
+    status_t    ReadAuthors(const char* path);
+    status_t    ReadWorks(const char* path);
+    status_t    ReadEditions(const char* path);
+    status_t    Write(const char* path);
+
+private:
+    typedef void (IndexBuilder::*record_func)(const char* key, const BMessage& record);
+
+    status_t    ReadDump(const char* path, const JsonProjection& projection, record_func func);
+
+    void        AddAuthor(const char* key, const BMessage& record);
+    void        AddWork(const char* key, const BMessage& record);
+    void        AddEdition(const char* key, const BMessage& record);
+
+    void        FlushIsbns();
+    void        SortAuthors();
+    int32       AuthorIndex(const char* key) const;
+
+    StringPool                      fStrings;
+    std::vector<ol_author>          fAuthors;
+    std::unordered_map<std::string, uint32> fAuthorIndex;
+    bool                            fAuthorsSorted;
+    std::unordered_map<std::string, std::vector<uint32> > fWorkAuthors;
+    std::vector<uint32>             fAuthorRefs;
+    std::vector<ol_edition>         fEditions;
+    std::vector<ol_isbn_entry>      fIsbns;
+    // not yet validated ISBNs and the editions they belong to
+    std::vector<std::string>        fPendingIsbns;
+    std::vector<uint32>             fPendingEditions;
+};
+
+IndexBuilder::IndexBuilder()
+    :
+    fAuthorsSorted(false)
+{
+}
+
+// helpers for the message layout of the JsonDecoder
+
+static std::vector<std::string> ArrayStrings(const BMessage& record, const char* name,
+    const char* objectKey = NULL)
+{
+    std::vector<std::string> values;
+    BMessage array;
+    if (record.FindMessage(name, &array) != B_OK) {
+        return values;
+    }
+
+    char field[16];
+    for (int32 i = 0; ; i++) {
+        snprintf(field, sizeof(field), "%" B_PRId32, i);
+        const char* value = NULL;
+        if (objectKey == NULL) {
+            value = array.GetString(field, NULL);
+            if (value == NULL && !array.HasMessage(field)) {
+                break;
+            }
+        } else {
+            BMessage object;
+            if (array.FindMessage(field, &object) != B_OK) {
+                break;
+            }
+            value = object.GetString(objectKey, NULL);
+            // work authors are nested one level deeper as {"author": {"key": ...}}
+            BMessage nested;
+            if (value == NULL && object.FindMessage("author", &nested) == B_OK) {
+                value = nested.GetString(objectKey, NULL);
+            }
+        }
+        if (value != NULL) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+static int32 ArrayNumber(const BMessage& record, const char* name)
+{
+    BMessage array;
+    if (record.FindMessage(name, &array) != B_OK) {
+        return -1;
+    }
+    double value;
+    return array.FindDouble("0", &value) == B_OK ? (int32)value : -1;
+}
+
+// "/authors/OL23919A" -> "OL23919A", "/languages/eng" -> "eng"
+static const char* LastPathComponent(const std::string& key)
+{
+    size_t separator = key.rfind('/');
+    return separator == std::string::npos ? key.c_str() : key.c_str() + separator + 1;
+}
+
+// publish dates come in all kinds of formats, we only need the year
+static uint16 ParseYear(const char* date)
+{
+    if (date == NULL) {
+        return 0;
+    }
+    for (const char* c = date; *c != '\0'; c++) {
+        if (strspn(c, "0123456789") == 4) {
+            int year = atoi(c);
+            if (year >= 1000 && year <= 2100) {
+                return year;
+            }
+        }
+        while (*c >= '0' && *c <= '9' && c[1] != '\0') {
+            c++;
+        }
+    }
+    return 0;
+}
+
+status_t IndexBuilder::ReadDump(const char* path, const JsonProjection& projection, record_func func)
+{
+    gzFile file = gzopen(path, "rb");
+    if (file == NULL) {
+        SLOG_ERROR("could not open dump %s\n", path);
+        return B_ENTRY_NOT_FOUND;
+    }
+
+    std::vector<char> line(kMaxLineLength);
+    JsonDecoder decoder(&projection);
+    int64 count = 0;
+    int64 failed = 0;
+
+    while (gzgets(file, line.data(), line.size()) != NULL) {
+        char* columns[kJsonColumn + 1];
+        char* pos = line.data();
+        int32 column = 0;
+
+        columns[column++] = pos;
+        while (column <= kJsonColumn && (pos = strchr(pos, '\t')) != NULL) {
+            *pos++ = '\0';
+            columns[column++] = pos;
+        }
+        if (column <= kJsonColumn) {
+            failed++;   // overlong or broken line
+            continue;
+        }
+
+        BMessage record;
+        if (decoder.Decode(columns[kJsonColumn], strlen(columns[kJsonColumn]), &record) != B_OK) {
+            failed++;
+            continue;
+        }
+        (this->*func)(LastPathComponent(columns[1]), record);
+        if (fStrings.IsFull()) {
+            SLOG_ERROR("%s: strings exceed the 4 GiB the index can address, giving up.\n", path);
+            gzclose(file);
+            return B_BUFFER_OVERFLOW;
+        }
+
+        if (++count % 1000000 == 0) {
+            SLOG_INFO("%s: %" B_PRId64 " records...\n", path, count);
+        }
+    }
+    gzclose(file);
+
+    SLOG_INFO("%s: read %" B_PRId64 " records, skipped %" B_PRId64 " broken ones.\n", path, count, failed);
+    return B_OK;
+}
+
+status_t IndexBuilder::ReadAuthors(const char* path)
+{
+    JsonProjection projection;
+    projection.AddPath("name");
+    projection.AddPath("birth_date");
+    projection.AddPath("photos");
+    projection.SetMaxItems("photos", 1);
+
+    return ReadDump(path, projection, &IndexBuilder::AddAuthor);
+}
+
+status_t IndexBuilder::ReadWorks(const char* path)
+{
+    SortAuthors();
+
+    JsonProjection projection;
+    projection.AddPath("authors/*/author/key");
+
+    return ReadDump(path, projection, &IndexBuilder::AddWork);
+}
+
+status_t IndexBuilder::ReadEditions(const char* path)
+{
+    SortAuthors();
+
+    JsonProjection projection;
+    const char* paths[] = { "title", "isbn_10", "isbn_13", "authors/*/key", "works/*/key",
+        "publishers", "publish_date", "number_of_pages", "covers", "languages/*/key",
+        "lc_classifications" };
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        projection.AddPath(paths[i]);
+    }
+    projection.SetMaxItems("covers", 1);
+
+    return ReadDump(path, projection, &IndexBuilder::AddEdition);
+}
+
+void IndexBuilder::AddAuthor(const char* key, const BMessage& record)
+{
+    ol_author author;
+    author.key = fStrings.Add(key);
+    author.name = fStrings.Add(record.GetString("name", NULL));
+    author.birthDate = fStrings.Add(record.GetString("birth_date", NULL));
+    author.photoId = ArrayNumber(record, "photos");
+
+    fAuthors.push_back(author);
+    fAuthorsSorted = false;
+}
+
+void IndexBuilder::AddWork(const char* key, const BMessage& record)
+{
+    std::vector<std::string> authorKeys = ArrayStrings(record, "authors", "key");
+    std::vector<uint32> authors;
+
+    for (size_t i = 0; i < authorKeys.size(); i++) {
+        int32 index = AuthorIndex(LastPathComponent(authorKeys[i]));
+        if (index >= 0) {
+            authors.push_back(index);
+        }
+    }
+    if (!authors.empty()) {
+        fWorkAuthors[key].swap(authors);
+    }
+}
+
+void IndexBuilder::AddEdition(const char* key, const BMessage& record)
+{
+    std::vector<std::string> isbns = ArrayStrings(record, "isbn_13");
+    std::vector<std::string> isbn10 = ArrayStrings(record, "isbn_10");
+    isbns.insert(isbns.end(), isbn10.begin(), isbn10.end());
+
+    if (isbns.empty()) {
+        return;     // not reachable by ISBN, no need to keep it
+    }
+
+    uint32 editionIndex = fEditions.size();
+    for (size_t i = 0; i < isbns.size(); i++) {
+        fPendingIsbns.push_back(std::move(isbns[i]));
+        fPendingEditions.push_back(editionIndex);
+    }
+    if (fPendingIsbns.size() >= kIsbnBatchSize) {
+        FlushIsbns();
+    }
+
+    ol_edition edition;
+    memset(&edition, 0, sizeof(edition));
+    edition.title = fStrings.Add(record.GetString("title", NULL));
+
+    std::vector<std::string> values = ArrayStrings(record, "publishers");
+    edition.publisher = values.empty() ? 0 : fStrings.Add(values[0].c_str(), true);
+    values = ArrayStrings(record, "languages", "key");
+    edition.language = values.empty() ? 0 : fStrings.Add(LastPathComponent(values[0]), true);
+    values = ArrayStrings(record, "lc_classifications");
+    edition.lcc = values.empty() ? 0 : fStrings.Add(values[0].c_str(), true);
+
+    edition.publishYear = ParseYear(record.GetString("publish_date", NULL));
+    edition.pages = (uint32)std::max(0.0, record.GetDouble("number_of_pages", 0));
+    edition.coverId = ArrayNumber(record, "covers");
+
+    // editions often only reference their work, which has the authors
+    std::vector<uint32> authors;
+    values = ArrayStrings(record, "authors", "key");
+    for (size_t i = 0; i < values.size(); i++) {
+        int32 index = AuthorIndex(LastPathComponent(values[i]));
+        if (index >= 0) {
+            authors.push_back(index);
+        }
+    }
+    if (authors.empty()) {
+        values = ArrayStrings(record, "works", "key");
+        if (!values.empty()) {
+            auto it = fWorkAuthors.find(LastPathComponent(values[0]));
+            if (it != fWorkAuthors.end()) {
+                authors = it->second;
+            }
+        }
+    }
+    edition.firstAuthorRef = fAuthorRefs.size();
+    edition.authorCount = std::min<size_t>(authors.size(), UINT16_MAX);
+    fAuthorRefs.insert(fAuthorRefs.end(), authors.begin(), authors.begin() + edition.authorCount);
+
+    fEditions.push_back(edition);
+}
+
+void IndexBuilder::FlushIsbns()
+{
+    std::vector<const char*> values(fPendingIsbns.size());
+    for (size_t i = 0; i < fPendingIsbns.size(); i++) {
+        values[i] = fPendingIsbns[i].c_str();
+    }
+    std::vector<uint64> isbns(values.size());
+    Isbn::ParseBatch(values.data(), values.size(), isbns.data());
+
+    for (size_t i = 0; i < isbns.size(); i++) {
+        if (isbns[i] == 0) {
+            continue;   // invalid, the edition may still be found by its other ISBNs
+        }
+        ol_isbn_entry entry;
+        entry.isbn = isbns[i];
+        entry.edition = fPendingEditions[i];
+        entry.reserved = 0;
+        fIsbns.push_back(entry);
+    }
+
+    fPendingIsbns.clear();
+    fPendingEditions.clear();
+}
+
+void IndexBuilder::SortAuthors()
+{
+    if (fAuthorsSorted) {
+        return;
+    }
+
+    const StringPool& strings = fStrings;
+    std::sort(fAuthors.begin(), fAuthors.end(),
+        [&strings](const ol_author& a, const ol_author& b) {
+            return strcmp(strings.At(a.key), strings.At(b.key)) < 0;
+        });
+
+    fAuthorIndex.clear();
+    fAuthorIndex.reserve(fAuthors.size());
+    for (size_t i = 0; i < fAuthors.size(); i++) {
+        fAuthorIndex.emplace(fStrings.At(fAuthors[i].key), i);
+    }
+    fAuthorsSorted = true;
+}
+
+int32 IndexBuilder::AuthorIndex(const char* key) const
+{
+    auto it = fAuthorIndex.find(key);
+    return it != fAuthorIndex.end() ? (int32)it->second : -1;
+}
+
+static status_t WriteSection(FILE* file, const void* data, size_t size, uint64* offset)
+{
+    // keep all sections 8 byte aligned for the mapping
+    static const char kPadding[8] = { 0 };
+    long position = ftell(file);
+    size_t padding = (8 - position % 8) % 8;
+    if (padding > 0 && fwrite(kPadding, 1, padding, file) != padding) {
+        return B_IO_ERROR;
+    }
+
+    *offset = position + padding;
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return B_IO_ERROR;
+    }
+    return B_OK;
+}
+
+status_t IndexBuilder::Write(const char* path)
+{
+    FlushIsbns();
+    SortAuthors();
+
+    // lookups use the first edition with an ISBN, like the search would
+    std::stable_sort(fIsbns.begin(), fIsbns.end(),
+        [](const ol_isbn_entry& a, const ol_isbn_entry& b) {
+            return a.isbn < b.isbn;
+        });
+    fIsbns.erase(std::unique(fIsbns.begin(), fIsbns.end(),
+        [](const ol_isbn_entry& a, const ol_isbn_entry& b) {
+            return a.isbn == b.isbn;
+        }), fIsbns.end());
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        SLOG_ERROR("could not create index %s\n", path);
+        return B_ERROR;
+    }
+
+    ol_index_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = OL_INDEX_MAGIC;
+    header.version = OL_INDEX_VERSION;
+    header.isbnCount = fIsbns.size();
+    header.editionCount = fEditions.size();
+    header.authorCount = fAuthors.size();
+    header.authorRefCount = fAuthorRefs.size();
+    header.stringSize = fStrings.Data().size();
+
+    // written again with the offsets at the end
+    status_t result = fwrite(&header, sizeof(header), 1, file) == 1 ? B_OK : B_IO_ERROR;
+    if (result == B_OK) {
+        result = WriteSection(file, fIsbns.data(), fIsbns.size() * sizeof(ol_isbn_entry),
+            &header.isbnOffset);
+    }
+    if (result == B_OK) {
+        result = WriteSection(file, fEditions.data(), fEditions.size() * sizeof(ol_edition),
+            &header.editionOffset);
+    }
+    if (result == B_OK) {
+        result = WriteSection(file, fAuthors.data(), fAuthors.size() * sizeof(ol_author),
+            &header.authorOffset);
+    }
+    if (result == B_OK) {
+        result = WriteSection(file, fAuthorRefs.data(), fAuthorRefs.size() * sizeof(uint32),
+            &header.authorRefOffset);
+    }
+    if (result == B_OK) {
+        result = WriteSection(file, fStrings.Data().data(), fStrings.Data().size(),
+            &header.stringOffset);
+    }
+    if (result == B_OK) {
+        rewind(file);
+        result = fwrite(&header, sizeof(header), 1, file) == 1 ? B_OK : B_IO_ERROR;
+    }
+    if (fclose(file) != 0 && result == B_OK) {
+        result = B_IO_ERROR;
+    }
+
+    if (result != B_OK) {
+        SLOG_ERROR("failed to write index %s: %s\n", path, strerror(result));
+        remove(path);
+        return result;
+    }
+
+    SLOG_INFO("wrote %s: %" B_PRIu32 " ISBNs, %" B_PRIu32 " editions, %" B_PRIu32 " authors, "
+        "%" B_PRIu64 " bytes of strings.\n", path, header.isbnCount, header.editionCount,
+        header.authorCount, header.stringSize);
+    return B_OK;
+}
+
+static void PrintUsage()
+{
+    std::cerr << "Usage: olindex -o <index file> [-a <authors dump>] [-w <works dump>] "
+              << "<editions dump>" << std::endl;
+    std::cerr << "builds the offline OpenLibrary index for bert from the (gzipped) data dumps." << std::endl;
+    std::cerr << "Authors and works are optional, but needed to resolve the authors of editions." << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const char* outputPath = NULL;
+    const char* authorsPath = NULL;
+    const char* worksPath = NULL;
+    const char* editionsPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "-o") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (strcmp(arg, "-a") == 0 && hasValue) {
+            authorsPath = argv[++i];
+        } else if (strcmp(arg, "-w") == 0 && hasValue) {
+            worksPath = argv[++i];
+        } else if (arg[0] != '-' && editionsPath == NULL) {
+            editionsPath = arg;
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (outputPath == NULL || editionsPath == NULL) {
+        PrintUsage();
+        return 1;
+    }
+
+    // authors first, works and editions refer to them
+    IndexBuilder builder;
+    status_t result = B_OK;
+    if (authorsPath != NULL) {
+        result = builder.ReadAuthors(authorsPath);
+    }
+    if (result == B_OK && worksPath != NULL) {
+        result = builder.ReadWorks(worksPath);
+    }
+    if (result == B_OK) {
+        result = builder.ReadEditions(editionsPath);
+    }
+    if (result == B_OK) {
+        result = builder.Write(outputPath);
+    }
+
+    Logger::Shutdown();
+    return result == B_OK ? 0 : 1;
+}
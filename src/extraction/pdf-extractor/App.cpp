@@ -14,6 +14,7 @@
 #include <cstring>
 
 #include "App.h"
+#include "../../common/Metrics.h"
 #include <sen/Sen.h>
 #include <sen/Sensei.h>
 
@@ -60,6 +61,8 @@ void App::RefsReceived(BMessage *message)
     BMessage reply(SENSEI_MESSAGE_RESULT);
     status_t result = ExtractPdfBookmarks(const_cast<const entry_ref*>(&ref), &reply);
     reply.AddString("result", strerror(result));
+    Metrics::Default()->AddToMessage(&reply);
+    Metrics::Default()->Export();
 
     // we don't expect a reply but run into a race condition with the app
     // being deleted too early, resulting in a malloc assertion failure.
@@ -69,6 +72,8 @@ void App::RefsReceived(BMessage *message)
 
 status_t App::ExtractPdfBookmarks(const entry_ref* ref, BMessage *reply)
 {
+    METRICS_STAGE("pdf.extract_bookmarks");
+
     status_t result;
     BPath inputPath(ref);
 
@@ -17,6 +17,7 @@
 #include "App.h"
 #include "clang-include-checker/ClangWrapper.hpp"
 #include "Sensei.h"
+#include "../../common/Metrics.h"
 
 const char* kApplicationSignature = "application/x-vnd.sen-labs.SourceCodeExtractor";
 
@@ -63,6 +64,8 @@ void App::RefsReceived(BMessage *message)
     if (result != B_OK) {
         reply.AddString("pluginResult", strerror(result));  // TODO: handle not found includes correctly
     }
+    Metrics::Default()->AddToMessage(&reply);
+    Metrics::Default()->Export();
 
     // we don't expect a reply but run into a race condition with the app
     // being deleted too early, resulting in a malloc assertion failure.
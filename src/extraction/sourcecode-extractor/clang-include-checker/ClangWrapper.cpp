@@ -19,7 +19,6 @@
  */
 
 #include <Path.h>
-#include <iostream>
 #include <Message.h>
 
 #include <clang/Basic/Diagnostic.h>
@@ -29,6 +28,8 @@
 
 #include "ClangWrapper.hpp"
 #include "IncludeFinderAction.hpp"
+#include "../../../common/Log.h"
+#include "../../../common/Metrics.h"
 
 using namespace clang::tooling;
 static llvm::cl::OptionCategory toolCategory("Include scanner");
@@ -42,6 +43,8 @@ ClangWrapper::~ClangWrapper() {
 }
 
 int ClangWrapper::run(BMessage *reply) {
+    METRICS_STAGE("clang.scan_includes");
+
     const char* argv[3];
     argv[0] = "clang++";
     argv[1] = fSourcePath;
@@ -51,7 +54,7 @@ int ClangWrapper::run(BMessage *reply) {
     llvm::Expected<CommonOptionsParser> optionsParserOpt = CommonOptionsParser::create(argc, argv, toolCategory);
     if (!optionsParserOpt) {
         llvm::errs() << optionsParserOpt.takeError();
-        std::cerr << "failed to setup parser: " << llvm::errs().error() << std::endl;
+        SLOG_ERROR("failed to setup parser for %s\n", fSourcePath);
         return -1;
     }
     CommonOptionsParser& optionsParser = optionsParserOpt.get();
@@ -64,7 +67,7 @@ int ClangWrapper::run(BMessage *reply) {
     int result = tool.run(customFrontendActionFactory(includeFinder).get());
 
     if (result != 0) {
-        printf("there were errors scanning path '%s' for includes.\n", fSourcePath);
+        SLOG_WARN("there were errors scanning path '%s' for includes.\n", fSourcePath);
         // still continue with the includes we've got, might just be some missing ones.
         // we iterate over those below and return the error result anyway.
     }
@@ -75,7 +78,8 @@ int ClangWrapper::run(BMessage *reply) {
     BMessage item;
     int32 msgIndex = 0;
 
-    printf("got %zu includes for path %s:\n", includes.size(), fSourcePath);
+    SLOG_INFO("got %zu includes for path %s:\n", includes.size(), fSourcePath);
+    METRICS_COUNT("clang.includes", includes.size());
 
     for (it = includes.begin(); it != includes.end(); ++it, msgIndex++) {
         unsigned int lineNum =    (*it)->lineNum;
@@ -83,8 +87,8 @@ int ClangWrapper::run(BMessage *reply) {
         std::string  searchPath = (*it)->filePath;
         bool         isGlobal =   (*it)->global;
 
-        std::cout << lineNum << ": " << hdrPath << " from " << searchPath <<
-            (isGlobal ? " (global)" : "(local)") << std::endl;
+        SLOG_DEBUG("%u: %s from %s%s\n", lineNum, hdrPath.c_str(), searchPath.c_str(),
+            isGlobal ? " (global)" : " (local)");
 
         BPath path(hdrPath.c_str());
 
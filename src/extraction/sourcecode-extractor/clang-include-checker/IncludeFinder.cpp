@@ -1,14 +1,14 @@
-#include <iostream>
 #include <vector>
 
 #include <clang/Frontend/CompilerInstance.h>
 
 #include "IncludeFinder.hpp"
+#include "../../../common/Log.h"
 
 std::unique_ptr<PPCallbacks>
 IncludeFinder::createPreprocessorCallbacks()
 {
-    std::cout << "createPreprocessorCallbacks\n";
+    SLOG_TRACE("createPreprocessorCallbacks\n");
     return std::unique_ptr<PPCallbacks>(this);
 }
 
@@ -27,8 +27,8 @@ IncludeFinder::InclusionDirective(SourceLocation HashLoc,
 {
     const unsigned int lineNum = compiler->getSourceManager().getSpellingLineNumber(HashLoc);
 
-	std::cout << "adding include: file " << FileName.str() << " with line " << lineNum
-              << " and path " << SearchPath.str() << std::endl;
+    SLOG_DEBUG("adding include: file %s with line %u and path %s\n",
+        FileName.str().c_str(), lineNum, SearchPath.str().c_str());
 
     includes.push_back(new IncludeInfo{lineNum, FileName.str(), SearchPath.str(), IsAngled});
 }
@@ -36,5 +36,5 @@ IncludeFinder::InclusionDirective(SourceLocation HashLoc,
 void
 IncludeFinder::EndOfMainFile()
 {
-    std::cout << "*** end of main file reached, found " << includes.size() << " includes." << std::endl;
+    SLOG_DEBUG("*** end of main file reached, found %zu includes.\n", includes.size());
 }
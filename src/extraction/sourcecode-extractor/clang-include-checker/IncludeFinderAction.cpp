@@ -1,7 +1,7 @@
-#include <iostream>
 #include <clang/Frontend/CompilerInstance.h>
 #include "IncludeFinder.hpp"
 #include "IncludeFinderAction.hpp"
+#include "../../../common/Log.h"
 
 IncludeFinderAction::IncludeFinderAction(IncludeFinder* includeFinder)
 : includeFinder(includeFinder)
@@ -19,11 +19,11 @@ IncludeFinderAction::ExecuteAction()
     // only parse a single file and don't follow dependency chain
     getCompilerInstance().getPreprocessor().getPreprocessorOpts().SingleFileParseMode = true;
 
-    std::cout << "calling executeAction\n";
+    SLOG_TRACE("calling executeAction\n");
     PreprocessOnlyAction::ExecuteAction();
 }
 
 void IncludeFinderAction::EndSourceFileAction()
 {
-    std::cout << "end of file reached." << std::endl;
+    SLOG_TRACE("end of file reached.\n");
 }
@@ -12,12 +12,15 @@
 
 #include "App.h"
 #include "Sen.h"
+#include "../../common/Log.h"
 
 const char* kApplicationSignature = "application/x-vnd.sen-labs.PdfNavigator";
 
 App::App() : BApplication(kApplicationSignature)
 {
     fMapper = new MappingUtil();
+    fMapper->AddAliases(kDocRefMappingProfile, MAPPING_PROFILE_SIZE(kDocRefMappingProfile));
+    fMapper->Compile();
 }
 
 App::~App()
@@ -88,7 +91,7 @@ void App::RefsReceived(BMessage *message)
                 if (argsMsg.HasRef(SEN_RELATION_TARGET_REF_ATTR)) {
                     result = argsMsg.FindRef(SEN_RELATION_TARGET_REF_ATTR, &ref);
                     if (result == B_OK) {
-                        printf("got new launch ref: %s\n", ref.name);
+                        SLOG_DEBUG("got new launch ref: %s\n", ref.name);
                         // replace in original message
                         message->ReplaceRef("refs", &ref);
                     }
@@ -99,8 +102,8 @@ void App::RefsReceived(BMessage *message)
     if (result == B_OK) {
         message->RemoveData(SEN_RELATION_PROPERTIES);
         message->Append(argsMsg);
-        printf("launch args message is:\n");
-        message->PrintToStream();
+        SLOG_DEBUG("launch args message is:\n");
+        SLOG_MESSAGE(SLOG_LEVEL_DEBUG, message);
     } else {
         if (result != B_NAME_NOT_FOUND) {
             BString error("Failed to map launch arguments!\nReason:\nDetail: ");
@@ -136,14 +139,14 @@ void App::RefsReceived(BMessage *message)
 
                 if (appFileInfo.InitCheck() == B_OK) {
                     if (appFileInfo.GetSignature(appSig) == B_OK) {
-                        printf("got MIME type '%s' for ref '%s'\n", appSig, appRef.name);
+                        SLOG_DEBUG("got MIME type '%s' for ref '%s'\n", appSig, appRef.name);
                         // send message to running instance for a more seamless experience
                         BMessenger appMess(appSig);
                         appMess.SendMessage(message);
                     }
                 }
             } else {
-                printf("failed to get MIME Type for ref %s: %s\n", appRef.name, strerror(result));
+                SLOG_ERROR("failed to get MIME Type for ref %s: %s\n", appRef.name, strerror(result));
             }
         }
     }
@@ -10,6 +10,7 @@
 
 #include "App.h"
 #include "Sen.h"
+#include "../../common/Log.h"
 
 const char* kApplicationSignature = "application/x-vnd.sen-labs.SenTextNavigator";
 
@@ -45,8 +46,8 @@ void App::RefsReceived(BMessage *message)
         return;
     }
 
-    LOG("got refs:");
-    message->PrintToStream();
+    LOG("got refs:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, message);
 
     status_t result;
     BMessage argsMsg;
@@ -76,7 +77,7 @@ void App::RefsReceived(BMessage *message)
     result = be_roster->FindApp(&ref, &appRef);
     if (result == B_OK) {
         LOG("sending args to app %s...\n", appRef.name);
-        message->PrintToStream();
+        SLOG_MESSAGE(SLOG_LEVEL_DEBUG, message);
 
         if (! be_roster->IsRunning(&appRef)) {
             result = be_roster->Launch(&appRef, message);
@@ -96,7 +97,7 @@ void App::RefsReceived(BMessage *message)
                     }
                 }
             } else {
-                LOG("failed to get MIME Type for ref %s: %s\n", appRef.name, strerror(result));
+                SLOG_ERROR("failed to get MIME Type for ref %s: %s\n", appRef.name, strerror(result));
             }
         }
     }
@@ -154,8 +155,8 @@ status_t App::MapRelationPropertiesToArguments(BMessage *message)
         message->AddInt32("be:selection_length", selectLen);          // StyledEdit and Pe
     }
 
-    LOG("mapped args:");
-    message->PrintToStream();
+    LOG("mapped args:\n");
+    SLOG_MESSAGE(SLOG_LEVEL_DEBUG, message);
 
     if (result == B_NAME_NOT_FOUND)
         result = B_OK;
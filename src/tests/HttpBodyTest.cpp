@@ -0,0 +1,282 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <Bitmap.h>
+#include <DataIO.h>
+#include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <Path.h>
+#include <TranslationUtils.h>
+#include <fs_attr.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include "Test.h"
+#include "../enrichment/HttpBody.h"
+#include "../enrichment/JsonDecoder.h"
+#include "../enrichment/Thumbnail.h"
+
+// larger than a search result and the usual cover, and not a multiple of any block size
+static const size_t kBodySize = 256 * 1024 + 100;
+static const size_t kChunkSize = 1460;
+static const int32 kImageSize = 256;
+
+static std::string BuildData(size_t size)
+{
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = 'a' + i % 26;
+    }
+    return data;
+}
+
+// a search response of about kBodySize, most of it in fields a projection skips
+static std::string BuildJson()
+{
+    std::string json = "{\"num_found\": 1000, \"docs\": [";
+    char doc[2048];
+    for (int32 i = 0; json.size() < kBodySize; i++) {
+        snprintf(doc, sizeof(doc), "%s{\"title\": \"Book %d\", \"first_sentence\": [\"%s\"]}",
+            i > 0 ? ", " : "", i, std::string(1024, 'a' + i % 26).c_str());
+        json += doc;
+    }
+    json += "]}";
+    return json;
+}
+
+static void AppendLE(std::string* data, uint32 value, int32 bytes)
+{
+    for (int32 i = 0; i < bytes; i++) {
+        data->push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+// an uncompressed 24 bit BMP, which every Haiku installation has a translator for
+static std::string BuildImage()
+{
+    uint32 imageBytes = kImageSize * kImageSize * 3;
+    std::string image = "BM";
+    AppendLE(&image, 54 + imageBytes, 4);
+    AppendLE(&image, 0, 4);
+    AppendLE(&image, 54, 4);
+    AppendLE(&image, 40, 4);
+    AppendLE(&image, kImageSize, 4);
+    AppendLE(&image, kImageSize, 4);
+    AppendLE(&image, 1, 2);
+    AppendLE(&image, 24, 2);
+    AppendLE(&image, 0, 4);
+    AppendLE(&image, imageBytes, 4);
+    AppendLE(&image, 2835, 4);
+    AppendLE(&image, 2835, 4);
+    AppendLE(&image, 0, 4);
+    AppendLE(&image, 0, 4);
+    for (int32 y = 0; y < kImageSize; y++) {
+        for (int32 x = 0; x < kImageSize; x++) {
+            image.push_back(x);
+            image.push_back(y);
+            image.push_back(x ^ y);
+        }
+    }
+    return image;
+}
+
+/**
+* the session writes into the buffer handed out by Receiver(), which has to become the body
+* without being copied.
+*/
+status_t TestHttpBodyReceive()
+{
+    std::string data = BuildData(kBodySize);
+    HttpBody body;
+    BExclusiveBorrow<BMallocIO>& receiver = body.Receiver();
+
+    for (size_t offset = 0; offset < data.size(); offset += kChunkSize) {
+        size_t length = std::min(kChunkSize, data.size() - offset);
+        if (receiver->Write(data.data() + offset, length) != (ssize_t)length) {
+            return TestCheck(false, "writing the response");
+        }
+    }
+
+    status_t result;
+    {
+        AllocationScope scope;
+        result = body.FinishReceive();
+        if (result == B_OK) {
+            result = TestCheck(scope.Count() == 0, "FinishReceive() allocates");
+        }
+    }
+    if (result == B_OK) {
+        result = TestCheck(body.Data() == static_cast<const char*>(receiver->Buffer()),
+            "body is not the receive buffer");
+    }
+    if (result == B_OK) {
+        result = TestCheck(body.Size() == data.size() && memcmp(body.Data(), data.data(), data.size()) == 0
+            && body.Data()[body.Size()] == '\0', "received body");
+    }
+    return result;
+}
+
+/**
+* bodies read from the cache are taken over with their buffer.
+*/
+status_t TestHttpBodyAdopt()
+{
+    std::string data = BuildData(kBodySize);
+    const char* buffer = data.data();
+    HttpBody body;
+
+    status_t result;
+    {
+        AllocationScope scope;
+        body.Adopt(data);
+        result = TestCheck(scope.Count() == 0, "Adopt() allocates");
+    }
+    if (result == B_OK) {
+        result = TestCheck(body.Data() == buffer && body.Size() == kBodySize && data.empty(),
+            "body is not the adopted buffer");
+    }
+    return result;
+}
+
+/**
+* a response handed to several waiting callers is shared, not copied for each.
+*/
+status_t TestHttpBodyShare()
+{
+    std::string data = BuildData(kBodySize);
+    std::shared_ptr<HttpBody> fetched = std::make_shared<HttpBody>();
+    fetched->Adopt(data);
+
+    HttpBody body;
+    status_t result;
+    {
+        AllocationScope scope;
+        body.Share(fetched);
+        result = TestCheck(scope.Count() == 0, "Share() allocates");
+    }
+    if (result == B_OK) {
+        result = TestCheck(body.Data() == fetched->Data() && body.Size() == fetched->Size(),
+            "body is not the shared buffer");
+    }
+    return result;
+}
+
+/**
+* JSON is decoded straight from the body, only the decoded values are allocated.
+*/
+status_t TestJsonDecoderInPlace()
+{
+    std::string json = BuildJson();
+    HttpBody body;
+    body.Adopt(json);
+
+    JsonProjection projection;
+    projection.AddPath("num_found");
+    projection.AddPath("docs/*/title");
+    JsonDecoder decoder(&projection);
+    BMessage message;
+
+    status_t result;
+    {
+        AllocationScope scope;
+        result = decoder.Decode(body.Data(), body.Size(), &message);
+        if (result == B_OK) {
+            result = TestCheck(scope.Largest() < body.Size(), "decoding copies the body");
+        }
+    }
+
+    BMessage docs;
+    BMessage doc;
+    if (result == B_OK) {
+        result = message.FindMessage("docs", &docs);
+    }
+    if (result == B_OK) {
+        result = docs.FindMessage("1", &doc);
+    }
+    if (result == B_OK) {
+        result = TestCheck(strcmp(doc.GetString("title", ""), "Book 1") == 0 && !doc.HasString("first_sentence")
+            && decoder.SkippedBytes() > 0, "decoded message");
+    }
+    return result;
+}
+
+/**
+* the thumbnail attribute is written straight from the body.
+*/
+status_t TestThumbnailWrite()
+{
+    std::string data = BuildImage();
+    HttpBody image;
+    image.Adopt(data);
+
+    BPath path;
+    status_t result = find_directory(B_SYSTEM_TEMP_DIRECTORY, &path);
+    if (result == B_OK) {
+        result = path.Append("sentest-thumbnail");
+    }
+    BFile file(path.Path(), B_CREATE_FILE | B_ERASE_FILE | B_WRITE_ONLY);
+    entry_ref ref;
+    if (result == B_OK) {
+        result = file.InitCheck();
+    }
+    if (result == B_OK) {
+        result = get_ref_for_path(path.Path(), &ref);
+    }
+    if (result != B_OK) {
+        return TestCheck(false, "creating the test file");
+    }
+
+    {
+        AllocationScope scope;
+        result = Thumbnail::Write(&ref, image);
+        if (result == B_OK) {
+            result = TestCheck(scope.Largest() < image.Size(), "writing the thumbnail copies the image");
+        }
+    }
+
+    BNode node(&ref);
+    attr_info info;
+    if (result == B_OK) {
+        result = node.GetAttrInfo(THUMBNAIL_ATTR_NAME, &info);
+    }
+    if (result == B_OK) {
+        std::string written(info.size, '\0');
+        ssize_t bytesRead = node.ReadAttr(THUMBNAIL_ATTR_NAME, B_RAW_TYPE, 0, &written[0], info.size);
+        result = TestCheck(bytesRead == (ssize_t)image.Size()
+            && memcmp(written.data(), image.Data(), image.Size()) == 0, "written thumbnail");
+    }
+
+    BEntry(path.Path()).Remove();
+    return result;
+}
+
+/**
+* covers are translated from the body through a BMemoryIO over its data.
+*/
+status_t TestTranslateInPlace()
+{
+    std::string data = BuildImage();
+    HttpBody image;
+    image.Adopt(data);
+
+    BBitmap* bitmap;
+    status_t result;
+    {
+        AllocationScope scope;
+        BMemoryIO memBuffer(image.Data(), image.Size());
+        bitmap = BTranslationUtils::GetBitmap(&memBuffer);
+        result = TestCheck(scope.Largest() < image.Size(), "translating copies the image");
+    }
+
+    if (result == B_OK) {
+        result = TestCheck(bitmap != NULL && bitmap->IsValid()
+            && bitmap->Bounds() == BRect(0, 0, kImageSize - 1, kImageSize - 1), "translated bitmap");
+    }
+    delete bitmap;
+    return result;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+
+#include "Test.h"
+
+// innermost scope of the current thread, other threads are not counted
+static thread_local AllocationScope* sScope = NULL;
+
+void CountAllocation(size_t size)
+{
+    for (AllocationScope* scope = sScope; scope != NULL; scope = scope->fOuter) {
+        scope->fCount++;
+        scope->fLargest = std::max(scope->fLargest, size);
+    }
+}
+
+AllocationScope::AllocationScope()
+    :
+    fOuter(sScope),
+    fCount(0),
+    fLargest(0)
+{
+    sScope = this;
+}
+
+AllocationScope::~AllocationScope()
+{
+    sScope = fOuter;
+}
+
+int64 AllocationScope::Count() const
+{
+    return fCount;
+}
+
+size_t AllocationScope::Largest() const
+{
+    return fLargest;
+}
+
+status_t TestCheck(bool condition, const char* what)
+{
+    if (!condition) {
+        printf("  FAILED: %s\n", what);
+        return B_ERROR;
+    }
+    return B_OK;
+}
+
+// replaces the global allocation functions of the whole process, including the libraries
+
+void* operator new(size_t size)
+{
+    CountAllocation(size);
+    void* memory = malloc(size > 0 ? size : 1);
+    if (memory == NULL) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    CountAllocation(size);
+    return malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
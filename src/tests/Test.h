@@ -0,0 +1,43 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ */
+#pragma once
+
+#include <SupportDefs.h>
+
+typedef status_t (*test_func)();
+
+/**
+* counts the operator new calls of the current thread while it exists, to check that data is
+* read in place instead of copied. Memory from malloc() and realloc(), which BMallocIO grows
+* its buffer with, is not counted.
+*/
+class AllocationScope {
+
+public:
+    AllocationScope();
+    ~AllocationScope();
+
+    int64       Count() const;
+    // size of the largest single allocation, a copy of a body shows up here
+    size_t      Largest() const;
+
+private:
+    AllocationScope*    fOuter;
+    int64               fCount;
+    size_t              fLargest;
+
+    friend void CountAllocation(size_t size);
+};
+
+// prints @what if @condition does not hold
+status_t    TestCheck(bool condition, const char* what);
+
+// the tests, each returns B_OK if all of its checks hold
+status_t    TestHttpBodyReceive();
+status_t    TestHttpBodyAdopt();
+status_t    TestHttpBodyShare();
+status_t    TestJsonDecoderInPlace();
+status_t    TestThumbnailWrite();
+status_t    TestTranslateInPlace();
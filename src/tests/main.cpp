@@ -0,0 +1,53 @@
+/*
+ * Copyright 2025, Gregor B. Rosenauer <gregor.rosenauer@gmail.com>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ * sentest - tests for the parts of the SEN plugins that have to hold without a network or
+ * a running system, starting with the response body pipeline, which must not copy bodies.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+
+#include "Test.h"
+#include "../common/Log.h"
+
+static const struct {
+    const char* name;
+    test_func   func;
+} kTests[] = {
+    { "HttpBody::Receiver",         TestHttpBodyReceive },
+    { "HttpBody::Adopt",            TestHttpBodyAdopt },
+    { "HttpBody::Share",            TestHttpBodyShare },
+    { "JsonDecoder in place",       TestJsonDecoderInPlace },
+    { "Thumbnail::Write",           TestThumbnailWrite },
+    { "BTranslationUtils in place", TestTranslateInPlace }
+};
+
+static const int32 kTestCount = sizeof(kTests) / sizeof(kTests[0]);
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        std::cerr << "Usage: sentest" << std::endl;
+        std::cerr << "runs all tests, exits with 1 if any of them failed." << std::endl;
+        return 1;
+    }
+
+    // logging allocates, and its output gets in the way
+    Logger::SetLevel(SLOG_LEVEL_WARN);
+
+    int32 failed = 0;
+    for (int32 i = 0; i < kTestCount; i++) {
+        status_t result = kTests[i].func();
+        printf("%-32s %s\n", kTests[i].name, result == B_OK ? "ok" : "FAILED");
+        if (result != B_OK) {
+            failed++;
+        }
+    }
+    printf("%" B_PRId32 " of %" B_PRId32 " tests failed\n", failed, kTestCount);
+
+    Logger::Shutdown();
+    return failed == 0 ? 0 : 1;
+}